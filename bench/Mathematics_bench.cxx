@@ -0,0 +1,1341 @@
+//
+// Created by Maksym Pasichnyk on 01.06.2024.
+//
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+import Mathematics;
+
+namespace bench {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        char const* filter = nullptr;
+        char const* json = nullptr;
+        double min_time = 0.05;
+        size_t samples = 5;
+        size_t count = 4096;
+        std::FILE* log = stdout;
+    };
+
+    struct result {
+        std::string name;
+        size_t elements;
+        size_t bytes;
+        double seconds;
+    };
+
+    options opts;
+    std::vector<result> results;
+    std::mt19937 rng{42};
+
+    // opaque to the optimizer, so the measured loop cannot be folded away
+    template<typename T>
+    inline void keep(T const& $1) {
+        asm volatile("" : : "r,m"($1) : "memory");
+    }
+
+    template<typename Fn>
+    inline auto time(size_t iterations, Fn& fn) -> double {
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; i += 1) {
+            fn();
+        }
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    // fn processes `elements` items touching `bytes` of memory per call; the fastest sample is kept
+    template<typename Fn>
+    void run(std::string const& name, size_t elements, size_t bytes, Fn fn) {
+        if (opts.filter != nullptr && name.find(opts.filter) == std::string::npos) {
+            return;
+        }
+        fn();
+
+        size_t iterations = 1;
+        while (time(iterations, fn) < opts.min_time) {
+            iterations *= 2;
+        }
+
+        double best = std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < opts.samples; i += 1) {
+            best = std::min(best, time(iterations, fn) / double(iterations));
+        }
+
+        result r{name, elements, bytes, best};
+        std::fprintf(opts.log, "%-36s %10.3f ns/op %12.4g elem/s %9.3f GB/s\n", r.name.c_str(), r.seconds * 1e9 / double(r.elements), double(r.elements) / r.seconds, double(r.bytes) / r.seconds * 1e-9);
+        results.push_back(r);
+    }
+
+    template<typename T>
+    auto random(T lo, T hi) -> T {
+        if constexpr (std::floating_point<T>) {
+            return std::uniform_real_distribution<T>{lo, hi}(rng);
+        } else {
+            return static_cast<T>(std::uniform_int_distribution<int64_t>{int64_t(lo), int64_t(hi)}(rng));
+        }
+    }
+
+    template<typename T, size_t Len>
+    auto random(T lo, T hi) -> std::vector<math::vec_t<T, Len>> {
+        std::vector<math::vec_t<T, Len>> out(opts.count);
+        for (auto& v : out) {
+            for (size_t i = 0; i < Len; i += 1) {
+                v[i] = random<T>(lo, hi);
+            }
+        }
+        return out;
+    }
+
+    template<typename T, size_t Cols, size_t Rows>
+    auto random_mat() -> std::vector<math::mat_t<T, Cols, Rows>> {
+        std::vector<math::mat_t<T, Cols, Rows>> out(opts.count);
+        for (auto& m : out) {
+            for (size_t c = 0; c < Cols; c += 1) {
+                for (size_t r = 0; r < Rows; r += 1) {
+                    m.__columns[c][r] = random<T>(T(-1), T(1)) + (c == r ? T(2) : T(0));
+                }
+            }
+        }
+        return out;
+    }
+
+    template<typename Out, typename In, typename Fn>
+    void unary(std::string const& name, std::vector<In> const& $1, Fn fn) {
+        std::vector<Out> out($1.size());
+        run(name, $1.size(), $1.size() * (sizeof(In) + sizeof(Out)), [&] {
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                out[i] = fn($1[i]);
+            }
+            keep(out.data());
+        });
+    }
+
+    template<typename Out, typename In, typename Fn>
+    void binary(std::string const& name, std::vector<In> const& $1, std::vector<In> const& $2, Fn fn) {
+        std::vector<Out> out($1.size());
+        run(name, $1.size(), $1.size() * (2 * sizeof(In) + sizeof(Out)), [&] {
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                out[i] = fn($1[i], $2[i]);
+            }
+            keep(out.data());
+        });
+    }
+
+    // every bit pattern of T, uniformly, which random(lo, hi) cannot produce for 64-bit lanes
+    template<std::integral T>
+    auto bits() -> T {
+        return static_cast<T>(uint64_t(rng()) << 32 | rng());
+    }
+
+    // divisors and dividends where multiply-high division tends to break: 1, every power of two,
+    // the extremes and their neighbours, negated for signed lanes, plus random bit patterns;
+    // 8- and 16-bit dividends are exhaustive
+    template<std::integral T>
+    auto edge_values(bool dividends) -> std::vector<T> {
+        using L = std::numeric_limits<T>;
+
+        std::vector<T> out{T(1), T(3), T(5), T(7), T(10), T(L::max()), T(L::max() - 1), T(L::min())};
+        for (int i = 1; i < L::digits; i += 1) {
+            T p = T(T(1) << i);
+            out.insert(out.end(), {p, T(p - 1), T(p + 1)});
+        }
+        if constexpr (std::is_signed_v<T>) {
+            using U = std::make_unsigned_t<T>;
+            for (size_t i = 0, n = out.size(); i < n; i += 1) {
+                out.push_back(T(U(0) - U(out[i])));
+            }
+        }
+        if (dividends && sizeof(T) <= 2) {
+            for (int64_t x = L::min(); x <= L::max(); x += 1) {
+                out.push_back(T(x));
+            }
+        } else {
+            for (size_t i = 0; i < 64; i += 1) {
+                out.push_back(bits<T>());
+            }
+        }
+        if (dividends) {
+            out.insert(out.end(), {T(0), T(L::min() + 1)});
+        } else {
+            std::erase(out, T(0));
+        }
+        return out;
+    }
+
+    // divisor<V> against the built-in operators: every divisor meets every dividend in every lane,
+    // next to different divisors in the other lanes. The reference runs on a wider type, where
+    // every pair is defined; T(min) / -1 then wraps back to min, as the built-in operator does for
+    // the promoted 8- and 16-bit lanes
+    template<std::integral T, size_t Len>
+    auto check_divisor(std::string const& alias) -> bool {
+        using V = math::vec_t<T, Len>;
+        using W = std::conditional_t<(sizeof(T) < 8), int64_t, __int128>;
+
+        std::vector<T> ds = edge_values<T>(false);
+        std::vector<T> xs = edge_values<T>(true);
+        size_t failures = 0;
+
+        auto fail = [&](char const* op, T x, T d, T got, T want) {
+            if (failures++ < 8) {
+                std::fprintf(stderr, "%s: %s(%lld, %lld) = %lld, expected %lld\n", alias.c_str(), op, (long long)x, (long long)d, (long long)got, (long long)want);
+            }
+        };
+
+        for (size_t k = 0; k < ds.size(); k += 1) {
+            V v;
+            for (size_t i = 0; i < Len; i += 1) {
+                v[i] = ds[(k + i * 17) % ds.size()];
+            }
+            math::divisor<V> d(v);
+            math::divisor<V> broadcast(v[0]);
+
+            for (size_t j = 0; j < xs.size(); j += 1) {
+                V x;
+                for (size_t i = 0; i < Len; i += 1) {
+                    x[i] = xs[(j + i * 31) % xs.size()];
+                }
+                V q = x / d;
+                V r = x % d;
+                V fq = math::floor_div(x, d);
+                V er = math::euclid_mod(x, d);
+                V bq = x / broadcast;
+                V br = x % broadcast;
+
+                for (size_t i = 0; i < Len; i += 1) {
+                    W n = W(x[i]);
+                    W m = W(v[i]);
+                    W wq = n / m;
+                    W wr = n % m;
+                    W wf = wq - W(wr != 0 && (wr < 0) != (m < 0));
+                    W we = wr < 0 ? wr + (m < 0 ? -m : m) : wr;
+
+                    if (q[i] != T(wq)) { fail("div", x[i], v[i], q[i], T(wq)); }
+                    if (r[i] != T(wr)) { fail("mod", x[i], v[i], r[i], T(wr)); }
+                    if (fq[i] != T(wf)) { fail("floor_div", x[i], v[i], fq[i], T(wf)); }
+                    if (er[i] != T(we)) { fail("euclid_mod", x[i], v[i], er[i], T(we)); }
+                    if (bq[i] != T(n / W(v[0]))) { fail("div", x[i], v[0], bq[i], T(n / W(v[0]))); }
+                    if (br[i] != T(n % W(v[0]))) { fail("mod", x[i], v[0], br[i], T(n % W(v[0]))); }
+                }
+            }
+        }
+        if (failures != 0) {
+            std::fprintf(stderr, "%s: %zu divisor mismatches\n", alias.c_str(), failures);
+        }
+        return failures == 0;
+    }
+
+    template<std::integral T>
+    auto check_divisors(std::string const& alias) -> bool {
+        return check_divisor<T, 1>(alias + "vec1")
+            & check_divisor<T, 2>(alias + "vec2")
+            & check_divisor<T, 3>(alias + "vec3")
+            & check_divisor<T, 4>(alias + "vec4");
+    }
+
+    // a chunk that throws on a worker or on the calling thread comes back out of run once every
+    // other chunk has finished, and the pool keeps working afterwards
+    auto check_parallel_errors() -> bool {
+        std::vector<uint32_t> in(1 << 20);
+        for (size_t i = 0; i < in.size(); i += 1) {
+            in[i] = uint32_t(i);
+        }
+        std::vector<uint32_t> out(in.size());
+        size_t failures = 0;
+
+        for (size_t bad : {size_t(0), in.size() / 2, in.size() - 1}) {
+            bool caught = false;
+            try {
+                math::parallel::transform(in, out, [&](uint32_t $1) {
+                    if ($1 == bad) {
+                        throw std::runtime_error("chunk");
+                    }
+                    return $1 + 1;
+                });
+            } catch (std::runtime_error const&) {
+                caught = true;
+            }
+            if (!caught) {
+                std::fprintf(stderr, "parallel: exception from element %zu was not rethrown\n", bad);
+                failures += 1;
+            }
+        }
+
+        bool caught = false;
+        try {
+            math::parallel::transform(in, std::span<uint32_t>(out).first(in.size() - 1), [](uint32_t $1) { return $1; });
+        } catch (std::length_error const&) {
+            caught = true;
+        }
+        if (!caught) {
+            std::fprintf(stderr, "parallel: short transform output was not rejected\n");
+            failures += 1;
+        }
+
+        uint64_t sum = math::parallel::transform_reduce(in, uint64_t(0), std::plus<>(), [](uint32_t $1) { return uint64_t($1); });
+        if (sum != uint64_t(in.size()) * (in.size() - 1) / 2) {
+            std::fprintf(stderr, "parallel: pool returned a wrong sum after a failed run\n");
+            failures += 1;
+        }
+        return failures == 0;
+    }
+
+    // cached_transform and cached_product against direct computation: no read after set() or after a
+    // copy sees the old value, a copy never shares a generation, and a product follows both of its sides
+    auto check_cached_transforms() -> bool {
+        using M = math::mat_t<float, 4, 4>;
+
+        M a = M{{{2, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 4, 0}, {1, 2, 3, 1}}};
+        M b = M{{{0, 1, 0, 0}, {-1, 0, 0, 0}, {0, 0, 1, 0}, {0, 0, -5, 1}}};
+        M c = M{{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, -1.02f, -1}, {0, 0, -0.2f, 0}}};
+        size_t failures = 0;
+
+        // mat_t has no operator==; the cache must return exactly what a direct computation does
+        auto same = [](M const& $1, M const& $2) {
+            return std::memcmp(&$1, &$2, sizeof(M)) == 0;
+        };
+        auto expect = [&](bool ok, char const* what) {
+            if (!ok) {
+                std::fprintf(stderr, "cached: %s\n", what);
+                failures += 1;
+            }
+        };
+
+        math::cached_transform<float> t(a);
+        expect(same(t.inverse(), math::inverse(a)), "inverse of the initial matrix");
+        t.set(b);
+        expect(same(t.inverse(), math::inverse(b)), "inverse read after set() returned the old matrix's");
+
+        math::cached_transform<float> copy = t;
+        expect(copy.generation() != t.generation(), "a copy shares its source's generation");
+        expect(same(copy.inverse(), math::inverse(b)), "a copy lost its source's matrix");
+        math::cached_transform<float> other(a);
+        uint64_t before = other.generation();
+        other = copy;
+        expect(other.generation() != before && other.generation() != copy.generation(), "assignment kept an old generation");
+        expect(same(other.inverse(), math::inverse(b)), "inverse read after assignment returned the old matrix's");
+
+        math::cached_transform<float> lens(c);
+        math::cached_transform<float> camera(a);
+        math::cached_product product(lens, camera);
+        math::cached_product nested(product, t);
+        expect(same(product.matrix(), c * a), "product of the initial sides");
+        expect(same(nested.matrix(), (c * a) * b), "nested product of the initial sides");
+        camera.set(b);
+        expect(same(product.matrix(), c * b), "product missed a write to its right side");
+        expect(same(nested.matrix(), (c * b) * b), "nested product missed a write under its left side");
+        lens = math::cached_transform<float>(a);
+        expect(same(product.matrix(), a * b), "product missed an assignment to its left side");
+        expect(same(product.inverse(), math::inverse(a * b)), "product inverse kept the old product");
+        // the old camera comes back by copy: a fresh generation, so the product cannot mistake it for the one it saw
+        math::cached_transform<float> saved(a);
+        camera = saved;
+        expect(same(nested.matrix(), (a * a) * b), "nested product missed an assignment under its left side");
+        return failures == 0;
+    }
+
+#define BENCH_OPERATOR(name, op)                                                                    \
+    binary<V>(alias + "." name, a, b, [](V const& $1, V const& $2) { return $1 op $2; });          \
+    binary<V>(alias + "." name "(v,s)", a, b, [s](V const& $1, V const&) { return $1 op s; });     \
+    binary<V>(alias + "." name "(s,v)", a, b, [s](V const&, V const& $2) { return s op $2; });
+
+    template<typename T, size_t Len>
+    void vec(std::string const& alias) {
+        using V = math::vec_t<T, Len>;
+
+        // divisors and shift counts stay in [1, 7] so every operator is defined for every alias
+        auto a = random<T, Len>(T(0), T(100));
+        auto b = random<T, Len>(T(1), T(7));
+        T s = T(3);
+
+        BENCH_OPERATOR("add", +)
+        BENCH_OPERATOR("sub", -)
+        BENCH_OPERATOR("mul", *)
+        BENCH_OPERATOR("div", /)
+        if constexpr (std::integral<T>) {
+            BENCH_OPERATOR("mod", %)
+            BENCH_OPERATOR("shl", <<)
+            BENCH_OPERATOR("shr", >>)
+            BENCH_OPERATOR("and", &)
+            BENCH_OPERATOR("or", |)
+            BENCH_OPERATOR("xor", ^)
+
+            // one divisor for every element, as in chunk and tile index math
+            V v = b[0];
+            math::divisor<V> d(v);
+            unary<V>(alias + ".div(invariant)", a, [v](V const& $1) { return $1 / v; });
+            unary<V>(alias + ".div(divisor)", a, [d](V const& $1) { return $1 / d; });
+            unary<V>(alias + ".mod(divisor)", a, [d](V const& $1) { return $1 % d; });
+            unary<V>(alias + ".floor_div", a, [d](V const& $1) { return math::floor_div($1, d); });
+            unary<V>(alias + ".euclid_mod", a, [d](V const& $1) { return math::euclid_mod($1, d); });
+        }
+        binary<T>(alias + ".dot", a, b, [](V const& $1, V const& $2) { return math::dot($1, $2); });
+        binary<V>(alias + ".min", a, b, [](V const& $1, V const& $2) { return math::min($1, $2); });
+        binary<V>(alias + ".max", a, b, [](V const& $1, V const& $2) { return math::max($1, $2); });
+        binary<math::mask_t<T, Len>>(alias + ".lessThan", a, b, [](V const& $1, V const& $2) { return math::lessThan($1, $2); });
+        binary<math::mask_t<T, Len>>(alias + ".equal", a, b, [](V const& $1, V const& $2) { return math::equal($1, $2); });
+        binary<V>(alias + ".select", a, b, [](V const& $1, V const& $2) { return math::select(math::lessThan($1, $2), $1, $2); });
+        binary<V>(alias + ".clamp", a, b, [](V const& $1, V const& $2) { return math::clamp($1, $2, $2 + $2); });
+        binary<V>(alias + ".step", a, b, [](V const& $1, V const& $2) { return math::step($2, $1); });
+        binary<uint32_t>(alias + ".movemask", a, b, [](V const& $1, V const& $2) { return math::movemask(math::lessThan($1, $2)); });
+        unary<T>(alias + ".csum", a, [](V const& $1) { return math::csum($1); });
+        unary<V>(alias + ".sign", a, [](V const& $1) { return math::sign($1); });
+        if constexpr (std::floating_point<T>) {
+            unary<V>(alias + ".abs", a, [](V const& $1) { return math::abs($1); });
+            unary<V>(alias + ".floor", a, [](V const& $1) { return math::floor($1); });
+            unary<V>(alias + ".ceil", a, [](V const& $1) { return math::ceil($1); });
+            unary<V>(alias + ".round", a, [](V const& $1) { return math::round($1); });
+            unary<V>(alias + ".fract", a, [](V const& $1) { return math::fract($1); });
+            unary<V>(alias + ".sqrt", a, [](V const& $1) { return math::sqrt($1); });
+            unary<V>(alias + ".sin", a, [](V const& $1) { return math::sin($1); });
+            unary<V>(alias + ".cos", a, [](V const& $1) { return math::cos($1); });
+            unary<T>(alias + ".length", a, [](V const& $1) { return math::length($1); });
+            binary<V>(alias + ".mix", a, b, [](V const& $1, V const& $2) { return math::mix($1, $2, T(0.25)); });
+            unary<V>(alias + ".normalize", a, [](V const& $1) { return math::normalize($1); });
+            unary<V>(alias + ".normalize_fast", a, [](V const& $1) { return math::normalize_fast($1); });
+            binary<V>(alias + ".madd", a, b, [](V const& $1, V const& $2) { return $1 * $2 + $1; });
+            binary<V>(alias + ".lazy_madd", a, b, [](V const& $1, V const& $2) -> V { return math::lazy($1) * $2 + $1; });
+            if constexpr (Len == 3 || Len == 4) {
+                std::vector<V> out(a.size());
+                run(alias + ".normalize_all", a.size(), a.size() * 2 * sizeof(V), [&] {
+                    math::normalize_all(a, out);
+                    keep(out.data());
+                });
+            }
+        }
+
+        if constexpr (Len == 2) {
+            unary<V>(alias + ".swizzle_get", a, [](V const& $1) { return $1.yx; });
+            unary<V>(alias + ".swizzle_put", a, [](V $1) { $1.yx = $1.xy; return $1; });
+            binary<math::vec_t<T, 3>>(alias + ".vec3(v,s)", a, b, [s](V const& $1, V const&) { return math::vec3($1, s); });
+            binary<math::vec_t<T, 4>>(alias + ".vec4(v,v)", a, b, [](V const& $1, V const& $2) { return math::vec4($1, $2); });
+        }
+        if constexpr (Len == 3) {
+            unary<V>(alias + ".swizzle_get", a, [](V const& $1) { return $1.zxy; });
+            unary<V>(alias + ".swizzle_put", a, [](V $1) { $1.zxy = $1.xyz; return $1; });
+            binary<math::vec_t<T, 4>>(alias + ".vec4(v,s)", a, b, [s](V const& $1, V const&) { return math::vec4($1, s); });
+        }
+        if constexpr (Len == 4) {
+            unary<V>(alias + ".swizzle_get", a, [](V const& $1) { return $1.wzyx; });
+            unary<V>(alias + ".swizzle_put", a, [](V $1) { $1.wzyx = $1.xyzw; return $1; });
+            binary<math::vec_t<T, 3>>(alias + ".vec3(v.xy,s)", a, b, [s](V const& $1, V const&) { return math::vec3($1.xy, s); });
+        }
+    }
+
+#undef BENCH_OPERATOR
+
+    template<typename T, size_t N>
+    void mat(std::string const& alias) {
+        using M = math::mat_t<T, N, N>;
+        using V = math::vec_t<T, N>;
+
+        auto a = random_mat<T, N, N>();
+        auto b = random_mat<T, N, N>();
+        auto v = random<T, N>(T(-1), T(1));
+
+        binary<M>(alias + ".mul", a, b, [](M const& $1, M const& $2) { return $1 * $2; });
+        std::vector<V> out(a.size());
+        run(alias + ".mul(m,v)", a.size(), a.size() * (sizeof(M) + 2 * sizeof(V)), [&] {
+            for (size_t i = 0; i < a.size(); i += 1) {
+                out[i] = a[i] * v[i];
+            }
+            keep(out.data());
+        });
+        unary<M>(alias + ".transpose", a, [](M const& $1) { return math::transpose($1); });
+        if constexpr (N == 4) {
+            binary<M>(alias + ".mul_transpose", a, b, [](M const& $1, M const& $2) { return math::mul_transpose($1, $2); });
+            unary<M>(alias + ".inverse", a, [](M const& $1) { return math::inverse($1); });
+            unary<M>(alias + ".inverse_affine", a, [](M const& $1) { return math::inverse_affine($1); });
+            unary<M>(alias + ".inverse_rigid", a, [](M const& $1) { return math::inverse_rigid($1); });
+        }
+    }
+
+    // span encode/decode; bytes count the float side plus the packed side
+    template<typename P, size_t Len>
+    void packed(std::string const& alias) {
+        using V = math::vec_t<float, Len>;
+
+        auto a = random<float, Len>(-1.0f, 1.0f);
+        std::vector<P> p(a.size());
+        std::vector<V> out(a.size());
+        size_t bytes = a.size() * (sizeof(V) + sizeof(P));
+
+        run(alias + ".pack", a.size(), bytes, [&] {
+            math::pack<P>(a, p);
+            keep(p.data());
+        });
+        run(alias + ".unpack", a.size(), bytes, [&] {
+            math::unpack<P>(p, out);
+            keep(out.data());
+        });
+    }
+
+    // a * b + c * d - e over SoA streams: eager passes with temporaries against one fused lazy pass
+    template<typename T, size_t Len>
+    void lazy(std::string const& alias) {
+        using S = math::vec_soa<T, Len>;
+
+        S a, b, c, d, e, t0, t1, out;
+        a.assign(random<T, Len>(T(-1), T(1)));
+        b.assign(random<T, Len>(T(-1), T(1)));
+        c.assign(random<T, Len>(T(-1), T(1)));
+        d.assign(random<T, Len>(T(-1), T(1)));
+        e.assign(random<T, Len>(T(-1), T(1)));
+        size_t bytes = a.size() * 6 * sizeof(math::vec_t<T, Len>);
+
+        run(alias + ".soa_eager", a.size(), bytes, [&] {
+            math::mul(a, b, t0);
+            math::mul(c, d, t1);
+            math::add(t0, t1, out);
+            math::sub(out, e, out);
+            keep(out.stream(0).data());
+        });
+        run(alias + ".soa_lazy", a.size(), bytes, [&] {
+            math::eval(math::lazy(a) * b + math::lazy(c) * d - e, out);
+            keep(out.stream(0).data());
+        });
+    }
+
+    // rotation-only composition and skinning-style batches; the mat rows are the 3x3 equivalents
+    template<typename T>
+    void quat(std::string const& alias) {
+        using Q = math::quat_t<T>;
+        using V = math::vec_t<T, 3>;
+        using M = math::mat_t<T, 3, 3>;
+
+        auto axes = random<T, 3>(T(-1), T(1));
+        auto a = std::vector<Q>(opts.count);
+        auto b = std::vector<Q>(opts.count);
+        for (size_t i = 0; i < opts.count; i += 1) {
+            a[i] = math::angleAxis(random(T(-3), T(3)), math::normalize(axes[i] + V{T(0), T(0), T(2)}));
+            b[i] = math::angleAxis(random(T(-3), T(3)), math::normalize(axes[opts.count - 1 - i] + V{T(2), T(0), T(0)}));
+        }
+        auto ma = std::vector<M>(opts.count);
+        for (size_t i = 0; i < opts.count; i += 1) {
+            ma[i] = math::mat3x3(a[i]);
+        }
+        auto v = random<T, 3>(T(-1), T(1));
+
+        binary<Q>(alias + ".mul", a, b, [](Q const& $1, Q const& $2) { return $1 * $2; });
+        binary<M>(alias + ".mul(mat3x3)", ma, ma, [](M const& $1, M const& $2) { return $1 * $2; });
+        binary<Q>(alias + ".nlerp", a, b, [](Q const& $1, Q const& $2) { return math::nlerp($1, $2, T(0.3)); });
+        binary<Q>(alias + ".slerp", a, b, [](Q const& $1, Q const& $2) { return math::slerp($1, $2, T(0.3)); });
+        unary<M>(alias + ".mat3x3", a, [](Q const& $1) { return math::mat3x3($1); });
+        unary<Q>(alias + ".from_mat3x3", ma, [](M const& $1) { return math::quat($1); });
+
+        std::vector<V> out(opts.count);
+        run(alias + ".rotate", opts.count, opts.count * (sizeof(Q) + 2 * sizeof(V)), [&] {
+            for (size_t i = 0; i < opts.count; i += 1) {
+                out[i] = a[i] * v[i];
+            }
+            keep(out.data());
+        });
+        run(alias + ".rotate_all", opts.count, opts.count * (sizeof(Q) + 2 * sizeof(V)), [&] {
+            math::rotate(a, v, out);
+            keep(out.data());
+        });
+        std::vector<Q> blend(opts.count);
+        run(alias + ".slerp_all", opts.count, opts.count * 3 * sizeof(Q), [&] {
+            math::slerp(a, b, T(0.3), blend);
+            keep(blend.data());
+        });
+    }
+
+    // the mat rows run the same transforms through mat_t<T, 4, 4> for comparison
+    template<typename T>
+    void affine(std::string const& alias) {
+        using A = math::affine_t<T>;
+        using M = math::mat_t<T, 4, 4>;
+        using V = math::vec_t<T, 3>;
+
+        auto m = random_mat<T, 4, 4>();
+        for (M& x : m) {
+            x.__columns[0][3] = T(0);
+            x.__columns[1][3] = T(0);
+            x.__columns[2][3] = T(0);
+            x.__columns[3][3] = T(1);
+        }
+        auto a = std::vector<A>(m.size());
+        for (size_t i = 0; i < m.size(); i += 1) {
+            a[i] = math::affine(m[i]);
+        }
+        auto v = random<T, 3>(T(-1), T(1));
+
+        binary<A>(alias + ".mul", a, a, [](A const& $1, A const& $2) { return $1 * $2; });
+        binary<M>(alias + ".mul(mat4x4)", m, m, [](M const& $1, M const& $2) { return $1 * $2; });
+        unary<A>(alias + ".inverse", a, [](A const& $1) { return math::inverse($1); });
+        unary<M>(alias + ".inverse(mat4x4)", m, [](M const& $1) { return math::inverse_affine($1); });
+        unary<M>(alias + ".mat4x4", a, [](A const& $1) { return math::mat4x4($1); });
+
+        std::vector<V> out(v.size());
+        run(alias + ".transform_point", v.size(), v.size() * (sizeof(A) + 2 * sizeof(V)), [&] {
+            for (size_t i = 0; i < v.size(); i += 1) {
+                out[i] = math::transform_point(a[i], v[i]);
+            }
+            keep(out.data());
+        });
+    }
+
+    template<typename T, size_t Len>
+    void reduce(std::string const& alias) {
+        using V = math::vec_t<T, Len>;
+
+        auto v = std::vector<V>(opts.count * 16);
+        for (V& x : v) {
+            for (size_t k = 0; k < Len; k += 1) {
+                x[k] = random(T(-1), T(1));
+            }
+        }
+        std::span<V const> s(v);
+        size_t bytes = v.size() * sizeof(V);
+
+        run(alias + ".bounds(loop)", v.size(), bytes, [&] {
+            V lo = v[0];
+            V hi = v[0];
+            for (V const& x : v) {
+                lo = math::min(lo, x);
+                hi = math::max(hi, x);
+            }
+            keep(lo);
+            keep(hi);
+        });
+        run(alias + ".bounds", v.size(), bytes, [&] {
+            keep(math::bounds(s));
+        });
+        run(alias + ".sum(loop)", v.size(), bytes, [&] {
+            V acc{};
+            for (V const& x : v) {
+                acc = acc + x;
+            }
+            keep(acc);
+        });
+        run(alias + ".sum", v.size(), bytes, [&] {
+            keep(math::sum(s));
+        });
+        run(alias + ".sum(kahan)", v.size(), bytes, [&] {
+            keep(math::sum(s, math::summation::kahan));
+        });
+        run(alias + ".centroid", v.size(), bytes, [&] {
+            keep(math::centroid(s));
+        });
+    }
+
+    // cell coordinates below 1024 per axis; sort rows copy the unsorted input back every iteration
+    template<typename T, size_t Len>
+    void morton(std::string const& alias) {
+        using V = math::vec_t<T, Len>;
+        using P = math::vec_t<float, 3>;
+        using K = math::morton_key_t<T, Len>;
+
+        size_t count = opts.count * 16;
+        auto cells = std::vector<V>(count);
+        auto points = std::vector<P>(count);
+        for (size_t i = 0; i < count; i += 1) {
+            for (size_t k = 0; k < Len; k += 1) {
+                cells[i][k] = random(T(0), T(1023));
+            }
+            points[i] = P{random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(-1.0f, 1.0f)};
+        }
+        auto keys = std::vector<K>(count);
+        math::morton_encode(cells, keys);
+
+        run(alias + ".morton_encode", count, count * (sizeof(V) + sizeof(K)), [&] {
+            for (size_t i = 0; i < count; i += 1) {
+                keys[i] = math::morton_encode(cells[i]);
+            }
+            keep(keys.data());
+        });
+        run(alias + ".morton_encode(span)", count, count * (sizeof(V) + sizeof(K)), [&] {
+            math::morton_encode(cells, keys);
+            keep(keys.data());
+        });
+        run(alias + ".morton_decode", count, count * (sizeof(V) + sizeof(K)), [&] {
+            V acc{};
+            for (K key : keys) {
+                acc = acc ^ math::morton_decode<T, Len>(key);
+            }
+            keep(acc);
+        });
+
+        auto sorted_cells = cells;
+        auto sorted_points = points;
+        run(alias + ".morton_sort(stable_sort)", count, count * (sizeof(V) + sizeof(P)), [&] {
+            sorted_cells = cells;
+            std::stable_sort(sorted_cells.begin(), sorted_cells.end(), [](V const& $1, V const& $2) {
+                return math::morton_encode($1) < math::morton_encode($2);
+            });
+            keep(sorted_cells.data());
+        });
+        run(alias + ".morton_sort", count, count * (sizeof(V) + sizeof(P)), [&] {
+            sorted_cells = cells;
+            sorted_points = points;
+            math::morton_sort(sorted_cells, sorted_points);
+            keep(sorted_cells.data());
+            keep(sorted_points.data());
+        });
+    }
+
+    // chunk coordinates of a voxel world; lookups hit in random order, half of the probes in the miss row are absent
+    void hash_map() {
+        using K = math::vec_t<int32_t, 3>;
+
+        size_t count = opts.count * 64;
+        auto keys = std::vector<K>(count);
+        for (size_t i = 0; i < count; i += 1) {
+            keys[i] = K{int32_t(i % 64) - 32, int32_t(i / 64 % 64) - 32, int32_t(i / 4096)};
+        }
+        std::shuffle(keys.begin(), keys.end(), rng);
+        auto misses = keys;
+        for (size_t i = 0; i < count; i += 2) {
+            misses[i][2] = -misses[i][2] - 1;
+        }
+
+        std::map<K, uint32_t> tree;
+        std::unordered_map<K, uint32_t> node;
+        math::flat_map<K, uint32_t> flat;
+        for (size_t i = 0; i < count; i += 1) {
+            tree.emplace(keys[i], uint32_t(i));
+            node.emplace(keys[i], uint32_t(i));
+            flat.insert(keys[i], uint32_t(i));
+        }
+        std::shuffle(keys.begin(), keys.end(), rng);
+        std::shuffle(misses.begin(), misses.end(), rng);
+        auto found = std::vector<uint32_t*>(count);
+        size_t bytes = count * sizeof(K);
+
+        run("hash_map.i32vec3.insert(std::unordered_map)", count, bytes, [&] {
+            std::unordered_map<K, uint32_t> map;
+            for (size_t i = 0; i < count; i += 1) {
+                map.emplace(keys[i], uint32_t(i));
+            }
+            keep(map.size());
+        });
+        run("hash_map.i32vec3.insert", count, bytes, [&] {
+            math::flat_map<K, uint32_t> map;
+            for (size_t i = 0; i < count; i += 1) {
+                map.insert(keys[i], uint32_t(i));
+            }
+            keep(map.size());
+        });
+        run("hash_map.i32vec3.find(std::map)", count, bytes, [&] {
+            uint32_t sum = 0;
+            for (K const& k : keys) {
+                sum += tree.find(k)->second;
+            }
+            keep(sum);
+        });
+        run("hash_map.i32vec3.find(std::unordered_map)", count, bytes, [&] {
+            uint32_t sum = 0;
+            for (K const& k : keys) {
+                sum += node.find(k)->second;
+            }
+            keep(sum);
+        });
+        run("hash_map.i32vec3.find", count, bytes, [&] {
+            uint32_t sum = 0;
+            for (K const& k : keys) {
+                sum += *flat.find(k);
+            }
+            keep(sum);
+        });
+        run("hash_map.i32vec3.find(span)", count, bytes, [&] {
+            flat.find(std::span<K const>(keys), std::span<uint32_t*>(found));
+            keep(found.data());
+        });
+        run("hash_map.i32vec3.find_miss(std::unordered_map)", count, bytes, [&] {
+            size_t hits = 0;
+            for (K const& k : misses) {
+                hits += node.contains(k);
+            }
+            keep(hits);
+        });
+        run("hash_map.i32vec3.find_miss", count, bytes, [&] {
+            size_t hits = 0;
+            for (K const& k : misses) {
+                hits += flat.contains(k);
+            }
+            keep(hits);
+        });
+    }
+
+    // a 256x256 height field (131072 triangles) seen from above; coherent rays come from a camera grid,
+    // incoherent ones from random points in random downward directions
+    void rays() {
+        using V = math::vec_t<float, 3>;
+
+        size_t side = 256;
+        auto grid = std::vector<V>();
+        for (size_t y = 0; y <= side; y += 1) {
+            for (size_t x = 0; x <= side; x += 1) {
+                grid.push_back(V{float(x), std::sin(float(x) * 0.1f) * std::cos(float(y) * 0.07f) * 8.0f + random(0.0f, 0.5f), float(y)});
+            }
+        }
+        auto vertices = std::vector<V>();
+        for (size_t y = 0; y < side; y += 1) {
+            for (size_t x = 0; x < side; x += 1) {
+                size_t a = y * (side + 1) + x;
+                for (size_t i : {a, a + 1, a + side + 1, a + 1, a + side + 2, a + side + 1}) {
+                    vertices.push_back(grid[i]);
+                }
+            }
+        }
+        size_t triangles = vertices.size() / 3;
+        std::span<V const> mesh(vertices);
+
+        auto coherent = std::vector<math::ray>();
+        for (size_t y = 0; y < 256; y += 1) {
+            for (size_t x = 0; x < 256; x += 1) {
+                V target{float(x), 0.0f, float(y)};
+                V origin{128.0f, 64.0f, -64.0f};
+                coherent.push_back(math::ray{origin, math::normalize(target - origin)});
+            }
+        }
+        auto incoherent = std::vector<math::ray>(coherent.size());
+        for (math::ray& r : incoherent) {
+            r = math::ray{V{random(0.0f, 256.0f), 20.0f, random(0.0f, 256.0f)}, math::normalize(V{random(-1.0f, 1.0f), -1.0f, random(-1.0f, 1.0f)})};
+        }
+        auto hits = std::vector<math::ray_hit>(coherent.size());
+
+        math::parallel::thread_pool one(1);
+        run("ray.bvh.build(serial)", triangles, triangles * 3 * sizeof(V), [&] {
+            keep(math::bvh(mesh, one).__nodes.data());
+        });
+        run("ray.bvh.build", triangles, triangles * 3 * sizeof(V), [&] {
+            keep(math::bvh(mesh).__nodes.data());
+        });
+
+        math::bvh tree(mesh);
+        run("ray.bvh.intersect", coherent.size(), 0, [&] {
+            for (size_t i = 0; i < coherent.size(); i += 1) {
+                hits[i] = tree.intersect(coherent[i]);
+            }
+            keep(hits.data());
+        });
+        run("ray.bvh.intersect(packet)", coherent.size(), 0, [&] {
+            tree.intersect(std::span<math::ray const>(coherent), std::span<math::ray_hit>(hits));
+            keep(hits.data());
+        });
+        run("ray.bvh.intersect(incoherent)", incoherent.size(), 0, [&] {
+            for (size_t i = 0; i < incoherent.size(); i += 1) {
+                hits[i] = tree.intersect(incoherent[i]);
+            }
+            keep(hits.data());
+        });
+
+        // 1024 triangles against one ray: a scalar Möller–Trumbore on vec_t against the SoA kernel
+        std::span<V const> patch = mesh.subspan(0, 1024 * 3);
+        math::triangle_soa soa(patch);
+        math::ray probe = coherent[0];
+        run("ray.triangles.intersect(loop)", 1024, patch.size_bytes(), [&] {
+            float best = probe.__tmax;
+            for (size_t t = 0; t < 1024; t += 1) {
+                V e1 = patch[t * 3 + 1] - patch[t * 3];
+                V e2 = patch[t * 3 + 2] - patch[t * 3];
+                V p = math::cross(probe.__direction, e2);
+                float det = math::dot(e1, p);
+                if (std::abs(det) < 1e-12f) {
+                    continue;
+                }
+                V s = probe.__origin - patch[t * 3];
+                float u = math::dot(s, p) / det;
+                V q = math::cross(s, e1);
+                float v = math::dot(probe.__direction, q) / det;
+                float d = math::dot(e2, q) / det;
+                if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && d > probe.__tmin && d < best) {
+                    best = d;
+                }
+            }
+            keep(best);
+        });
+        run("ray.triangles.intersect", 1024, patch.size_bytes(), [&] {
+            keep(math::intersect(probe, soa));
+        });
+
+        // one box against packets of eight rays
+        auto boxes = std::vector<math::bounds_t<float, 3>>(1024);
+        for (math::bounds_t<float, 3>& box : boxes) {
+            V lo{random(0.0f, 240.0f), random(-8.0f, 0.0f), random(0.0f, 240.0f)};
+            box = math::bounds_t<float, 3>{lo, lo + V{16.0f, 8.0f, 16.0f}};
+        }
+        math::ray_packet packet(std::span<math::ray const>(coherent).subspan(0, 8));
+        run("ray.packet.bounds(loop)", boxes.size() * 8, 0, [&] {
+            uint32_t any = 0;
+            for (math::bounds_t<float, 3> const& box : boxes) {
+                for (size_t i = 0; i < 8; i += 1) {
+                    math::ray const& r = coherent[i];
+                    V t0 = (box.__min - r.__origin) / r.__direction;
+                    V t1 = (box.__max - r.__origin) / r.__direction;
+                    V lo = math::min(t0, t1);
+                    V hi = math::max(t0, t1);
+                    float near = std::max(std::max(lo[0], lo[1]), std::max(lo[2], r.__tmin));
+                    float far = std::min(std::min(hi[0], hi[1]), std::min(hi[2], r.__tmax));
+                    any |= uint32_t(near <= far) << i;
+                }
+            }
+            keep(any);
+        });
+        run("ray.packet.bounds", boxes.size() * 8, 0, [&] {
+            uint32_t any = 0;
+            for (math::bounds_t<float, 3> const& box : boxes) {
+                any |= math::intersect(packet, box);
+            }
+            keep(any);
+        });
+    }
+
+    // 512K objects scattered around a 90 degree camera, about a fifth of them visible
+    void culling() {
+        using V = math::vec_t<float, 3>;
+        using M = math::mat_t<float, 4, 4>;
+
+        size_t count = 512 * 1024;
+        auto centers = std::vector<V>(count);
+        auto extents = std::vector<V>(count);
+        auto radii = std::vector<float>(count);
+        for (size_t i = 0; i < count; i += 1) {
+            centers[i] = V{random(-500.0f, 500.0f), random(-500.0f, 500.0f), random(-500.0f, 500.0f)};
+            extents[i] = V{random(0.5f, 4.0f), random(0.5f, 4.0f), random(0.5f, 4.0f)};
+            radii[i] = random(0.5f, 4.0f);
+        }
+        float n = 0.1f;
+        float f = 1000.0f;
+        M projection = M{{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, -(f + n) / (f - n), -1}, {0, 0, -2 * f * n / (f - n), 0}}};
+        auto visible = std::vector<uint32_t>(count);
+        auto words = std::vector<uint64_t>((count + 63) / 64);
+        std::span<V const> c(centers);
+        std::span<V const> e(extents);
+
+        run("cull.extract_frustum_planes", 1, sizeof(M), [&] {
+            keep(math::extract_frustum_planes(projection));
+        });
+        math::frustum_t<float> frustum = math::extract_frustum_planes(projection);
+        run("cull.aabbs(loop)", count, count * 2 * sizeof(V), [&] {
+            size_t k = 0;
+            for (size_t i = 0; i < count; i += 1) {
+                bool inside = true;
+                for (math::vec_t<float, 4> const& p : frustum.__planes) {
+                    float d = p[0] * centers[i][0] + p[1] * centers[i][1] + p[2] * centers[i][2] + p[3];
+                    float r = std::abs(p[0]) * extents[i][0] + std::abs(p[1]) * extents[i][1] + std::abs(p[2]) * extents[i][2];
+                    if (d + r < 0.0f) {
+                        inside = false;
+                        break;
+                    }
+                }
+                if (inside) {
+                    visible[k++] = uint32_t(i);
+                }
+            }
+            keep(k);
+        });
+        run("cull.aabbs", count, count * 2 * sizeof(V), [&] {
+            keep(math::cull_aabbs(frustum, c, e, std::span<uint32_t>(visible)));
+        });
+        run("cull.aabbs(mask)", count, count * 2 * sizeof(V), [&] {
+            math::cull_aabbs(frustum, c, e, std::span<uint64_t>(words));
+            keep(words.data());
+        });
+        run("cull.aabbs(parallel)", count, count * 2 * sizeof(V), [&] {
+            keep(math::parallel::cull_aabbs(frustum, c, e, std::span<uint32_t>(visible)));
+        });
+        run("cull.spheres", count, count * (sizeof(V) + sizeof(float)), [&] {
+            keep(math::cull_spheres(frustum, c, std::span<float const>(radii), std::span<uint32_t>(visible)));
+        });
+        run("cull.spheres(parallel)", count, count * (sizeof(V) + sizeof(float)), [&] {
+            keep(math::parallel::cull_spheres(frustum, c, std::span<float const>(radii), std::span<uint32_t>(visible)));
+        });
+    }
+
+    // 64K nodes under random earlier parents, against a node-per-allocation tree updated recursively
+    void hierarchy() {
+        using M = math::mat_t<float, 4, 4>;
+
+        struct node {
+            M local;
+            M world;
+            std::vector<node*> children;
+
+            void update(M const& $1) {
+                world = $1 * local;
+                for (node* child : children) {
+                    child->update(world);
+                }
+            }
+        };
+
+        size_t count = 64 * 1024;
+        M identity = M{{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
+        auto nodes = std::vector<std::unique_ptr<node>>();
+        auto parents = std::vector<uint32_t>();
+        math::transform_hierarchy<float> tree;
+        for (size_t i = 0; i < count; i += 1) {
+            M local = M{{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(-1.0f, 1.0f), 1}}};
+            uint32_t parent = i < 16 ? math::transform_hierarchy<float>::none : uint32_t(random(0.0f, float(i) - 0.5f));
+            nodes.push_back(std::make_unique<node>(node{local, local, {}}));
+            if (parent != math::transform_hierarchy<float>::none) {
+                nodes[parent]->children.push_back(nodes.back().get());
+            }
+            parents.push_back(parent);
+            tree.add(local, parent);
+        }
+        tree.update();
+
+        run("hierarchy.update(pointer tree)", count, count * 2 * sizeof(M), [&] {
+            for (size_t i = 0; i < 16; i += 1) {
+                nodes[i]->update(identity);
+            }
+            keep(nodes[count - 1]->world);
+        });
+        math::parallel::thread_pool one(1);
+        run("hierarchy.update(serial)", count, count * 2 * sizeof(M), [&] {
+            for (uint32_t i = 0; i < 16; i += 1) {
+                tree.set_local(i, tree.local(i));
+            }
+            keep(tree.update(one));
+        });
+        run("hierarchy.update", count, count * 2 * sizeof(M), [&] {
+            for (uint32_t i = 0; i < 16; i += 1) {
+                tree.set_local(i, tree.local(i));
+            }
+            keep(tree.update());
+        });
+        // one node in a thousand moved, anywhere in the tree
+        run("hierarchy.update(sparse)", count, count * 2 * sizeof(M), [&] {
+            for (uint32_t i = 0; i < count / 1024; i += 1) {
+                uint32_t handle = uint32_t((i * 1021 + 7) % count);
+                tree.set_local(handle, tree.local(handle));
+            }
+            keep(tree.update());
+        });
+    }
+
+    // repeated reads of one camera between writes: recomputing every time against the cached value
+    void cached() {
+        using M = math::mat_t<float, 4, 4>;
+
+        size_t reads = 1024;
+        M model = M{{{2, 0, 0, 0}, {0, 3, 0, 0}, {0.5f, 0, 4, 0}, {1, 2, 3, 1}}};
+        M view = M{{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, -5, 1}}};
+        M projection = M{{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, -1.02f, -1}, {0, 0, -0.2f, 0}}};
+
+        run("cached.inverse(recompute)", reads, 0, [&] {
+            for (size_t i = 0; i < reads; i += 1) {
+                keep(math::inverse(model));
+            }
+        });
+        math::cached_transform<float> transform(model);
+        run("cached.inverse", reads, 0, [&] {
+            for (size_t i = 0; i < reads; i += 1) {
+                keep(transform.inverse());
+            }
+        });
+        run("cached.normal_matrix", reads, 0, [&] {
+            for (size_t i = 0; i < reads; i += 1) {
+                keep(transform.normal_matrix());
+            }
+        });
+        run("cached.product(recompute)", reads, 0, [&] {
+            for (size_t i = 0; i < reads; i += 1) {
+                keep(projection * view);
+            }
+        });
+        math::cached_transform<float> camera(view);
+        math::cached_transform<float> lens(projection);
+        math::cached_product view_projection(lens, camera);
+        run("cached.product", reads, 0, [&] {
+            for (size_t i = 0; i < reads; i += 1) {
+                keep(view_projection.matrix());
+            }
+        });
+        // one write per frame, so every frame pays one miss
+        run("cached.product(write per frame)", reads, 0, [&] {
+            camera.set(view);
+            for (size_t i = 0; i < reads; i += 1) {
+                keep(view_projection.matrix());
+            }
+        });
+    }
+
+    // large inputs so chunking has room to spread; serial rows are the single-thread baseline
+    void parallel() {
+        using V = math::vec_t<float, 3>;
+        using M = math::mat_t<float, 4, 4>;
+
+        size_t count = opts.count * 256;
+        auto a = std::vector<V>(count);
+        for (V& v : a) {
+            v = V{random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(-1.0f, 1.0f)};
+        }
+        std::vector<V> out(count);
+
+        run("parallel.f32vec3.normalize_all(serial)", count, count * 2 * sizeof(V), [&] {
+            math::normalize_all(a, out);
+            keep(out.data());
+        });
+        run("parallel.f32vec3.normalize_all", count, count * 2 * sizeof(V), [&] {
+            math::parallel::for_each_chunk(a, [&](std::span<V const> chunk, size_t offset) {
+                math::normalize_all(chunk, std::span<V>(out).subspan(offset, chunk.size()));
+            });
+            keep(out.data());
+        });
+        run("parallel.f32vec3.reduce", count, count * sizeof(V), [&] {
+            keep(math::parallel::reduce(a, V{}, [](V const& $1, V const& $2) { return $1 + $2; }));
+        });
+        run("parallel.f32vec3.bounds(serial)", count, count * sizeof(V), [&] {
+            keep(math::bounds(a));
+        });
+        run("parallel.f32vec3.bounds", count, count * sizeof(V), [&] {
+            keep(math::parallel::bounds(a));
+        });
+        run("parallel.f32vec3.sum(serial)", count, count * sizeof(V), [&] {
+            keep(math::sum(a));
+        });
+        run("parallel.f32vec3.sum", count, count * sizeof(V), [&] {
+            keep(math::parallel::sum(a));
+        });
+
+        auto m = std::vector<M>(count / 16);
+        for (M& x : m) {
+            x = M{{{random(-1.0f, 1.0f), 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
+        }
+        std::vector<M> mout(m.size());
+        run("parallel.f32mat4x4.mul", m.size(), m.size() * 2 * sizeof(M), [&] {
+            math::parallel::transform(m, mout, [](M const& $1) { return $1 * $1; });
+            keep(mout.data());
+        });
+    }
+
+    // every level the CPU runs, through math::dispatch; levels without a built copy fall back to a lower table
+    void dispatch() {
+        using V = math::vec_t<float, 3>;
+        using M = math::mat_t<float, 4, 4>;
+
+        auto v = random<float, 3>(-1.0f, 1.0f);
+        std::vector<V> out(v.size());
+        auto f = std::vector<float>(opts.count);
+        for (float& x : f) {
+            x = random(-10.0f, 10.0f);
+        }
+        std::vector<float> fout(f.size());
+        M m = M{{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {1, 2, 3, 1}}};
+
+        math::dispatch::level startup = math::dispatch::current();
+        for (math::dispatch::level l : {math::dispatch::level::baseline, math::dispatch::level::x86_64_v2, math::dispatch::level::x86_64_v3, math::dispatch::level::x86_64_v4}) {
+            if (l > math::dispatch::detect() || math::dispatch::use(l) != l) {
+                continue;
+            }
+            std::string prefix = std::string("dispatch.") + math::dispatch::name(l);
+            run(prefix + ".f32vec3.transform_points", v.size(), v.size() * 2 * sizeof(V), [&] {
+                math::dispatch::transform_points(m, std::span<V const>(v), std::span<V>(out));
+                keep(out.data());
+            });
+            run(prefix + ".f32vec3.normalize_all", v.size(), v.size() * 2 * sizeof(V), [&] {
+                math::dispatch::normalize_all(std::span<V const>(v), std::span<V>(out));
+                keep(out.data());
+            });
+            run(prefix + ".f32vec3.bounds", v.size(), v.size() * sizeof(V), [&] {
+                keep(math::dispatch::bounds(std::span<V const>(v)));
+            });
+            run(prefix + ".f32.sin", f.size(), f.size() * 2 * sizeof(float), [&] {
+                math::dispatch::sin(std::span<float const>(f), std::span<float>(fout));
+                keep(fout.data());
+            });
+        }
+        math::dispatch::use(startup);
+    }
+
+    auto isa() -> char const* {
+        return ""
+#if defined(__SSE2__)
+            " sse2"
+#endif
+#if defined(__SSE4_1__)
+            " sse4.1"
+#endif
+#if defined(__AVX__)
+            " avx"
+#endif
+#if defined(__AVX2__)
+            " avx2"
+#endif
+#if defined(__FMA__)
+            " fma"
+#endif
+#if defined(__AVX512F__)
+            " avx512f"
+#endif
+        ;
+    }
+
+    void write_json(std::FILE* out) {
+        std::fprintf(out, "{\n");
+        std::fprintf(out, "  \"context\": {\n");
+        std::fprintf(out, "    \"compiler\": \"%s\",\n", __VERSION__);
+        std::fprintf(out, "    \"isa\": \"%s\",\n", isa()[0] != '\0' ? isa() + 1 : "");
+        std::fprintf(out, "    \"dispatch\": \"%s\",\n", math::dispatch::name(math::dispatch::current()));
+        std::fprintf(out, "    \"count\": %zu,\n", opts.count);
+        std::fprintf(out, "    \"samples\": %zu,\n", opts.samples);
+        std::fprintf(out, "    \"min_time\": %g\n", opts.min_time);
+        std::fprintf(out, "  },\n");
+        std::fprintf(out, "  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); i += 1) {
+            result const& r = results[i];
+            std::fprintf(out, "    {\"name\": \"%s\", \"ns_per_op\": %.6g, \"elements_per_second\": %.6g, \"bytes_per_second\": %.6g}%s\n",
+                r.name.c_str(), r.seconds * 1e9 / double(r.elements), double(r.elements) / r.seconds, double(r.bytes) / r.seconds, i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n");
+        std::fprintf(out, "}\n");
+    }
+
+    void usage(char const* $1) {
+        std::fprintf(stderr, "usage: %s [--filter <substring>] [--json <file|->] [--min-time <seconds>] [--samples <n>] [--count <n>]\n", $1);
+    }
+}
+
+auto main(int argc, char** argv) -> int {
+    using namespace bench;
+
+    for (int i = 1; i < argc; i += 1) {
+        char const* arg = argv[i];
+        char const* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (std::strcmp(arg, "--filter") == 0) {
+            opts.filter = value;
+        } else if (std::strcmp(arg, "--json") == 0) {
+            opts.json = value;
+        } else if (std::strcmp(arg, "--min-time") == 0) {
+            opts.min_time = std::atof(value);
+        } else if (std::strcmp(arg, "--samples") == 0) {
+            opts.samples = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+        } else if (std::strcmp(arg, "--count") == 0) {
+            opts.count = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+        i += 1;
+    }
+
+    // the table moves to stderr when the JSON report goes to stdout
+    bool piped = opts.json != nullptr && std::strcmp(opts.json, "-") == 0;
+    if (piped) {
+        opts.log = stderr;
+    }
+
+    // divisor<V>, the pool's error path and the cache invalidation are checked before anything is timed,
+    // since none of them would show in the table
+    bool divisors = check_divisors<int8_t>("i8")
+        & check_divisors<int16_t>("i16")
+        & check_divisors<int32_t>("i32")
+        & check_divisors<int64_t>("i64")
+        & check_divisors<uint8_t>("u8")
+        & check_divisors<uint16_t>("u16")
+        & check_divisors<uint32_t>("u32")
+        & check_divisors<uint64_t>("u64");
+    if (!divisors || !check_parallel_errors() || !check_cached_transforms()) {
+        return 1;
+    }
+
+    vec<int8_t, 2>("i8vec2");
+    vec<int8_t, 3>("i8vec3");
+    vec<int8_t, 4>("i8vec4");
+    vec<int16_t, 2>("i16vec2");
+    vec<int16_t, 3>("i16vec3");
+    vec<int16_t, 4>("i16vec4");
+    vec<int32_t, 2>("i32vec2");
+    vec<int32_t, 3>("i32vec3");
+    vec<int32_t, 4>("i32vec4");
+    vec<int64_t, 2>("i64vec2");
+    vec<int64_t, 3>("i64vec3");
+    vec<int64_t, 4>("i64vec4");
+
+    vec<uint8_t, 2>("u8vec2");
+    vec<uint8_t, 3>("u8vec3");
+    vec<uint8_t, 4>("u8vec4");
+    vec<uint16_t, 2>("u16vec2");
+    vec<uint16_t, 3>("u16vec3");
+    vec<uint16_t, 4>("u16vec4");
+    vec<uint32_t, 2>("u32vec2");
+    vec<uint32_t, 3>("u32vec3");
+    vec<uint32_t, 4>("u32vec4");
+    vec<uint64_t, 2>("u64vec2");
+    vec<uint64_t, 3>("u64vec3");
+    vec<uint64_t, 4>("u64vec4");
+
+    vec<float, 2>("f32vec2");
+    vec<float, 3>("f32vec3");
+    vec<float, 4>("f32vec4");
+    vec<double, 2>("f64vec2");
+    vec<double, 3>("f64vec3");
+    vec<double, 4>("f64vec4");
+
+    mat<float, 2>("f32mat2x2");
+    mat<float, 3>("f32mat3x3");
+    mat<float, 4>("f32mat4x4");
+    mat<double, 2>("f64mat2x2");
+    mat<double, 3>("f64mat3x3");
+    mat<double, 4>("f64mat4x4");
+
+    quat<float>("f32quat");
+    quat<double>("f64quat");
+
+    affine<float>("f32affine");
+    affine<double>("f64affine");
+
+    reduce<float, 3>("f32vec3");
+    reduce<float, 4>("f32vec4");
+    reduce<double, 3>("f64vec3");
+    morton<uint16_t, 2>("u16vec2");
+    morton<uint32_t, 3>("u32vec3");
+
+    lazy<float, 3>("f32vec3");
+    lazy<float, 4>("f32vec4");
+    lazy<double, 3>("f64vec3");
+
+    packed<math::f16vec2, 2>("f16vec2");
+    packed<math::f16vec3, 3>("f16vec3");
+    packed<math::f16vec4, 4>("f16vec4");
+    packed<math::snorm16vec3, 3>("snorm16vec3");
+    packed<math::unorm8vec4, 4>("unorm8vec4");
+    packed<math::unorm1010102, 4>("unorm1010102");
+    packed<math::snorm1010102, 4>("snorm1010102");
+
+    hash_map();
+    rays();
+    culling();
+    hierarchy();
+    cached();
+    parallel();
+    dispatch();
+
+    if (piped) {
+        write_json(stdout);
+    } else if (opts.json != nullptr) {
+        std::FILE* out = std::fopen(opts.json, "w");
+        if (out == nullptr) {
+            std::fprintf(stderr, "cannot open %s\n", opts.json);
+            return 1;
+        }
+        write_json(out);
+        std::fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+//
+// Created by Maksym Pasichnyk on 01.06.2024.
+//
+#include <cstddef>
+#include <cstdint>
+
+import Mathematics;
+
+// Compile-time workload for bench/compile_time.sh: instantiates every exported
+// vector alias and touches a representative set of swizzles on each.
+namespace bench {
+    template<typename V>
+    constexpr auto touch(V v) -> V {
+        V r = v + v;
+        r.x = v.y;
+        r.yx = v.xy;
+        r.rg = r.gr;
+        if constexpr (sizeof(v.__fields) / sizeof(v.__fields[0]) >= 3) {
+            r.xyz = v.zyx;
+            r.b = v.r;
+        }
+        if constexpr (sizeof(v.__fields) / sizeof(v.__fields[0]) >= 4) {
+            r.wzyx = v.xyzw;
+            r.a = v.w;
+        }
+        return r;
+    }
+
+    template<typename... V>
+    auto touch_all() -> size_t {
+        return (sizeof(touch(V{})) + ...);
+    }
+}
+
+auto main() -> int {
+    return static_cast<int>(bench::touch_all<
+        math::i8vec2, math::i8vec3, math::i8vec4,
+        math::i16vec2, math::i16vec3, math::i16vec4,
+        math::i32vec2, math::i32vec3, math::i32vec4,
+        math::i64vec2, math::i64vec3, math::i64vec4,
+        math::u8vec2, math::u8vec3, math::u8vec4,
+        math::u16vec2, math::u16vec3, math::u16vec4,
+        math::u32vec2, math::u32vec3, math::u32vec4,
+        math::u64vec2, math::u64vec3, math::u64vec4,
+        math::f32vec2, math::f32vec3, math::f32vec4,
+        math::f64vec2, math::f64vec3, math::f64vec4
+    >() & 0);
+}
@@ -0,0 +1,55 @@
+#!/usr/bin/env bash
+#
+# Compares the Mathematics module against a baseline revision on BMI size,
+# BMI build time and the compile time of bench/Swizzle_compile.cxx, which
+# touches every exported vector alias.
+#
+# usage: bench/compile_time.sh <baseline-rev> [runs]
+#
+# CXX selects the compiler (default clang++), CXXFLAGS adds extra flags.
+set -euo pipefail
+
+if [[ $# -lt 1 ]]; then
+    echo "usage: $0 <baseline-rev> [runs]" >&2
+    exit 2
+fi
+
+root="$(cd "$(dirname "$0")/.." && pwd)"
+baseline="$1"
+runs="${2:-5}"
+cxx="${CXX:-clang++}"
+# -I for Mathematics_dispatch.h, which the copies below no longer sit next to
+flags=(-std=c++26 -fdeclspec -O2 -I "$root/src" ${CXXFLAGS:-})
+
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+
+mkdir -p "$work/baseline" "$work/current"
+git -C "$root" show "$baseline:src/Mathematics.cxx" > "$work/baseline/Mathematics.cxx"
+cp "$root/src/Mathematics.cxx" "$work/current/Mathematics.cxx"
+
+# best wall time of $runs runs, in milliseconds
+best() {
+    local min=
+    for ((i = 0; i < runs; ++i)); do
+        local start end
+        start=$(date +%s%N)
+        "$@" > /dev/null
+        end=$(date +%s%N)
+        local ms=$(((end - start) / 1000000))
+        if [[ -z "$min" || $ms -lt $min ]]; then
+            min=$ms
+        fi
+    done
+    echo "$min"
+}
+
+printf '%-10s %12s %12s %12s\n' variant bmi_bytes bmi_ms tu_ms
+for variant in baseline current; do
+    dir="$work/$variant"
+    bmi_ms=$(best "$cxx" "${flags[@]}" --precompile "$dir/Mathematics.cxx" -o "$dir/Mathematics.pcm")
+    bmi_bytes=$(wc -c < "$dir/Mathematics.pcm")
+    tu_ms=$(best "$cxx" "${flags[@]}" -fmodule-file=Mathematics="$dir/Mathematics.pcm" \
+        -c "$root/bench/Swizzle_compile.cxx" -o "$dir/Swizzle_compile.o")
+    printf '%-10s %12d %12d %12d\n' "$variant" "$bmi_bytes" "$bmi_ms" "$tu_ms"
+done
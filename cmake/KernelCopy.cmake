@@ -0,0 +1,26 @@
+# Splits src/Mathematics.cxx for src/Mathematics_kernels.cxx: HEADERS gets the includes of its global
+# module fragment, LIBRARY the namespace math block with the module declaration and every export
+# keyword removed, so a kernel object can compile the library as ordinary code in a namespace of its own.
+#
+# usage: cmake -DINPUT=<file> -DHEADERS=<file> -DLIBRARY=<file> -P KernelCopy.cmake
+file(READ "${INPUT}" source)
+
+set(declaration "export module Mathematics;\n")
+string(FIND "${source}" "${declaration}" begin)
+# namespace math is the last block closed at column 0; the std::hash specialization after it stays module-only
+string(FIND "${source}" "\n}\n" end REVERSE)
+if (begin EQUAL -1 OR end LESS begin)
+    message(FATAL_ERROR "${INPUT}: cannot find the module declaration and the end of namespace math")
+endif ()
+
+string(SUBSTRING "${source}" 0 ${begin} headers)
+string(REPLACE "module;\n" "" headers "${headers}")
+
+string(LENGTH "${declaration}" length)
+math(EXPR begin "${begin} + ${length}")
+math(EXPR length "${end} + 3 - ${begin}")
+string(SUBSTRING "${source}" ${begin} ${length} library)
+string(REGEX REPLACE "([^A-Za-z0-9_])export " "\\1" library "${library}")
+
+file(WRITE "${HEADERS}" "${headers}")
+file(WRITE "${LIBRARY}" "${library}")
@@ -2,430 +2,438 @@
 // Created by Maksym Pasichnyk on 01.06.2024.
 //
 module;
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
 #include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <expected>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
 #include <utility>
+#include <vector>
+#include "Mathematics_dispatch.h"
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 export module Mathematics;
 
-#define DEFINE_COMPONENT(name, component)                                   \
-    __declspec(property(                                                    \
-        get = __##name##__,                                                 \
-        put = __##name##__                                                  \
-    )) struct {} name;                                                      \
-    template<typename Self> requires(component < Len)                       \
-    constexpr auto __##name##__(this Self const& self) -> T {               \
-        return self.__fields[component];                                    \
+// Swizzles share one empty property type and are keyed by component indices,
+// so the rgba names reuse the xyzw accessors. Accessors take the vector as
+// Self and forward to math::swizzle<I...>, so nothing in them depends on T:
+// they are declared once per length and only instantiated when a swizzle is used.
+#define DEFINE_ACCESSOR(id, ...)                                            \
+    template<typename Self>                                                 \
+    constexpr auto __swizzle_##id##__(this Self const& self) {              \
+        return swizzle<__VA_ARGS__>::get(self);                             \
     }                                                                       \
-    template<typename U> requires(component < Len)                          \
-    constexpr void __##name##__(this Self& self, U&& u) {                   \
-        self.__fields[component] = static_cast<U&&>(u);                     \
+    template<typename Self>                                                 \
+    constexpr void __swizzle_##id##__(                                      \
+        this Self& self,                                                    \
+        typename swizzle<__VA_ARGS__>::template value<                      \
+            std::remove_extent_t<decltype(Self::__fields)>                  \
+        > const& u                                                          \
+    ) {                                                                     \
+        swizzle<__VA_ARGS__>::put(self, u);                                 \
     }
 
-#define DEFINE_SWIZZLE_2(name, comp1, comp2)                                \
-    __declspec(property(                                                    \
-        get = __##name##__,                                                 \
-        put = __##name##__                                                  \
-    )) struct {} name;                                                      \
-    constexpr auto __##name##__(this Self const& self) -> vec_t<T, 2> {     \
-        return vec_t<T, 2>{                                                 \
-            self.__fields[comp1],                                           \
-            self.__fields[comp2],                                           \
-        };                                                                  \
-    }                                                                       \
-    constexpr void __##name##__(this Self& self, vec_t<T, 2> const& u) {    \
-        static_assert(                                                      \
-            comp1 != comp2,                                                 \
-            "vector is not assignable (contains duplicate components)"      \
-        );                                                                  \
-        self.__fields[comp1] = u[0];                                        \
-        self.__fields[comp2] = u[1];                                        \
-    }
-#define DEFINE_SWIZZLE_3(name, comp1, comp2, comp3)                         \
-    __declspec(property(                                                    \
-        get = __##name##__,                                                 \
-        put = __##name##__                                                  \
-    )) struct {} name;                                                      \
-    constexpr auto __##name##__(this Self const& self) -> vec_t<T, 3> {     \
-        return vec_t<T, 3>{                                                 \
-            self.__fields[comp1],                                           \
-            self.__fields[comp2],                                           \
-            self.__fields[comp3],                                           \
-        };                                                                  \
-    }                                                                       \
-    constexpr void __##name##__(this Self& self, vec_t<T, 3> const& u) {    \
-        static_assert(                                                      \
-            (comp1 != comp2) && (comp2 != comp3),                           \
-            "vector is not assignable (contains duplicate components)"      \
-        );                                                                  \
-        self.__fields[comp1] = u[0];                                        \
-        self.__fields[comp2] = u[1];                                        \
-        self.__fields[comp3] = u[2];                                        \
-    }
-#define DEFINE_SWIZZLE_4(name, comp1, comp2, comp3, comp4)                  \
+#define DEFINE_PROPERTY(name, id)                                           \
     __declspec(property(                                                    \
-        get = __##name##__,                                                 \
-        put = __##name##__                                                  \
-    )) struct {} name;                                                      \
-    constexpr auto __##name##__(this Self const& self) -> vec_t<T, 4> {     \
-        return vec_t<T, 4>{                                                 \
-            self.__fields[comp1],                                           \
-            self.__fields[comp2],                                           \
-            self.__fields[comp3],                                           \
-            self.__fields[comp4],                                           \
-        };                                                                  \
-    }                                                                       \
-    constexpr void __##name##__(this Self& self, vec_t<T, 4> const& u) {    \
-        static_assert(                                                      \
-            (comp1 != comp2) && (comp2 != comp3) && (comp3 != comp4),       \
-            "vector is not assignable (contains duplicate components)"      \
-        );                                                                  \
-        self.__fields[comp1] = u[0];                                        \
-        self.__fields[comp2] = u[1];                                        \
-        self.__fields[comp3] = u[2];                                        \
-        self.__fields[comp4] = u[3];                                        \
-    }
-
-#define DEFINE_PROPERTIES(x, y, z, w)       \
-    DEFINE_COMPONENT(x, 0)                  \
-    DEFINE_COMPONENT(y, 1)                  \
-    DEFINE_COMPONENT(z, 2)                  \
-    DEFINE_COMPONENT(w, 3)                  \
-    DEFINE_SWIZZLE_2(x##y, 0,1)             \
-    DEFINE_SWIZZLE_2(x##z, 0,2)             \
-    DEFINE_SWIZZLE_2(x##w, 0,3)             \
-    DEFINE_SWIZZLE_2(y##x, 1,0)             \
-    DEFINE_SWIZZLE_2(y##y, 1,1)             \
-    DEFINE_SWIZZLE_2(y##z, 1,2)             \
-    DEFINE_SWIZZLE_2(y##w, 1,3)             \
-    DEFINE_SWIZZLE_2(z##x, 2,0)             \
-    DEFINE_SWIZZLE_2(z##y, 2,1)             \
-    DEFINE_SWIZZLE_2(z##z, 2,2)             \
-    DEFINE_SWIZZLE_2(z##w, 2,3)             \
-    DEFINE_SWIZZLE_2(w##x, 3,0)             \
-    DEFINE_SWIZZLE_2(w##y, 3,1)             \
-    DEFINE_SWIZZLE_2(w##z, 3,2)             \
-    DEFINE_SWIZZLE_2(w##w, 3,3)             \
-    DEFINE_SWIZZLE_3(x##x##x, 0,0,0)        \
-    DEFINE_SWIZZLE_3(x##x##y, 0,0,1)        \
-    DEFINE_SWIZZLE_3(x##x##z, 0,0,2)        \
-    DEFINE_SWIZZLE_3(x##x##w, 0,0,3)        \
-    DEFINE_SWIZZLE_3(x##y##x, 0,1,0)        \
-    DEFINE_SWIZZLE_3(x##y##y, 0,1,1)        \
-    DEFINE_SWIZZLE_3(x##y##z, 0,1,2)        \
-    DEFINE_SWIZZLE_3(x##y##w, 0,1,3)        \
-    DEFINE_SWIZZLE_3(x##z##x, 0,2,0)        \
-    DEFINE_SWIZZLE_3(x##z##y, 0,2,1)        \
-    DEFINE_SWIZZLE_3(x##z##z, 0,2,2)        \
-    DEFINE_SWIZZLE_3(x##z##w, 0,2,3)        \
-    DEFINE_SWIZZLE_3(x##w##x, 0,3,0)        \
-    DEFINE_SWIZZLE_3(x##w##y, 0,3,1)        \
-    DEFINE_SWIZZLE_3(x##w##z, 0,3,2)        \
-    DEFINE_SWIZZLE_3(x##w##w, 0,3,3)        \
-    DEFINE_SWIZZLE_3(y##x##x, 1,0,0)        \
-    DEFINE_SWIZZLE_3(y##x##y, 1,0,1)        \
-    DEFINE_SWIZZLE_3(y##x##z, 1,0,2)        \
-    DEFINE_SWIZZLE_3(y##x##w, 1,0,3)        \
-    DEFINE_SWIZZLE_3(y##y##x, 1,1,0)        \
-    DEFINE_SWIZZLE_3(y##y##y, 1,1,1)        \
-    DEFINE_SWIZZLE_3(y##y##z, 1,1,2)        \
-    DEFINE_SWIZZLE_3(y##y##w, 1,1,3)        \
-    DEFINE_SWIZZLE_3(y##z##x, 1,2,0)        \
-    DEFINE_SWIZZLE_3(y##z##y, 1,2,1)        \
-    DEFINE_SWIZZLE_3(y##z##z, 1,2,2)        \
-    DEFINE_SWIZZLE_3(y##z##w, 1,2,3)        \
-    DEFINE_SWIZZLE_3(y##w##x, 1,3,0)        \
-    DEFINE_SWIZZLE_3(y##w##y, 1,3,1)        \
-    DEFINE_SWIZZLE_3(y##w##z, 1,3,2)        \
-    DEFINE_SWIZZLE_3(y##w##w, 1,3,3)        \
-    DEFINE_SWIZZLE_3(z##x##x, 2,0,0)        \
-    DEFINE_SWIZZLE_3(z##x##y, 2,0,1)        \
-    DEFINE_SWIZZLE_3(z##x##z, 2,0,2)        \
-    DEFINE_SWIZZLE_3(z##x##w, 2,0,3)        \
-    DEFINE_SWIZZLE_3(z##y##x, 2,1,0)        \
-    DEFINE_SWIZZLE_3(z##y##y, 2,1,1)        \
-    DEFINE_SWIZZLE_3(z##y##z, 2,1,2)        \
-    DEFINE_SWIZZLE_3(z##y##w, 2,1,3)        \
-    DEFINE_SWIZZLE_3(z##z##x, 2,2,0)        \
-    DEFINE_SWIZZLE_3(z##z##y, 2,2,1)        \
-    DEFINE_SWIZZLE_3(z##z##z, 2,2,2)        \
-    DEFINE_SWIZZLE_3(z##z##w, 2,2,3)        \
-    DEFINE_SWIZZLE_3(z##w##x, 2,3,0)        \
-    DEFINE_SWIZZLE_3(z##w##y, 2,3,1)        \
-    DEFINE_SWIZZLE_3(z##w##z, 2,3,2)        \
-    DEFINE_SWIZZLE_3(z##w##w, 2,3,3)        \
-    DEFINE_SWIZZLE_3(w##x##x, 3,0,0)        \
-    DEFINE_SWIZZLE_3(w##x##y, 3,0,1)        \
-    DEFINE_SWIZZLE_3(w##x##z, 3,0,2)        \
-    DEFINE_SWIZZLE_3(w##x##w, 3,0,3)        \
-    DEFINE_SWIZZLE_3(w##y##x, 3,1,0)        \
-    DEFINE_SWIZZLE_3(w##y##y, 3,1,1)        \
-    DEFINE_SWIZZLE_3(w##y##z, 3,1,2)        \
-    DEFINE_SWIZZLE_3(w##y##w, 3,1,3)        \
-    DEFINE_SWIZZLE_3(w##z##x, 3,2,0)        \
-    DEFINE_SWIZZLE_3(w##z##y, 3,2,1)        \
-    DEFINE_SWIZZLE_3(w##z##z, 3,2,2)        \
-    DEFINE_SWIZZLE_3(w##z##w, 3,2,3)        \
-    DEFINE_SWIZZLE_3(w##w##x, 3,3,0)        \
-    DEFINE_SWIZZLE_3(w##w##y, 3,3,1)        \
-    DEFINE_SWIZZLE_3(w##w##z, 3,3,2)        \
-    DEFINE_SWIZZLE_3(w##w##w, 3,3,3)        \
-    DEFINE_SWIZZLE_4(x##x##x##x, 0,0,0,0)   \
-    DEFINE_SWIZZLE_4(x##x##x##y, 0,0,0,1)   \
-    DEFINE_SWIZZLE_4(x##x##x##z, 0,0,0,2)   \
-    DEFINE_SWIZZLE_4(x##x##x##w, 0,0,0,3)   \
-    DEFINE_SWIZZLE_4(x##x##y##x, 0,0,1,0)   \
-    DEFINE_SWIZZLE_4(x##x##y##y, 0,0,1,1)   \
-    DEFINE_SWIZZLE_4(x##x##y##z, 0,0,1,2)   \
-    DEFINE_SWIZZLE_4(x##x##y##w, 0,0,1,3)   \
-    DEFINE_SWIZZLE_4(x##x##z##x, 0,0,2,0)   \
-    DEFINE_SWIZZLE_4(x##x##z##y, 0,0,2,1)   \
-    DEFINE_SWIZZLE_4(x##x##z##z, 0,0,2,2)   \
-    DEFINE_SWIZZLE_4(x##x##z##w, 0,0,2,3)   \
-    DEFINE_SWIZZLE_4(x##x##w##x, 0,0,3,0)   \
-    DEFINE_SWIZZLE_4(x##x##w##y, 0,0,3,1)   \
-    DEFINE_SWIZZLE_4(x##x##w##z, 0,0,3,2)   \
-    DEFINE_SWIZZLE_4(x##x##w##w, 0,0,3,3)   \
-    DEFINE_SWIZZLE_4(x##y##x##x, 0,1,0,0)   \
-    DEFINE_SWIZZLE_4(x##y##x##y, 0,1,0,1)   \
-    DEFINE_SWIZZLE_4(x##y##x##z, 0,1,0,2)   \
-    DEFINE_SWIZZLE_4(x##y##x##w, 0,1,0,3)   \
-    DEFINE_SWIZZLE_4(x##y##y##x, 0,1,1,0)   \
-    DEFINE_SWIZZLE_4(x##y##y##y, 0,1,1,1)   \
-    DEFINE_SWIZZLE_4(x##y##y##z, 0,1,1,2)   \
-    DEFINE_SWIZZLE_4(x##y##y##w, 0,1,1,3)   \
-    DEFINE_SWIZZLE_4(x##y##z##x, 0,1,2,0)   \
-    DEFINE_SWIZZLE_4(x##y##z##y, 0,1,2,1)   \
-    DEFINE_SWIZZLE_4(x##y##z##z, 0,1,2,2)   \
-    DEFINE_SWIZZLE_4(x##y##z##w, 0,1,2,3)   \
-    DEFINE_SWIZZLE_4(x##y##w##x, 0,1,3,0)   \
-    DEFINE_SWIZZLE_4(x##y##w##y, 0,1,3,1)   \
-    DEFINE_SWIZZLE_4(x##y##w##z, 0,1,3,2)   \
-    DEFINE_SWIZZLE_4(x##y##w##w, 0,1,3,3)   \
-    DEFINE_SWIZZLE_4(x##z##x##x, 0,2,0,0)   \
-    DEFINE_SWIZZLE_4(x##z##x##y, 0,2,0,1)   \
-    DEFINE_SWIZZLE_4(x##z##x##z, 0,2,0,2)   \
-    DEFINE_SWIZZLE_4(x##z##x##w, 0,2,0,3)   \
-    DEFINE_SWIZZLE_4(x##z##y##x, 0,2,1,0)   \
-    DEFINE_SWIZZLE_4(x##z##y##y, 0,2,1,1)   \
-    DEFINE_SWIZZLE_4(x##z##y##z, 0,2,1,2)   \
-    DEFINE_SWIZZLE_4(x##z##y##w, 0,2,1,3)   \
-    DEFINE_SWIZZLE_4(x##z##z##x, 0,2,2,0)   \
-    DEFINE_SWIZZLE_4(x##z##z##y, 0,2,2,1)   \
-    DEFINE_SWIZZLE_4(x##z##z##z, 0,2,2,2)   \
-    DEFINE_SWIZZLE_4(x##z##z##w, 0,2,2,3)   \
-    DEFINE_SWIZZLE_4(x##z##w##x, 0,2,3,0)   \
-    DEFINE_SWIZZLE_4(x##z##w##y, 0,2,3,1)   \
-    DEFINE_SWIZZLE_4(x##z##w##z, 0,2,3,2)   \
-    DEFINE_SWIZZLE_4(x##z##w##w, 0,2,3,3)   \
-    DEFINE_SWIZZLE_4(x##w##x##x, 0,3,0,0)   \
-    DEFINE_SWIZZLE_4(x##w##x##y, 0,3,0,1)   \
-    DEFINE_SWIZZLE_4(x##w##x##z, 0,3,0,2)   \
-    DEFINE_SWIZZLE_4(x##w##x##w, 0,3,0,3)   \
-    DEFINE_SWIZZLE_4(x##w##y##x, 0,3,1,0)   \
-    DEFINE_SWIZZLE_4(x##w##y##y, 0,3,1,1)   \
-    DEFINE_SWIZZLE_4(x##w##y##z, 0,3,1,2)   \
-    DEFINE_SWIZZLE_4(x##w##y##w, 0,3,1,3)   \
-    DEFINE_SWIZZLE_4(x##w##z##x, 0,3,2,0)   \
-    DEFINE_SWIZZLE_4(x##w##z##y, 0,3,2,1)   \
-    DEFINE_SWIZZLE_4(x##w##z##z, 0,3,2,2)   \
-    DEFINE_SWIZZLE_4(x##w##z##w, 0,3,2,3)   \
-    DEFINE_SWIZZLE_4(x##w##w##x, 0,3,3,0)   \
-    DEFINE_SWIZZLE_4(x##w##w##y, 0,3,3,1)   \
-    DEFINE_SWIZZLE_4(x##w##w##z, 0,3,3,2)   \
-    DEFINE_SWIZZLE_4(x##w##w##w, 0,3,3,3)   \
-    DEFINE_SWIZZLE_4(y##x##x##x, 1,0,0,0)   \
-    DEFINE_SWIZZLE_4(y##x##x##y, 1,0,0,1)   \
-    DEFINE_SWIZZLE_4(y##x##x##z, 1,0,0,2)   \
-    DEFINE_SWIZZLE_4(y##x##x##w, 1,0,0,3)   \
-    DEFINE_SWIZZLE_4(y##x##y##x, 1,0,1,0)   \
-    DEFINE_SWIZZLE_4(y##x##y##y, 1,0,1,1)   \
-    DEFINE_SWIZZLE_4(y##x##y##z, 1,0,1,2)   \
-    DEFINE_SWIZZLE_4(y##x##y##w, 1,0,1,3)   \
-    DEFINE_SWIZZLE_4(y##x##z##x, 1,0,2,0)   \
-    DEFINE_SWIZZLE_4(y##x##z##y, 1,0,2,1)   \
-    DEFINE_SWIZZLE_4(y##x##z##z, 1,0,2,2)   \
-    DEFINE_SWIZZLE_4(y##x##z##w, 1,0,2,3)   \
-    DEFINE_SWIZZLE_4(y##x##w##x, 1,0,3,0)   \
-    DEFINE_SWIZZLE_4(y##x##w##y, 1,0,3,1)   \
-    DEFINE_SWIZZLE_4(y##x##w##z, 1,0,3,2)   \
-    DEFINE_SWIZZLE_4(y##x##w##w, 1,0,3,3)   \
-    DEFINE_SWIZZLE_4(y##y##x##x, 1,1,0,0)   \
-    DEFINE_SWIZZLE_4(y##y##x##y, 1,1,0,1)   \
-    DEFINE_SWIZZLE_4(y##y##x##z, 1,1,0,2)   \
-    DEFINE_SWIZZLE_4(y##y##x##w, 1,1,0,3)   \
-    DEFINE_SWIZZLE_4(y##y##y##x, 1,1,1,0)   \
-    DEFINE_SWIZZLE_4(y##y##y##y, 1,1,1,1)   \
-    DEFINE_SWIZZLE_4(y##y##y##z, 1,1,1,2)   \
-    DEFINE_SWIZZLE_4(y##y##y##w, 1,1,1,3)   \
-    DEFINE_SWIZZLE_4(y##y##z##x, 1,1,2,0)   \
-    DEFINE_SWIZZLE_4(y##y##z##y, 1,1,2,1)   \
-    DEFINE_SWIZZLE_4(y##y##z##z, 1,1,2,2)   \
-    DEFINE_SWIZZLE_4(y##y##z##w, 1,1,2,3)   \
-    DEFINE_SWIZZLE_4(y##y##w##x, 1,1,3,0)   \
-    DEFINE_SWIZZLE_4(y##y##w##y, 1,1,3,1)   \
-    DEFINE_SWIZZLE_4(y##y##w##z, 1,1,3,2)   \
-    DEFINE_SWIZZLE_4(y##y##w##w, 1,1,3,3)   \
-    DEFINE_SWIZZLE_4(y##z##x##x, 1,2,0,0)   \
-    DEFINE_SWIZZLE_4(y##z##x##y, 1,2,0,1)   \
-    DEFINE_SWIZZLE_4(y##z##x##z, 1,2,0,2)   \
-    DEFINE_SWIZZLE_4(y##z##x##w, 1,2,0,3)   \
-    DEFINE_SWIZZLE_4(y##z##y##x, 1,2,1,0)   \
-    DEFINE_SWIZZLE_4(y##z##y##y, 1,2,1,1)   \
-    DEFINE_SWIZZLE_4(y##z##y##z, 1,2,1,2)   \
-    DEFINE_SWIZZLE_4(y##z##y##w, 1,2,1,3)   \
-    DEFINE_SWIZZLE_4(y##z##z##x, 1,2,2,0)   \
-    DEFINE_SWIZZLE_4(y##z##z##y, 1,2,2,1)   \
-    DEFINE_SWIZZLE_4(y##z##z##z, 1,2,2,2)   \
-    DEFINE_SWIZZLE_4(y##z##z##w, 1,2,2,3)   \
-    DEFINE_SWIZZLE_4(y##z##w##x, 1,2,3,0)   \
-    DEFINE_SWIZZLE_4(y##z##w##y, 1,2,3,1)   \
-    DEFINE_SWIZZLE_4(y##z##w##z, 1,2,3,2)   \
-    DEFINE_SWIZZLE_4(y##z##w##w, 1,2,3,3)   \
-    DEFINE_SWIZZLE_4(y##w##x##x, 1,3,0,0)   \
-    DEFINE_SWIZZLE_4(y##w##x##y, 1,3,0,1)   \
-    DEFINE_SWIZZLE_4(y##w##x##z, 1,3,0,2)   \
-    DEFINE_SWIZZLE_4(y##w##x##w, 1,3,0,3)   \
-    DEFINE_SWIZZLE_4(y##w##y##x, 1,3,1,0)   \
-    DEFINE_SWIZZLE_4(y##w##y##y, 1,3,1,1)   \
-    DEFINE_SWIZZLE_4(y##w##y##z, 1,3,1,2)   \
-    DEFINE_SWIZZLE_4(y##w##y##w, 1,3,1,3)   \
-    DEFINE_SWIZZLE_4(y##w##z##x, 1,3,2,0)   \
-    DEFINE_SWIZZLE_4(y##w##z##y, 1,3,2,1)   \
-    DEFINE_SWIZZLE_4(y##w##z##z, 1,3,2,2)   \
-    DEFINE_SWIZZLE_4(y##w##z##w, 1,3,2,3)   \
-    DEFINE_SWIZZLE_4(y##w##w##x, 1,3,3,0)   \
-    DEFINE_SWIZZLE_4(y##w##w##y, 1,3,3,1)   \
-    DEFINE_SWIZZLE_4(y##w##w##z, 1,3,3,2)   \
-    DEFINE_SWIZZLE_4(y##w##w##w, 1,3,3,3)   \
-    DEFINE_SWIZZLE_4(z##x##x##x, 2,0,0,0)   \
-    DEFINE_SWIZZLE_4(z##x##x##y, 2,0,0,1)   \
-    DEFINE_SWIZZLE_4(z##x##x##z, 2,0,0,2)   \
-    DEFINE_SWIZZLE_4(z##x##x##w, 2,0,0,3)   \
-    DEFINE_SWIZZLE_4(z##x##y##x, 2,0,1,0)   \
-    DEFINE_SWIZZLE_4(z##x##y##y, 2,0,1,1)   \
-    DEFINE_SWIZZLE_4(z##x##y##z, 2,0,1,2)   \
-    DEFINE_SWIZZLE_4(z##x##y##w, 2,0,1,3)   \
-    DEFINE_SWIZZLE_4(z##x##z##x, 2,0,2,0)   \
-    DEFINE_SWIZZLE_4(z##x##z##y, 2,0,2,1)   \
-    DEFINE_SWIZZLE_4(z##x##z##z, 2,0,2,2)   \
-    DEFINE_SWIZZLE_4(z##x##z##w, 2,0,2,3)   \
-    DEFINE_SWIZZLE_4(z##x##w##x, 2,0,3,0)   \
-    DEFINE_SWIZZLE_4(z##x##w##y, 2,0,3,1)   \
-    DEFINE_SWIZZLE_4(z##x##w##z, 2,0,3,2)   \
-    DEFINE_SWIZZLE_4(z##x##w##w, 2,0,3,3)   \
-    DEFINE_SWIZZLE_4(z##y##x##x, 2,1,0,0)   \
-    DEFINE_SWIZZLE_4(z##y##x##y, 2,1,0,1)   \
-    DEFINE_SWIZZLE_4(z##y##x##z, 2,1,0,2)   \
-    DEFINE_SWIZZLE_4(z##y##x##w, 2,1,0,3)   \
-    DEFINE_SWIZZLE_4(z##y##y##x, 2,1,1,0)   \
-    DEFINE_SWIZZLE_4(z##y##y##y, 2,1,1,1)   \
-    DEFINE_SWIZZLE_4(z##y##y##z, 2,1,1,2)   \
-    DEFINE_SWIZZLE_4(z##y##y##w, 2,1,1,3)   \
-    DEFINE_SWIZZLE_4(z##y##z##x, 2,1,2,0)   \
-    DEFINE_SWIZZLE_4(z##y##z##y, 2,1,2,1)   \
-    DEFINE_SWIZZLE_4(z##y##z##z, 2,1,2,2)   \
-    DEFINE_SWIZZLE_4(z##y##z##w, 2,1,2,3)   \
-    DEFINE_SWIZZLE_4(z##y##w##x, 2,1,3,0)   \
-    DEFINE_SWIZZLE_4(z##y##w##y, 2,1,3,1)   \
-    DEFINE_SWIZZLE_4(z##y##w##z, 2,1,3,2)   \
-    DEFINE_SWIZZLE_4(z##y##w##w, 2,1,3,3)   \
-    DEFINE_SWIZZLE_4(z##z##x##x, 2,2,0,0)   \
-    DEFINE_SWIZZLE_4(z##z##x##y, 2,2,0,1)   \
-    DEFINE_SWIZZLE_4(z##z##x##z, 2,2,0,2)   \
-    DEFINE_SWIZZLE_4(z##z##x##w, 2,2,0,3)   \
-    DEFINE_SWIZZLE_4(z##z##y##x, 2,2,1,0)   \
-    DEFINE_SWIZZLE_4(z##z##y##y, 2,2,1,1)   \
-    DEFINE_SWIZZLE_4(z##z##y##z, 2,2,1,2)   \
-    DEFINE_SWIZZLE_4(z##z##y##w, 2,2,1,3)   \
-    DEFINE_SWIZZLE_4(z##z##z##x, 2,2,2,0)   \
-    DEFINE_SWIZZLE_4(z##z##z##y, 2,2,2,1)   \
-    DEFINE_SWIZZLE_4(z##z##z##z, 2,2,2,2)   \
-    DEFINE_SWIZZLE_4(z##z##z##w, 2,2,2,3)   \
-    DEFINE_SWIZZLE_4(z##z##w##x, 2,2,3,0)   \
-    DEFINE_SWIZZLE_4(z##z##w##y, 2,2,3,1)   \
-    DEFINE_SWIZZLE_4(z##z##w##z, 2,2,3,2)   \
-    DEFINE_SWIZZLE_4(z##z##w##w, 2,2,3,3)   \
-    DEFINE_SWIZZLE_4(z##w##x##x, 2,3,0,0)   \
-    DEFINE_SWIZZLE_4(z##w##x##y, 2,3,0,1)   \
-    DEFINE_SWIZZLE_4(z##w##x##z, 2,3,0,2)   \
-    DEFINE_SWIZZLE_4(z##w##x##w, 2,3,0,3)   \
-    DEFINE_SWIZZLE_4(z##w##y##x, 2,3,1,0)   \
-    DEFINE_SWIZZLE_4(z##w##y##y, 2,3,1,1)   \
-    DEFINE_SWIZZLE_4(z##w##y##z, 2,3,1,2)   \
-    DEFINE_SWIZZLE_4(z##w##y##w, 2,3,1,3)   \
-    DEFINE_SWIZZLE_4(z##w##z##x, 2,3,2,0)   \
-    DEFINE_SWIZZLE_4(z##w##z##y, 2,3,2,1)   \
-    DEFINE_SWIZZLE_4(z##w##z##z, 2,3,2,2)   \
-    DEFINE_SWIZZLE_4(z##w##z##w, 2,3,2,3)   \
-    DEFINE_SWIZZLE_4(z##w##w##x, 2,3,3,0)   \
-    DEFINE_SWIZZLE_4(z##w##w##y, 2,3,3,1)   \
-    DEFINE_SWIZZLE_4(z##w##w##z, 2,3,3,2)   \
-    DEFINE_SWIZZLE_4(z##w##w##w, 2,3,3,3)   \
-    DEFINE_SWIZZLE_4(w##x##x##x, 3,0,0,0)   \
-    DEFINE_SWIZZLE_4(w##x##x##y, 3,0,0,1)   \
-    DEFINE_SWIZZLE_4(w##x##x##z, 3,0,0,2)   \
-    DEFINE_SWIZZLE_4(w##x##x##w, 3,0,0,3)   \
-    DEFINE_SWIZZLE_4(w##x##y##x, 3,0,1,0)   \
-    DEFINE_SWIZZLE_4(w##x##y##y, 3,0,1,1)   \
-    DEFINE_SWIZZLE_4(w##x##y##z, 3,0,1,2)   \
-    DEFINE_SWIZZLE_4(w##x##y##w, 3,0,1,3)   \
-    DEFINE_SWIZZLE_4(w##x##z##x, 3,0,2,0)   \
-    DEFINE_SWIZZLE_4(w##x##z##y, 3,0,2,1)   \
-    DEFINE_SWIZZLE_4(w##x##z##z, 3,0,2,2)   \
-    DEFINE_SWIZZLE_4(w##x##z##w, 3,0,2,3)   \
-    DEFINE_SWIZZLE_4(w##x##w##x, 3,0,3,0)   \
-    DEFINE_SWIZZLE_4(w##x##w##y, 3,0,3,1)   \
-    DEFINE_SWIZZLE_4(w##x##w##z, 3,0,3,2)   \
-    DEFINE_SWIZZLE_4(w##x##w##w, 3,0,3,3)   \
-    DEFINE_SWIZZLE_4(w##y##x##x, 3,1,0,0)   \
-    DEFINE_SWIZZLE_4(w##y##x##y, 3,1,0,1)   \
-    DEFINE_SWIZZLE_4(w##y##x##z, 3,1,0,2)   \
-    DEFINE_SWIZZLE_4(w##y##x##w, 3,1,0,3)   \
-    DEFINE_SWIZZLE_4(w##y##y##x, 3,1,1,0)   \
-    DEFINE_SWIZZLE_4(w##y##y##y, 3,1,1,1)   \
-    DEFINE_SWIZZLE_4(w##y##y##z, 3,1,1,2)   \
-    DEFINE_SWIZZLE_4(w##y##y##w, 3,1,1,3)   \
-    DEFINE_SWIZZLE_4(w##y##z##x, 3,1,2,0)   \
-    DEFINE_SWIZZLE_4(w##y##z##y, 3,1,2,1)   \
-    DEFINE_SWIZZLE_4(w##y##z##z, 3,1,2,2)   \
-    DEFINE_SWIZZLE_4(w##y##z##w, 3,1,2,3)   \
-    DEFINE_SWIZZLE_4(w##y##w##x, 3,1,3,0)   \
-    DEFINE_SWIZZLE_4(w##y##w##y, 3,1,3,1)   \
-    DEFINE_SWIZZLE_4(w##y##w##z, 3,1,3,2)   \
-    DEFINE_SWIZZLE_4(w##y##w##w, 3,1,3,3)   \
-    DEFINE_SWIZZLE_4(w##z##x##x, 3,2,0,0)   \
-    DEFINE_SWIZZLE_4(w##z##x##y, 3,2,0,1)   \
-    DEFINE_SWIZZLE_4(w##z##x##z, 3,2,0,2)   \
-    DEFINE_SWIZZLE_4(w##z##x##w, 3,2,0,3)   \
-    DEFINE_SWIZZLE_4(w##z##y##x, 3,2,1,0)   \
-    DEFINE_SWIZZLE_4(w##z##y##y, 3,2,1,1)   \
-    DEFINE_SWIZZLE_4(w##z##y##z, 3,2,1,2)   \
-    DEFINE_SWIZZLE_4(w##z##y##w, 3,2,1,3)   \
-    DEFINE_SWIZZLE_4(w##z##z##x, 3,2,2,0)   \
-    DEFINE_SWIZZLE_4(w##z##z##y, 3,2,2,1)   \
-    DEFINE_SWIZZLE_4(w##z##z##z, 3,2,2,2)   \
-    DEFINE_SWIZZLE_4(w##z##z##w, 3,2,2,3)   \
-    DEFINE_SWIZZLE_4(w##z##w##x, 3,2,3,0)   \
-    DEFINE_SWIZZLE_4(w##z##w##y, 3,2,3,1)   \
-    DEFINE_SWIZZLE_4(w##z##w##z, 3,2,3,2)   \
-    DEFINE_SWIZZLE_4(w##z##w##w, 3,2,3,3)   \
-    DEFINE_SWIZZLE_4(w##w##x##x, 3,3,0,0)   \
-    DEFINE_SWIZZLE_4(w##w##x##y, 3,3,0,1)   \
-    DEFINE_SWIZZLE_4(w##w##x##z, 3,3,0,2)   \
-    DEFINE_SWIZZLE_4(w##w##x##w, 3,3,0,3)   \
-    DEFINE_SWIZZLE_4(w##w##y##x, 3,3,1,0)   \
-    DEFINE_SWIZZLE_4(w##w##y##y, 3,3,1,1)   \
-    DEFINE_SWIZZLE_4(w##w##y##z, 3,3,1,2)   \
-    DEFINE_SWIZZLE_4(w##w##y##w, 3,3,1,3)   \
-    DEFINE_SWIZZLE_4(w##w##z##x, 3,3,2,0)   \
-    DEFINE_SWIZZLE_4(w##w##z##y, 3,3,2,1)   \
-    DEFINE_SWIZZLE_4(w##w##z##z, 3,3,2,2)   \
-    DEFINE_SWIZZLE_4(w##w##z##w, 3,3,2,3)   \
-    DEFINE_SWIZZLE_4(w##w##w##x, 3,3,3,0)   \
-    DEFINE_SWIZZLE_4(w##w##w##y, 3,3,3,1)   \
-    DEFINE_SWIZZLE_4(w##w##w##z, 3,3,3,2)   \
-    DEFINE_SWIZZLE_4(w##w##w##w, 3,3,3,3)
+        get = __swizzle_##id##__,                                           \
+        put = __swizzle_##id##__                                            \
+    )) swizzle_property name;
+
+#define DEFINE_SWIZZLE(name, id, ...)                                       \
+    DEFINE_ACCESSOR(id, __VA_ARGS__)                                        \
+    DEFINE_PROPERTY(name, id)
+
+#define DEFINE_SWIZZLE_ALIAS(name, id, ...)                                 \
+    DEFINE_PROPERTY(name, id)
+
+#define DEFINE_PROPERTIES_1(define, x, y, z, w) \
+    define(x, 0, 0)                             \
+    define(x##x, 00, 0,0)                       \
+    define(x##x##x, 000, 0,0,0)                 \
+    define(x##x##x##x, 0000, 0,0,0,0)
+
+#define DEFINE_PROPERTIES_2(define, x, y, z, w) \
+    DEFINE_PROPERTIES_1(define, x, y, z, w)     \
+    define(y, 1, 1)                             \
+    define(x##y, 01, 0,1)                       \
+    define(y##x, 10, 1,0)                       \
+    define(y##y, 11, 1,1)                       \
+    define(x##x##y, 001, 0,0,1)                 \
+    define(x##y##x, 010, 0,1,0)                 \
+    define(x##y##y, 011, 0,1,1)                 \
+    define(y##x##x, 100, 1,0,0)                 \
+    define(y##x##y, 101, 1,0,1)                 \
+    define(y##y##x, 110, 1,1,0)                 \
+    define(y##y##y, 111, 1,1,1)                 \
+    define(x##x##x##y, 0001, 0,0,0,1)           \
+    define(x##x##y##x, 0010, 0,0,1,0)           \
+    define(x##x##y##y, 0011, 0,0,1,1)           \
+    define(x##y##x##x, 0100, 0,1,0,0)           \
+    define(x##y##x##y, 0101, 0,1,0,1)           \
+    define(x##y##y##x, 0110, 0,1,1,0)           \
+    define(x##y##y##y, 0111, 0,1,1,1)           \
+    define(y##x##x##x, 1000, 1,0,0,0)           \
+    define(y##x##x##y, 1001, 1,0,0,1)           \
+    define(y##x##y##x, 1010, 1,0,1,0)           \
+    define(y##x##y##y, 1011, 1,0,1,1)           \
+    define(y##y##x##x, 1100, 1,1,0,0)           \
+    define(y##y##x##y, 1101, 1,1,0,1)           \
+    define(y##y##y##x, 1110, 1,1,1,0)           \
+    define(y##y##y##y, 1111, 1,1,1,1)
+
+#define DEFINE_PROPERTIES_3(define, x, y, z, w) \
+    DEFINE_PROPERTIES_2(define, x, y, z, w)     \
+    define(z, 2, 2)                             \
+    define(x##z, 02, 0,2)                       \
+    define(y##z, 12, 1,2)                       \
+    define(z##x, 20, 2,0)                       \
+    define(z##y, 21, 2,1)                       \
+    define(z##z, 22, 2,2)                       \
+    define(x##x##z, 002, 0,0,2)                 \
+    define(x##y##z, 012, 0,1,2)                 \
+    define(x##z##x, 020, 0,2,0)                 \
+    define(x##z##y, 021, 0,2,1)                 \
+    define(x##z##z, 022, 0,2,2)                 \
+    define(y##x##z, 102, 1,0,2)                 \
+    define(y##y##z, 112, 1,1,2)                 \
+    define(y##z##x, 120, 1,2,0)                 \
+    define(y##z##y, 121, 1,2,1)                 \
+    define(y##z##z, 122, 1,2,2)                 \
+    define(z##x##x, 200, 2,0,0)                 \
+    define(z##x##y, 201, 2,0,1)                 \
+    define(z##x##z, 202, 2,0,2)                 \
+    define(z##y##x, 210, 2,1,0)                 \
+    define(z##y##y, 211, 2,1,1)                 \
+    define(z##y##z, 212, 2,1,2)                 \
+    define(z##z##x, 220, 2,2,0)                 \
+    define(z##z##y, 221, 2,2,1)                 \
+    define(z##z##z, 222, 2,2,2)                 \
+    define(x##x##x##z, 0002, 0,0,0,2)           \
+    define(x##x##y##z, 0012, 0,0,1,2)           \
+    define(x##x##z##x, 0020, 0,0,2,0)           \
+    define(x##x##z##y, 0021, 0,0,2,1)           \
+    define(x##x##z##z, 0022, 0,0,2,2)           \
+    define(x##y##x##z, 0102, 0,1,0,2)           \
+    define(x##y##y##z, 0112, 0,1,1,2)           \
+    define(x##y##z##x, 0120, 0,1,2,0)           \
+    define(x##y##z##y, 0121, 0,1,2,1)           \
+    define(x##y##z##z, 0122, 0,1,2,2)           \
+    define(x##z##x##x, 0200, 0,2,0,0)           \
+    define(x##z##x##y, 0201, 0,2,0,1)           \
+    define(x##z##x##z, 0202, 0,2,0,2)           \
+    define(x##z##y##x, 0210, 0,2,1,0)           \
+    define(x##z##y##y, 0211, 0,2,1,1)           \
+    define(x##z##y##z, 0212, 0,2,1,2)           \
+    define(x##z##z##x, 0220, 0,2,2,0)           \
+    define(x##z##z##y, 0221, 0,2,2,1)           \
+    define(x##z##z##z, 0222, 0,2,2,2)           \
+    define(y##x##x##z, 1002, 1,0,0,2)           \
+    define(y##x##y##z, 1012, 1,0,1,2)           \
+    define(y##x##z##x, 1020, 1,0,2,0)           \
+    define(y##x##z##y, 1021, 1,0,2,1)           \
+    define(y##x##z##z, 1022, 1,0,2,2)           \
+    define(y##y##x##z, 1102, 1,1,0,2)           \
+    define(y##y##y##z, 1112, 1,1,1,2)           \
+    define(y##y##z##x, 1120, 1,1,2,0)           \
+    define(y##y##z##y, 1121, 1,1,2,1)           \
+    define(y##y##z##z, 1122, 1,1,2,2)           \
+    define(y##z##x##x, 1200, 1,2,0,0)           \
+    define(y##z##x##y, 1201, 1,2,0,1)           \
+    define(y##z##x##z, 1202, 1,2,0,2)           \
+    define(y##z##y##x, 1210, 1,2,1,0)           \
+    define(y##z##y##y, 1211, 1,2,1,1)           \
+    define(y##z##y##z, 1212, 1,2,1,2)           \
+    define(y##z##z##x, 1220, 1,2,2,0)           \
+    define(y##z##z##y, 1221, 1,2,2,1)           \
+    define(y##z##z##z, 1222, 1,2,2,2)           \
+    define(z##x##x##x, 2000, 2,0,0,0)           \
+    define(z##x##x##y, 2001, 2,0,0,1)           \
+    define(z##x##x##z, 2002, 2,0,0,2)           \
+    define(z##x##y##x, 2010, 2,0,1,0)           \
+    define(z##x##y##y, 2011, 2,0,1,1)           \
+    define(z##x##y##z, 2012, 2,0,1,2)           \
+    define(z##x##z##x, 2020, 2,0,2,0)           \
+    define(z##x##z##y, 2021, 2,0,2,1)           \
+    define(z##x##z##z, 2022, 2,0,2,2)           \
+    define(z##y##x##x, 2100, 2,1,0,0)           \
+    define(z##y##x##y, 2101, 2,1,0,1)           \
+    define(z##y##x##z, 2102, 2,1,0,2)           \
+    define(z##y##y##x, 2110, 2,1,1,0)           \
+    define(z##y##y##y, 2111, 2,1,1,1)           \
+    define(z##y##y##z, 2112, 2,1,1,2)           \
+    define(z##y##z##x, 2120, 2,1,2,0)           \
+    define(z##y##z##y, 2121, 2,1,2,1)           \
+    define(z##y##z##z, 2122, 2,1,2,2)           \
+    define(z##z##x##x, 2200, 2,2,0,0)           \
+    define(z##z##x##y, 2201, 2,2,0,1)           \
+    define(z##z##x##z, 2202, 2,2,0,2)           \
+    define(z##z##y##x, 2210, 2,2,1,0)           \
+    define(z##z##y##y, 2211, 2,2,1,1)           \
+    define(z##z##y##z, 2212, 2,2,1,2)           \
+    define(z##z##z##x, 2220, 2,2,2,0)           \
+    define(z##z##z##y, 2221, 2,2,2,1)           \
+    define(z##z##z##z, 2222, 2,2,2,2)
+
+#define DEFINE_PROPERTIES_4(define, x, y, z, w) \
+    DEFINE_PROPERTIES_3(define, x, y, z, w)     \
+    define(w, 3, 3)                             \
+    define(x##w, 03, 0,3)                       \
+    define(y##w, 13, 1,3)                       \
+    define(z##w, 23, 2,3)                       \
+    define(w##x, 30, 3,0)                       \
+    define(w##y, 31, 3,1)                       \
+    define(w##z, 32, 3,2)                       \
+    define(w##w, 33, 3,3)                       \
+    define(x##x##w, 003, 0,0,3)                 \
+    define(x##y##w, 013, 0,1,3)                 \
+    define(x##z##w, 023, 0,2,3)                 \
+    define(x##w##x, 030, 0,3,0)                 \
+    define(x##w##y, 031, 0,3,1)                 \
+    define(x##w##z, 032, 0,3,2)                 \
+    define(x##w##w, 033, 0,3,3)                 \
+    define(y##x##w, 103, 1,0,3)                 \
+    define(y##y##w, 113, 1,1,3)                 \
+    define(y##z##w, 123, 1,2,3)                 \
+    define(y##w##x, 130, 1,3,0)                 \
+    define(y##w##y, 131, 1,3,1)                 \
+    define(y##w##z, 132, 1,3,2)                 \
+    define(y##w##w, 133, 1,3,3)                 \
+    define(z##x##w, 203, 2,0,3)                 \
+    define(z##y##w, 213, 2,1,3)                 \
+    define(z##z##w, 223, 2,2,3)                 \
+    define(z##w##x, 230, 2,3,0)                 \
+    define(z##w##y, 231, 2,3,1)                 \
+    define(z##w##z, 232, 2,3,2)                 \
+    define(z##w##w, 233, 2,3,3)                 \
+    define(w##x##x, 300, 3,0,0)                 \
+    define(w##x##y, 301, 3,0,1)                 \
+    define(w##x##z, 302, 3,0,2)                 \
+    define(w##x##w, 303, 3,0,3)                 \
+    define(w##y##x, 310, 3,1,0)                 \
+    define(w##y##y, 311, 3,1,1)                 \
+    define(w##y##z, 312, 3,1,2)                 \
+    define(w##y##w, 313, 3,1,3)                 \
+    define(w##z##x, 320, 3,2,0)                 \
+    define(w##z##y, 321, 3,2,1)                 \
+    define(w##z##z, 322, 3,2,2)                 \
+    define(w##z##w, 323, 3,2,3)                 \
+    define(w##w##x, 330, 3,3,0)                 \
+    define(w##w##y, 331, 3,3,1)                 \
+    define(w##w##z, 332, 3,3,2)                 \
+    define(w##w##w, 333, 3,3,3)                 \
+    define(x##x##x##w, 0003, 0,0,0,3)           \
+    define(x##x##y##w, 0013, 0,0,1,3)           \
+    define(x##x##z##w, 0023, 0,0,2,3)           \
+    define(x##x##w##x, 0030, 0,0,3,0)           \
+    define(x##x##w##y, 0031, 0,0,3,1)           \
+    define(x##x##w##z, 0032, 0,0,3,2)           \
+    define(x##x##w##w, 0033, 0,0,3,3)           \
+    define(x##y##x##w, 0103, 0,1,0,3)           \
+    define(x##y##y##w, 0113, 0,1,1,3)           \
+    define(x##y##z##w, 0123, 0,1,2,3)           \
+    define(x##y##w##x, 0130, 0,1,3,0)           \
+    define(x##y##w##y, 0131, 0,1,3,1)           \
+    define(x##y##w##z, 0132, 0,1,3,2)           \
+    define(x##y##w##w, 0133, 0,1,3,3)           \
+    define(x##z##x##w, 0203, 0,2,0,3)           \
+    define(x##z##y##w, 0213, 0,2,1,3)           \
+    define(x##z##z##w, 0223, 0,2,2,3)           \
+    define(x##z##w##x, 0230, 0,2,3,0)           \
+    define(x##z##w##y, 0231, 0,2,3,1)           \
+    define(x##z##w##z, 0232, 0,2,3,2)           \
+    define(x##z##w##w, 0233, 0,2,3,3)           \
+    define(x##w##x##x, 0300, 0,3,0,0)           \
+    define(x##w##x##y, 0301, 0,3,0,1)           \
+    define(x##w##x##z, 0302, 0,3,0,2)           \
+    define(x##w##x##w, 0303, 0,3,0,3)           \
+    define(x##w##y##x, 0310, 0,3,1,0)           \
+    define(x##w##y##y, 0311, 0,3,1,1)           \
+    define(x##w##y##z, 0312, 0,3,1,2)           \
+    define(x##w##y##w, 0313, 0,3,1,3)           \
+    define(x##w##z##x, 0320, 0,3,2,0)           \
+    define(x##w##z##y, 0321, 0,3,2,1)           \
+    define(x##w##z##z, 0322, 0,3,2,2)           \
+    define(x##w##z##w, 0323, 0,3,2,3)           \
+    define(x##w##w##x, 0330, 0,3,3,0)           \
+    define(x##w##w##y, 0331, 0,3,3,1)           \
+    define(x##w##w##z, 0332, 0,3,3,2)           \
+    define(x##w##w##w, 0333, 0,3,3,3)           \
+    define(y##x##x##w, 1003, 1,0,0,3)           \
+    define(y##x##y##w, 1013, 1,0,1,3)           \
+    define(y##x##z##w, 1023, 1,0,2,3)           \
+    define(y##x##w##x, 1030, 1,0,3,0)           \
+    define(y##x##w##y, 1031, 1,0,3,1)           \
+    define(y##x##w##z, 1032, 1,0,3,2)           \
+    define(y##x##w##w, 1033, 1,0,3,3)           \
+    define(y##y##x##w, 1103, 1,1,0,3)           \
+    define(y##y##y##w, 1113, 1,1,1,3)           \
+    define(y##y##z##w, 1123, 1,1,2,3)           \
+    define(y##y##w##x, 1130, 1,1,3,0)           \
+    define(y##y##w##y, 1131, 1,1,3,1)           \
+    define(y##y##w##z, 1132, 1,1,3,2)           \
+    define(y##y##w##w, 1133, 1,1,3,3)           \
+    define(y##z##x##w, 1203, 1,2,0,3)           \
+    define(y##z##y##w, 1213, 1,2,1,3)           \
+    define(y##z##z##w, 1223, 1,2,2,3)           \
+    define(y##z##w##x, 1230, 1,2,3,0)           \
+    define(y##z##w##y, 1231, 1,2,3,1)           \
+    define(y##z##w##z, 1232, 1,2,3,2)           \
+    define(y##z##w##w, 1233, 1,2,3,3)           \
+    define(y##w##x##x, 1300, 1,3,0,0)           \
+    define(y##w##x##y, 1301, 1,3,0,1)           \
+    define(y##w##x##z, 1302, 1,3,0,2)           \
+    define(y##w##x##w, 1303, 1,3,0,3)           \
+    define(y##w##y##x, 1310, 1,3,1,0)           \
+    define(y##w##y##y, 1311, 1,3,1,1)           \
+    define(y##w##y##z, 1312, 1,3,1,2)           \
+    define(y##w##y##w, 1313, 1,3,1,3)           \
+    define(y##w##z##x, 1320, 1,3,2,0)           \
+    define(y##w##z##y, 1321, 1,3,2,1)           \
+    define(y##w##z##z, 1322, 1,3,2,2)           \
+    define(y##w##z##w, 1323, 1,3,2,3)           \
+    define(y##w##w##x, 1330, 1,3,3,0)           \
+    define(y##w##w##y, 1331, 1,3,3,1)           \
+    define(y##w##w##z, 1332, 1,3,3,2)           \
+    define(y##w##w##w, 1333, 1,3,3,3)           \
+    define(z##x##x##w, 2003, 2,0,0,3)           \
+    define(z##x##y##w, 2013, 2,0,1,3)           \
+    define(z##x##z##w, 2023, 2,0,2,3)           \
+    define(z##x##w##x, 2030, 2,0,3,0)           \
+    define(z##x##w##y, 2031, 2,0,3,1)           \
+    define(z##x##w##z, 2032, 2,0,3,2)           \
+    define(z##x##w##w, 2033, 2,0,3,3)           \
+    define(z##y##x##w, 2103, 2,1,0,3)           \
+    define(z##y##y##w, 2113, 2,1,1,3)           \
+    define(z##y##z##w, 2123, 2,1,2,3)           \
+    define(z##y##w##x, 2130, 2,1,3,0)           \
+    define(z##y##w##y, 2131, 2,1,3,1)           \
+    define(z##y##w##z, 2132, 2,1,3,2)           \
+    define(z##y##w##w, 2133, 2,1,3,3)           \
+    define(z##z##x##w, 2203, 2,2,0,3)           \
+    define(z##z##y##w, 2213, 2,2,1,3)           \
+    define(z##z##z##w, 2223, 2,2,2,3)           \
+    define(z##z##w##x, 2230, 2,2,3,0)           \
+    define(z##z##w##y, 2231, 2,2,3,1)           \
+    define(z##z##w##z, 2232, 2,2,3,2)           \
+    define(z##z##w##w, 2233, 2,2,3,3)           \
+    define(z##w##x##x, 2300, 2,3,0,0)           \
+    define(z##w##x##y, 2301, 2,3,0,1)           \
+    define(z##w##x##z, 2302, 2,3,0,2)           \
+    define(z##w##x##w, 2303, 2,3,0,3)           \
+    define(z##w##y##x, 2310, 2,3,1,0)           \
+    define(z##w##y##y, 2311, 2,3,1,1)           \
+    define(z##w##y##z, 2312, 2,3,1,2)           \
+    define(z##w##y##w, 2313, 2,3,1,3)           \
+    define(z##w##z##x, 2320, 2,3,2,0)           \
+    define(z##w##z##y, 2321, 2,3,2,1)           \
+    define(z##w##z##z, 2322, 2,3,2,2)           \
+    define(z##w##z##w, 2323, 2,3,2,3)           \
+    define(z##w##w##x, 2330, 2,3,3,0)           \
+    define(z##w##w##y, 2331, 2,3,3,1)           \
+    define(z##w##w##z, 2332, 2,3,3,2)           \
+    define(z##w##w##w, 2333, 2,3,3,3)           \
+    define(w##x##x##x, 3000, 3,0,0,0)           \
+    define(w##x##x##y, 3001, 3,0,0,1)           \
+    define(w##x##x##z, 3002, 3,0,0,2)           \
+    define(w##x##x##w, 3003, 3,0,0,3)           \
+    define(w##x##y##x, 3010, 3,0,1,0)           \
+    define(w##x##y##y, 3011, 3,0,1,1)           \
+    define(w##x##y##z, 3012, 3,0,1,2)           \
+    define(w##x##y##w, 3013, 3,0,1,3)           \
+    define(w##x##z##x, 3020, 3,0,2,0)           \
+    define(w##x##z##y, 3021, 3,0,2,1)           \
+    define(w##x##z##z, 3022, 3,0,2,2)           \
+    define(w##x##z##w, 3023, 3,0,2,3)           \
+    define(w##x##w##x, 3030, 3,0,3,0)           \
+    define(w##x##w##y, 3031, 3,0,3,1)           \
+    define(w##x##w##z, 3032, 3,0,3,2)           \
+    define(w##x##w##w, 3033, 3,0,3,3)           \
+    define(w##y##x##x, 3100, 3,1,0,0)           \
+    define(w##y##x##y, 3101, 3,1,0,1)           \
+    define(w##y##x##z, 3102, 3,1,0,2)           \
+    define(w##y##x##w, 3103, 3,1,0,3)           \
+    define(w##y##y##x, 3110, 3,1,1,0)           \
+    define(w##y##y##y, 3111, 3,1,1,1)           \
+    define(w##y##y##z, 3112, 3,1,1,2)           \
+    define(w##y##y##w, 3113, 3,1,1,3)           \
+    define(w##y##z##x, 3120, 3,1,2,0)           \
+    define(w##y##z##y, 3121, 3,1,2,1)           \
+    define(w##y##z##z, 3122, 3,1,2,2)           \
+    define(w##y##z##w, 3123, 3,1,2,3)           \
+    define(w##y##w##x, 3130, 3,1,3,0)           \
+    define(w##y##w##y, 3131, 3,1,3,1)           \
+    define(w##y##w##z, 3132, 3,1,3,2)           \
+    define(w##y##w##w, 3133, 3,1,3,3)           \
+    define(w##z##x##x, 3200, 3,2,0,0)           \
+    define(w##z##x##y, 3201, 3,2,0,1)           \
+    define(w##z##x##z, 3202, 3,2,0,2)           \
+    define(w##z##x##w, 3203, 3,2,0,3)           \
+    define(w##z##y##x, 3210, 3,2,1,0)           \
+    define(w##z##y##y, 3211, 3,2,1,1)           \
+    define(w##z##y##z, 3212, 3,2,1,2)           \
+    define(w##z##y##w, 3213, 3,2,1,3)           \
+    define(w##z##z##x, 3220, 3,2,2,0)           \
+    define(w##z##z##y, 3221, 3,2,2,1)           \
+    define(w##z##z##z, 3222, 3,2,2,2)           \
+    define(w##z##z##w, 3223, 3,2,2,3)           \
+    define(w##z##w##x, 3230, 3,2,3,0)           \
+    define(w##z##w##y, 3231, 3,2,3,1)           \
+    define(w##z##w##z, 3232, 3,2,3,2)           \
+    define(w##z##w##w, 3233, 3,2,3,3)           \
+    define(w##w##x##x, 3300, 3,3,0,0)           \
+    define(w##w##x##y, 3301, 3,3,0,1)           \
+    define(w##w##x##z, 3302, 3,3,0,2)           \
+    define(w##w##x##w, 3303, 3,3,0,3)           \
+    define(w##w##y##x, 3310, 3,3,1,0)           \
+    define(w##w##y##y, 3311, 3,3,1,1)           \
+    define(w##w##y##z, 3312, 3,3,1,2)           \
+    define(w##w##y##w, 3313, 3,3,1,3)           \
+    define(w##w##z##x, 3320, 3,3,2,0)           \
+    define(w##w##z##y, 3321, 3,3,2,1)           \
+    define(w##w##z##z, 3322, 3,3,2,2)           \
+    define(w##w##z##w, 3323, 3,3,2,3)           \
+    define(w##w##w##x, 3330, 3,3,3,0)           \
+    define(w##w##w##y, 3331, 3,3,3,1)           \
+    define(w##w##w##z, 3332, 3,3,3,2)           \
+    define(w##w##w##w, 3333, 3,3,3,3)
 
 namespace math {
+    // batch calls check once that every span or stream they read or write holds $2 elements, instead of
+    // running past a short one
+    inline constexpr void require_size(size_t $1, size_t $2, char const* $3) {
+        if ($1 < $2) {
+            throw std::length_error($3);
+        }
+    }
+
     template<typename T, typename U>
     using forward_like_t = std::conditional_t<
         std::is_rvalue_reference_v<T&&>,
@@ -446,19 +454,121 @@ namespace math {
     >;
 
     template<typename T, size_t Len, typename = std::make_index_sequence<Len>>
+    struct vec_scalar;
+
+    template<typename T, size_t Len>
     struct vec_impl;
 
     template<typename T, size_t Cols, size_t Rows, typename = std::make_index_sequence<Cols>, typename = std::make_index_sequence<Rows>>
+    struct mat_scalar;
+
+    template<typename T, size_t Cols, size_t Rows>
     struct mat_impl;
 
     export template<typename T, size_t Len>
-    struct vec_t final {
-        using Self = vec_t;
+    struct vec_t;
+
+    // storage-free type of every swizzle property
+    struct swizzle_property {};
+
+    template<size_t... I>
+    struct swizzle {
+        template<typename T>
+        using value = vec_t<T, sizeof...(I)>;
+
+        inline static constexpr bool distinct = [] {
+            size_t indices[] = {I...};
+            for (size_t i = 0; i < sizeof...(I); ++i) {
+                for (size_t j = i + 1; j < sizeof...(I); ++j) {
+                    if (indices[i] == indices[j]) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }();
+
+        template<typename T, size_t Len>
+        inline static constexpr auto get(vec_t<T, Len> const& $1) -> value<T> {
+            static_assert(((I < Len) && ...), "swizzle component out of range");
+            return value<T>{$1.__fields[I]...};
+        }
+
+        template<typename T, size_t Len>
+        inline static constexpr void put(vec_t<T, Len>& $1, std::type_identity_t<value<T>> const& $2) {
+            static_assert(((I < Len) && ...), "swizzle component out of range");
+            static_assert(distinct, "vector is not assignable (contains duplicate components)");
+            size_t i = 0;
+            (($1.__fields[I] = $2.__fields[i++]), ...);
+        }
+    };
+
+    template<size_t I>
+    struct swizzle<I> {
+        template<typename T>
+        using value = T;
+
+        template<typename T, size_t Len>
+        inline static constexpr auto get(vec_t<T, Len> const& $1) -> T {
+            static_assert(I < Len, "swizzle component out of range");
+            return $1.__fields[I];
+        }
+
+        template<typename T, size_t Len>
+        inline static constexpr void put(vec_t<T, Len>& $1, std::type_identity_t<T> const& $2) {
+            static_assert(I < Len, "swizzle component out of range");
+            $1.__fields[I] = $2;
+        }
+    };
 
+    // The swizzles valid for Len. The specializations are ordinary classes, so their properties and
+    // accessor declarations are parsed once per length instead of once per vec_t<T, Len>, and vec2
+    // never declares the z/w swizzles. Lengths past 4 get the vec4 set.
+#define DEFINE_SWIZZLES(n)                                                  \
+    DEFINE_PROPERTIES_##n(DEFINE_SWIZZLE, x, y, z, w)                       \
+    DEFINE_PROPERTIES_##n(DEFINE_SWIZZLE_ALIAS, r, g, b, a)                 \
+    friend constexpr auto operator<=>(swizzles const& $1, swizzles const& $2) = default;
+
+    template<size_t Len>
+    struct swizzles;
+
+    template<>
+    struct swizzles<1> {
+        DEFINE_SWIZZLES(1)
+    };
+
+    template<>
+    struct swizzles<2> {
+        DEFINE_SWIZZLES(2)
+    };
+
+    template<>
+    struct swizzles<3> {
+        DEFINE_SWIZZLES(3)
+    };
+
+    template<>
+    struct swizzles<4> {
+        DEFINE_SWIZZLES(4)
+    };
+
+    template<size_t Len>
+    struct swizzles : swizzles<4> {};
+
+#undef DEFINE_SWIZZLES
+
+    // the components come first, so vec_t{a, b, c} initializes them by brace elision and the empty
+    // swizzles<Len> base after them is value-initialized
+    template<typename T, size_t Len>
+    struct vec_storage {
         T __fields[Len];
 
-        DEFINE_PROPERTIES(x, y, z, w)
-        DEFINE_PROPERTIES(r, g, b, a)
+        friend constexpr auto operator<=>(vec_storage const& $1, vec_storage const& $2) = default;
+    };
+
+    export template<typename T, size_t Len>
+    struct vec_t final : vec_storage<T, Len>, swizzles<Len> {
+        using Self = vec_t;
 
         friend constexpr auto operator<=>(Self const& $1, Self const& $2) = default;
 
@@ -559,6 +669,53 @@ namespace math {
         }
     };
 
+    template<size_t Size>
+    using mask_bits = std::conditional_t<Size == 1, uint8_t, std::conditional_t<Size == 2, uint16_t, std::conditional_t<Size == 4, uint32_t, uint64_t>>>;
+
+    // per-lane comparison result; each lane is all ones or all zeros and as wide as T, so it feeds SIMD blends directly
+    export template<typename T, size_t Len>
+    struct mask_t final {
+        using Self = mask_t;
+        using Bits = mask_bits<sizeof(T)>;
+
+        Bits __fields[Len];
+
+        friend constexpr auto operator==(Self const& $1, Self const& $2) -> bool = default;
+
+        constexpr auto operator[](this Self const& self, size_t i) -> bool {
+            return self.__fields[i] != 0;
+        }
+
+        friend constexpr auto operator&(Self const& $1, Self const& $2) -> Self {
+            Self out{};
+            for (size_t i = 0; i < Len; i += 1) {
+                out.__fields[i] = $1.__fields[i] & $2.__fields[i];
+            }
+            return out;
+        }
+        friend constexpr auto operator|(Self const& $1, Self const& $2) -> Self {
+            Self out{};
+            for (size_t i = 0; i < Len; i += 1) {
+                out.__fields[i] = $1.__fields[i] | $2.__fields[i];
+            }
+            return out;
+        }
+        friend constexpr auto operator^(Self const& $1, Self const& $2) -> Self {
+            Self out{};
+            for (size_t i = 0; i < Len; i += 1) {
+                out.__fields[i] = $1.__fields[i] ^ $2.__fields[i];
+            }
+            return out;
+        }
+        friend constexpr auto operator!(Self const& $1) -> Self {
+            Self out{};
+            for (size_t i = 0; i < Len; i += 1) {
+                out.__fields[i] = static_cast<Bits>(~$1.__fields[i]);
+            }
+            return out;
+        }
+    };
+
     export template<typename T, size_t Cols, size_t Rows>
     struct mat_t final {
         using Self = mat_t;
@@ -582,99 +739,99 @@ namespace math {
         }
     };
 
-    export template<typename T, size_t Len, size_t... I>
-    struct vec_impl<T, Len, std::index_sequence<I...>> {
+    template<typename T, size_t Len, size_t... I>
+    struct vec_scalar<T, Len, std::index_sequence<I...>> {
         using Self = vec_t<T, Len>;
 
         inline static constexpr auto add(Self const& $1, Self const& $2) -> Self {
-            return Self{($1[I] + $2[I]) ...};
+            return Self{static_cast<T>($1[I] + $2[I])...};
         }
         inline static constexpr auto sub(Self const& $1, Self const& $2) -> Self {
-            return Self{($1[I] - $2[I]) ...};
+            return Self{static_cast<T>($1[I] - $2[I])...};
         }
         inline static constexpr auto mul(Self const& $1, Self const& $2) -> Self {
-            return Self{($1[I] * $2[I]) ...};
+            return Self{static_cast<T>($1[I] * $2[I])...};
         }
         inline static constexpr auto div(Self const& $1, Self const& $2) -> Self {
-            return Self{($1[I] / $2[I]) ...};
+            return Self{static_cast<T>($1[I] / $2[I])...};
         }
         inline static constexpr auto mod(Self const& $1, Self const& $2) -> Self {
-            return Self{($1[I] % $2[I]) ...};
+            return Self{static_cast<T>($1[I] % $2[I])...};
         }
         inline static constexpr auto shl(Self const& $1, Self const& $2) -> Self {
-            return Self{($1[I] << $2[I]) ...};
+            return Self{static_cast<T>($1[I] << $2[I])...};
         }
         inline static constexpr auto shr(Self const& $1, Self const& $2) -> Self {
-            return Self{($1[I] >> $2[I]) ...};
+            return Self{static_cast<T>($1[I] >> $2[I])...};
         }
         inline static constexpr auto band(Self const& $1, Self const& $2) -> Self {
-            return Self{($1[I] & $2[I]) ...};
+            return Self{static_cast<T>($1[I] & $2[I])...};
         }
         inline static constexpr auto bor(Self const& $1, Self const& $2) -> Self {
-            return Self{($1[I] | $2[I]) ...};
+            return Self{static_cast<T>($1[I] | $2[I])...};
         }
         inline static constexpr auto bxor(Self const& $1, Self const& $2) -> Self {
-            return Self{($1[I] ^ $2[I]) ...};
+            return Self{static_cast<T>($1[I] ^ $2[I])...};
         }
         inline static constexpr auto add(Self const& $1, T const& $2) -> Self {
-            return Self{($1[I] + $2) ...};
+            return Self{static_cast<T>($1[I] + $2)...};
         }
         inline static constexpr auto sub(Self const& $1, T const& $2) -> Self {
-            return Self{($1[I] - $2) ...};
+            return Self{static_cast<T>($1[I] - $2)...};
         }
         inline static constexpr auto mul(Self const& $1, T const& $2) -> Self {
-            return Self{($1[I] * $2) ...};
+            return Self{static_cast<T>($1[I] * $2)...};
         }
         inline static constexpr auto div(Self const& $1, T const& $2) -> Self {
-            return Self{($1[I] / $2) ...};
+            return Self{static_cast<T>($1[I] / $2)...};
         }
         inline static constexpr auto mod(Self const& $1, T const& $2) -> Self {
-            return Self{($1[I] % $2) ...};
+            return Self{static_cast<T>($1[I] % $2)...};
         }
         inline static constexpr auto shl(Self const& $1, T const& $2) -> Self {
-            return Self{($1[I] << $2) ...};
+            return Self{static_cast<T>($1[I] << $2)...};
         }
         inline static constexpr auto shr(Self const& $1, T const& $2) -> Self {
-            return Self{($1[I] >> $2) ...};
+            return Self{static_cast<T>($1[I] >> $2)...};
         }
         inline static constexpr auto band(Self const& $1, T const& $2) -> Self {
-            return Self{($1[I] & $2) ...};
+            return Self{static_cast<T>($1[I] & $2)...};
         }
         inline static constexpr auto bor(Self const& $1, T const& $2) -> Self {
-            return Self{($1[I] | $2) ...};
+            return Self{static_cast<T>($1[I] | $2)...};
         }
         inline static constexpr auto bxor(Self const& $1, T const& $2) -> Self {
-            return Self{($1[I] ^ $2) ...};
+            return Self{static_cast<T>($1[I] ^ $2)...};
         }
         inline static constexpr auto add(T const& $1, Self const& $2) -> Self {
-            return Self{($1 + $2[I]) ...};
+            return Self{static_cast<T>($1 + $2[I])...};
         }
         inline static constexpr auto sub(T const& $1, Self const& $2) -> Self {
-            return Self{($1 - $2[I]) ...};
+            return Self{static_cast<T>($1 - $2[I])...};
         }
         inline static constexpr auto mul(T const& $1, Self const& $2) -> Self {
-            return Self{($1 * $2[I]) ...};
+            return Self{static_cast<T>($1 * $2[I])...};
         }
         inline static constexpr auto div(T const& $1, Self const& $2) -> Self {
-            return Self{($1 / $2[I]) ...};
+            return Self{static_cast<T>($1 / $2[I])...};
         }
         inline static constexpr auto mod(T const& $1, Self const& $2) -> Self {
-            return Self{($1 % $2[I]) ...};
+            return Self{static_cast<T>($1 % $2[I])...};
         }
         inline static constexpr auto shl(T const& $1, Self const& $2) -> Self {
-            return Self{($1 << $2[I]) ...};
+            return Self{static_cast<T>($1 << $2[I])...};
         }
         inline static constexpr auto shr(T const& $1, Self const& $2) -> Self {
-            return Self{($1 >> $2[I]) ...};
+            return Self{static_cast<T>($1 >> $2[I])...};
         }
         inline static constexpr auto band(T const& $1, Self const& $2) -> Self {
-            return Self{($1 & $2[I]) ...};
+            return Self{static_cast<T>($1 & $2[I])...};
         }
         inline static constexpr auto bor(T const& $1, Self const& $2) -> Self {
-            return Self{($1 | $2[I]) ...};
+            return Self{static_cast<T>($1 | $2[I])...};
         }
         inline static constexpr auto bxor(T const& $1, Self const& $2) -> Self {
-            return Self{($1 ^ $2[I]) ...};
+            return Self{static_cast<T>($1 ^ $2[I])...};
         }
         inline static constexpr auto dot(Self const& $1, Self const& $2) -> T {
             return (($1[I] * $2[I]) + ...);
@@ -713,9 +870,12 @@ namespace math {
         inline static constexpr auto sign(Self const& $1) -> Self {
             return Self{($1[I] < static_cast<T>(0) ? static_cast<T>(-1) : ($1[I] > static_cast<T>(0) ? static_cast<T>(1) : static_cast<T>(0)))...};
         }
-        inline static constexpr auto normalize(Self const& $1) -> T requires std::floating_point<T> {
+        inline static constexpr auto normalize(Self const& $1) -> Self requires std::floating_point<T> {
             return $1 / length($1);
         }
+        inline static constexpr auto normalize_fast(Self const& $1) -> Self requires std::floating_point<T> {
+            return $1 * (T(1) / length($1));
+        }
         inline static constexpr auto abs(Self const& $1) -> Self {
             return Self{std::abs($1[I])...};
         }
@@ -725,242 +885,7129 @@ namespace math {
         inline static constexpr auto max(Self const& $1, Self const& $2) -> Self {
             return Self{($1[I] > $2[I] ? $1[I] : $2[I])...};
         }
-    };
+        inline static constexpr auto broadcast(T const& $1) -> Self {
+            return Self{((void) I, $1)...};
+        }
 
-    export template<typename T, size_t Cols, size_t Rows, size_t... Ci, size_t... Ri>
-    struct mat_impl<T, Cols, Rows, std::index_sequence<Ci...>, std::index_sequence<Ri...>> {
-        using Self = mat_t<T, Cols, Rows>;
+        using Mask = mask_t<T, Len>;
+        using Bits = typename Mask::Bits;
 
-        inline static constexpr auto col(Self const& self, size_t i) -> vec_t<T, Rows> {
-            return self.__columns[i];
+        inline static constexpr auto lt(Self const& $1, Self const& $2) -> Mask {
+            return Mask{static_cast<Bits>($1[I] < $2[I] ? ~Bits(0) : Bits(0))...};
         }
-        inline static constexpr auto row(Self const& self, size_t i) -> vec_t<T, Cols> {
-            return vec_t<T, Cols>{self.__columns[Ci][i]...};
+        inline static constexpr auto le(Self const& $1, Self const& $2) -> Mask {
+            return Mask{static_cast<Bits>($1[I] <= $2[I] ? ~Bits(0) : Bits(0))...};
         }
-        inline static constexpr auto mul(Self const& $1, Self const& $2) -> Self {
-            return Self{$1 * $2.__columns[Ci]...};
+        inline static constexpr auto gt(Self const& $1, Self const& $2) -> Mask {
+            return Mask{static_cast<Bits>($1[I] > $2[I] ? ~Bits(0) : Bits(0))...};
         }
-        inline static constexpr auto mul(Self const& $1, vec_t<T, Cols> const& $2) -> vec_t<T, Cols> {
-            return (($1.__columns[Ci] * $2[Ci]) + ...);
+        inline static constexpr auto ge(Self const& $1, Self const& $2) -> Mask {
+            return Mask{static_cast<Bits>($1[I] >= $2[I] ? ~Bits(0) : Bits(0))...};
         }
-        inline static constexpr auto mul(vec_t<T, Cols> const& $1, Self const& $2) -> vec_t<T, Cols> {
-            return (($1[Ci] * $2.row(Ri)) + ...);
+        inline static constexpr auto eq(Self const& $1, Self const& $2) -> Mask {
+            return Mask{static_cast<Bits>($1[I] == $2[I] ? ~Bits(0) : Bits(0))...};
+        }
+        inline static constexpr auto ne(Self const& $1, Self const& $2) -> Mask {
+            return Mask{static_cast<Bits>($1[I] != $2[I] ? ~Bits(0) : Bits(0))...};
+        }
+        inline static constexpr auto select(Mask const& $1, Self const& $2, Self const& $3) -> Self {
+            return Self{($1.__fields[I] != 0 ? $2[I] : $3[I])...};
+        }
+        inline static constexpr auto movemask(Mask const& $1) -> uint32_t {
+            return ((uint32_t($1.__fields[I] != 0) << I) | ...);
         }
     };
 
     export template<typename T, size_t Len>
-    inline constexpr auto dot(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> T {
-        return vec_impl<T, Len>::dot($1, $2);
-    }
-    export template<typename T, size_t Len>
-    inline constexpr auto csum(vec_t<T, Len> const& $1) -> T {
-        return vec_impl<T, Len>::csum($1);
-    }
-    export template<typename U, typename T, size_t Len>
-    inline constexpr auto cast(vec_t<T, Len> const& $1) -> vec_t<U, Len> {
-        return vec_impl<T, Len>::template cast<U>($1);
-    }
-    export template<std::floating_point T, size_t Len>
-    inline constexpr auto floor(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::floor($1);
-    }
-    export template<std::floating_point T, size_t Len>
-    inline constexpr auto ceil(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::ceil($1);
-    }
-    export template<std::floating_point T, size_t Len>
-    inline constexpr auto round(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::round($1);
-    }
-    export template<std::floating_point T, size_t Len>
-    inline constexpr auto sin(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::sin($1);
-    }
-    export template<std::floating_point T, size_t Len>
-    inline constexpr auto cos(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::cos($1);
-    }
-    export template<std::floating_point T, size_t Len>
-    inline constexpr auto sqrt(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::sqrt($1);
-    }
-    export template<std::floating_point T, size_t Len>
-    inline constexpr auto fract(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::fract($1);
-    }
-    export template<std::floating_point T, size_t Len>
-    inline constexpr auto length(vec_t<T, Len> const& $1) -> T {
-        return vec_impl<T, Len>::length($1);
-    }
-    export template<typename T, size_t Len>
-    inline constexpr auto sign(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::sign($1);
-    }
-    export template<std::floating_point T, size_t Len>
-    inline constexpr auto normalize(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::normalize($1);
-    }
-    export template<typename T, size_t Len>
-    inline constexpr auto abs(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::abs($1);
-    }
-    export template<typename T, size_t Len>
-    inline constexpr auto min(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::min($1, $2);
-    }
-    export template<typename T, size_t Len>
-    inline constexpr auto max(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> vec_t<T, Len> {
-        return vec_impl<T, Len>::max($1, $2);
-    }
-
-    export template<typename T>
-    inline constexpr auto vec2(T $1) -> vec_t<T, 2> {
-        return vec_t<T, 2>{$1, $1};
-    }
-    export template<typename T>
-    inline constexpr auto vec2(T $1, T $2)  -> vec_t<T, 2> {
-        return vec_t<T, 2>{$1, $2};
-    }
-    export template<typename T>
-    inline constexpr auto vec3(T $1) -> vec_t<T, 3> {
-        return vec_t<T, 3>{$1, $1, $1};
-    }
-    export template<typename T>
-    inline constexpr auto vec3(T $1, T $2, T $3) -> vec_t<T, 3> {
-        return vec_t<T, 3>{$1, $2, $3};
-    }
-    export template<typename T>
-    inline constexpr auto vec3(vec_t<T, 2> $1, T $2) -> vec_t<T, 3> {
-        return vec_t<T, 3>{$1.x, $1.y, $2};
-    }
-    export template<typename T>
-    inline constexpr auto vec3(T $1, vec_t<T, 2> $2) -> vec_t<T, 3> {
-        return vec_t<T, 3>{$1, $2.x, $2.y};
-    }
-    export template<typename T>
-    inline constexpr auto vec4(T $1) -> vec_t<T, 4> {
-        return vec_t<T, 4>{$1, $1, $1, $1};
-    }
-    export template<typename T>
-    inline constexpr auto vec4(T $1, T $2, T $3, T $4) -> vec_t<T, 4> {
-        return vec_t<T, 4>{$1, $2, $3, $4};
-    }
-    export template<typename T>
-    inline constexpr auto vec4(vec_t<T, 2> $1, T $2, T $3) -> vec_t<T, 4> {
-        return vec_t<T, 4>{$1.x, $1.y, $2, $3};
-    }
-    export template<typename T>
-    inline constexpr auto vec4(T $1, vec_t<T, 2> $2, T $3) -> vec_t<T, 4> {
-        return vec_t<T, 4>{$1, $2.x, $2.y, $3};
-    }
-    export template<typename T>
-    inline constexpr auto vec4(T $1, T $2, vec_t<T, 2> $3) -> vec_t<T, 4> {
-        return vec_t<T, 4>{$1, $2, $3.x, $3.y};
-    }
-    export template<typename T>
-    inline constexpr auto vec4(vec_t<T, 2> $1, vec_t<T, 2> $2) -> vec_t<T, 4> {
-        return vec_t<T, 4>{$1.x, $1.y, $2.x, $2.y};
-    }
-    export template<typename T>
-    inline constexpr auto vec4(vec_t<T, 3> $1, T $2) -> vec_t<T, 4> {
-        return vec_t<T, 4>{$1.x, $1.y, $1.z, $2};
-    }
-    export template<typename T>
-    inline constexpr auto vec4(T $1, vec_t<T, 3> $2) -> vec_t<T, 4> {
-        return vec_t<T, 4>{$1, $2.x, $2.y, $2.z};
-    }
-
-    export template<typename T>
-    inline constexpr auto mat2x2(mat_t<T, 3, 3> const& $1) -> mat_t<T, 2, 2> {
-        return {
-            $1.__columns[0].xy,
-            $1.__columns[1].xy,
-        };
-    }
-
-    export template<typename T>
-    inline constexpr auto mat3x3(mat_t<T, 4, 4> const& $1) -> mat_t<T, 3, 3> {
-        return {
-            $1.__columns[0].xyz,
-            $1.__columns[1].xyz,
-            $1.__columns[2].xyz,
-        };
-    }
+    struct vec_impl : vec_scalar<T, Len> {};
 
-    export template<std::floating_point T>
-    inline constexpr auto inverse(mat_t<T, 4, 4> const& $1) -> mat_t<T, 4, 4> {
-        vec_t<T, 4> A = $1.row(0);
-        vec_t<T, 4> B = $1.row(1);
-        vec_t<T, 4> C = $1.row(2);
-        vec_t<T, 4> D = $1.row(3);
-
-        vec_t<T, 4> C2211 = C.zzyy;
-        vec_t<T, 4> B2211 = B.zzyy;
-        vec_t<T, 4> A2211 = A.zzyy;
-        vec_t<T, 4> D3332 = D.wwwz;
-        vec_t<T, 4> C3332 = C.wwwz;
-        vec_t<T, 4> B3332 = B.wwwz;
-        vec_t<T, 4> D2211 = D.zzyy;
-        vec_t<T, 4> A3332 = A.wwwz;
-        vec_t<T, 4> B1000 = B.yxxx;
-        vec_t<T, 4> A1000 = A.yxxx;
-        vec_t<T, 4> C1000 = C.yxxx;
-        vec_t<T, 4> D1000 = D.yxxx;
-
-        vec_t<T, 4> $00 = C2211 * D3332 - D2211 * C3332;
-        vec_t<T, 4> $01 = B2211 * D3332 - D2211 * B3332;
-        vec_t<T, 4> $02 = B2211 * C3332 - C2211 * B3332;
-        vec_t<T, 4> $03 = A2211 * D3332 - D2211 * A3332;
-        vec_t<T, 4> $04 = A2211 * C3332 - C2211 * A3332;
-        vec_t<T, 4> $05 = A2211 * B3332 - B2211 * A3332;
-
-        vec_t<T, 4> m00 = (B1000 * $00 - C1000 * $01 + D1000 * $02) * vec_t<T, 4>{+1, -1, +1, -1};
-        vec_t<T, 4> m01 = (A1000 * $00 - C1000 * $03 + D1000 * $04) * vec_t<T, 4>{-1, +1, -1, +1};
-        vec_t<T, 4> m02 = (A1000 * $01 - B1000 * $03 + D1000 * $05) * vec_t<T, 4>{+1, -1, +1, -1};
-        vec_t<T, 4> m03 = (A1000 * $02 - B1000 * $04 + C1000 * $05) * vec_t<T, 4>{-1, +1, -1, +1};
-
-        T det = dot(A, m00);
-        return {
-            m00 / det,
-            m01 / det,
-            m02 / det,
-            m03 / det
-        };
-    }
+#if defined(__SSE2__)
+    template<>
+    struct vec_impl<float, 4> : vec_scalar<float, 4> {
+        using Base = vec_scalar<float, 4>;
+        using Self = vec_t<float, 4>;
+        using Mask = mask_t<float, 4>;
 
-    export using i8vec2 = math::vec_t<int8_t, 2>;
-    export using i8vec3 = math::vec_t<int8_t, 3>;
-    export using i8vec4 = math::vec_t<int8_t, 4>;
-    export using i16vec2 = math::vec_t<int16_t, 2>;
-    export using i16vec3 = math::vec_t<int16_t, 3>;
-    export using i16vec4 = math::vec_t<int16_t, 4>;
-    export using i32vec2 = math::vec_t<int32_t, 2>;
-    export using i32vec3 = math::vec_t<int32_t, 3>;
-    export using i32vec4 = math::vec_t<int32_t, 4>;
-    export using i64vec2 = math::vec_t<int64_t, 2>;
-    export using i64vec3 = math::vec_t<int64_t, 3>;
-    export using i64vec4 = math::vec_t<int64_t, 4>;
+        using Base::add;
+        using Base::sub;
+        using Base::mul;
+        using Base::div;
+        using Base::min;
+        using Base::max;
+        using Base::abs;
+        using Base::sign;
+        using Base::floor;
+        using Base::ceil;
+        using Base::round;
+        using Base::sqrt;
+        using Base::dot;
+        using Base::csum;
 
-    export using u8vec2 = math::vec_t<uint8_t, 2>;
-    export using u8vec3 = math::vec_t<uint8_t, 3>;
-    export using u8vec4 = math::vec_t<uint8_t, 4>;
-    export using u16vec2 = math::vec_t<uint16_t, 2>;
-    export using u16vec3 = math::vec_t<uint16_t, 3>;
-    export using u16vec4 = math::vec_t<uint16_t, 4>;
-    export using u32vec2 = math::vec_t<uint32_t, 2>;
-    export using u32vec3 = math::vec_t<uint32_t, 3>;
-    export using u32vec4 = math::vec_t<uint32_t, 4>;
-    export using u64vec2 = math::vec_t<uint64_t, 2>;
-    export using u64vec3 = math::vec_t<uint64_t, 3>;
-    export using u64vec4 = math::vec_t<uint64_t, 4>;
+        inline static auto load(Self const& $1) -> __m128 {
+            return _mm_loadu_ps($1.__fields);
+        }
+        inline static auto load(float const& $1) -> __m128 {
+            return _mm_set1_ps($1);
+        }
+        inline static auto store(__m128 $1) -> Self {
+            Self out;
+            _mm_storeu_ps(out.__fields, $1);
+            return out;
+        }
+        inline static auto load(Mask const& $1) -> __m128 {
+            return _mm_loadu_ps(reinterpret_cast<float const*>($1.__fields));
+        }
+        inline static auto mask(__m128 $1) -> Mask {
+            Mask out;
+            _mm_storeu_ps(reinterpret_cast<float*>(out.__fields), $1);
+            return out;
+        }
+        // folds lanes as x + (y + (z + w)), the same order as the scalar fold expression
+        inline static auto reduce(__m128 $1) -> float {
+            __m128 zw = _mm_movehl_ps($1, $1);
+            __m128 sum = _mm_add_ss(_mm_shuffle_ps(zw, zw, 0b01), zw);
+            sum = _mm_add_ss(_mm_shuffle_ps($1, $1, 0b01), sum);
+            return _mm_cvtss_f32(_mm_add_ss($1, sum));
+        }
 
-    export using f32vec2 = math::vec_t<float_t, 2>;
-    export using f32vec3 = math::vec_t<float_t, 3>;
-    export using f32vec4 = math::vec_t<float_t, 4>;
+        inline static constexpr auto add(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::add($1, $2); } else { return store(_mm_add_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto sub(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::sub($1, $2); } else { return store(_mm_sub_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto mul(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::mul($1, $2); } else { return store(_mm_mul_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto div(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::div($1, $2); } else { return store(_mm_div_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto add(Self const& $1, float const& $2) -> Self {
+            if consteval { return Base::add($1, $2); } else { return store(_mm_add_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto sub(Self const& $1, float const& $2) -> Self {
+            if consteval { return Base::sub($1, $2); } else { return store(_mm_sub_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto mul(Self const& $1, float const& $2) -> Self {
+            if consteval { return Base::mul($1, $2); } else { return store(_mm_mul_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto div(Self const& $1, float const& $2) -> Self {
+            if consteval { return Base::div($1, $2); } else { return store(_mm_div_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto add(float const& $1, Self const& $2) -> Self {
+            if consteval { return Base::add($1, $2); } else { return store(_mm_add_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto sub(float const& $1, Self const& $2) -> Self {
+            if consteval { return Base::sub($1, $2); } else { return store(_mm_sub_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto mul(float const& $1, Self const& $2) -> Self {
+            if consteval { return Base::mul($1, $2); } else { return store(_mm_mul_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto div(float const& $1, Self const& $2) -> Self {
+            if consteval { return Base::div($1, $2); } else { return store(_mm_div_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto min(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::min($1, $2); } else { return store(_mm_min_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto max(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::max($1, $2); } else { return store(_mm_max_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto abs(Self const& $1) -> Self {
+            if consteval { return Base::abs($1); } else { return store(_mm_andnot_ps(_mm_set1_ps(-0.0f), load($1))); }
+        }
+        inline static constexpr auto sign(Self const& $1) -> Self {
+            if consteval {
+                return Base::sign($1);
+            } else {
+                __m128 v = load($1);
+                __m128 neg = _mm_and_ps(_mm_cmplt_ps(v, _mm_setzero_ps()), _mm_set1_ps(-1.0f));
+                __m128 pos = _mm_and_ps(_mm_cmpgt_ps(v, _mm_setzero_ps()), _mm_set1_ps(+1.0f));
+                return store(_mm_or_ps(neg, pos));
+            }
+        }
+        inline static constexpr auto sqrt(Self const& $1) -> Self {
+            if consteval { return Base::sqrt($1); } else { return store(_mm_sqrt_ps(load($1))); }
+        }
+        inline static constexpr auto dot(Self const& $1, Self const& $2) -> float {
+            if consteval { return Base::dot($1, $2); } else { return reduce(_mm_mul_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto csum(Self const& $1) -> float {
+            if consteval { return Base::csum($1); } else { return reduce(load($1)); }
+        }
+        inline static constexpr auto lt(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::lt($1, $2); } else { return mask(_mm_cmplt_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto le(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::le($1, $2); } else { return mask(_mm_cmple_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto gt(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::gt($1, $2); } else { return mask(_mm_cmpgt_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto ge(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::ge($1, $2); } else { return mask(_mm_cmpge_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto eq(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::eq($1, $2); } else { return mask(_mm_cmpeq_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto ne(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::ne($1, $2); } else { return mask(_mm_cmpneq_ps(load($1), load($2))); }
+        }
+        inline static constexpr auto select(Mask const& $1, Self const& $2, Self const& $3) -> Self {
+            if consteval {
+                return Base::select($1, $2, $3);
+            } else {
+#if defined(__SSE4_1__)
+                return store(_mm_blendv_ps(load($3), load($2), load($1)));
+#else
+                __m128 m = load($1);
+                return store(_mm_or_ps(_mm_and_ps(m, load($2)), _mm_andnot_ps(m, load($3))));
+#endif
+            }
+        }
+        inline static constexpr auto movemask(Mask const& $1) -> uint32_t {
+            if consteval { return Base::movemask($1); } else { return uint32_t(_mm_movemask_ps(load($1))); }
+        }
+        // rsqrt estimate refined by one Newton-Raphson step, about 22 bits
+        inline static constexpr auto normalize_fast(Self const& $1) -> Self {
+            if consteval {
+                return Base::normalize_fast($1);
+            } else {
+                __m128 v = load($1);
+                __m128 d = _mm_mul_ps(v, v);
+                d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+                d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+                __m128 r = _mm_rsqrt_ps(d);
+                r = _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), d), _mm_mul_ps(r, r))));
+                return store(_mm_mul_ps(v, r));
+            }
+        }
+#if defined(__SSE4_1__)
+        inline static constexpr auto floor(Self const& $1) -> Self {
+            if consteval { return Base::floor($1); } else { return store(_mm_floor_ps(load($1))); }
+        }
+        inline static constexpr auto ceil(Self const& $1) -> Self {
+            if consteval { return Base::ceil($1); } else { return store(_mm_ceil_ps(load($1))); }
+        }
+        // std::round breaks ties away from zero, so truncate and step out when the dropped fraction is >= 0.5
+        inline static constexpr auto round(Self const& $1) -> Self {
+            if consteval {
+                return Base::round($1);
+            } else {
+                __m128 v = load($1);
+                __m128 t = _mm_round_ps(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+                __m128 f = _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(v, t));
+                __m128 s = _mm_and_ps(v, _mm_set1_ps(-0.0f));
+                __m128 step = _mm_and_ps(_mm_cmpge_ps(f, _mm_set1_ps(0.5f)), _mm_set1_ps(1.0f));
+                return store(_mm_add_ps(t, _mm_or_ps(step, s)));
+            }
+        }
+#endif
+    };
+
+    template<>
+    struct vec_impl<int32_t, 4> : vec_scalar<int32_t, 4> {
+        using Base = vec_scalar<int32_t, 4>;
+        using Self = vec_t<int32_t, 4>;
+        using Mask = mask_t<int32_t, 4>;
+
+        using Base::add;
+        using Base::sub;
+        using Base::mul;
+        using Base::div;
+        using Base::min;
+        using Base::max;
+        using Base::abs;
+        using Base::sign;
+        using Base::dot;
+        using Base::csum;
+
+        inline static auto load(Self const& $1) -> __m128i {
+            return _mm_loadu_si128(reinterpret_cast<__m128i const*>($1.__fields));
+        }
+        inline static auto load(int32_t const& $1) -> __m128i {
+            return _mm_set1_epi32($1);
+        }
+        inline static auto store(__m128i $1) -> Self {
+            Self out;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out.__fields), $1);
+            return out;
+        }
+        inline static auto load(Mask const& $1) -> __m128i {
+            return _mm_loadu_si128(reinterpret_cast<__m128i const*>($1.__fields));
+        }
+        inline static auto mask(__m128i $1) -> Mask {
+            Mask out;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out.__fields), $1);
+            return out;
+        }
+        inline static auto reduce(__m128i $1) -> int32_t {
+            __m128i sum = _mm_add_epi32($1, _mm_shuffle_epi32($1, 0b01'00'11'10));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0b10'11'00'01));
+            return _mm_cvtsi128_si32(sum);
+        }
+        // every int32 quotient is exact in double, so truncating the double quotient matches integer division
+        inline static auto quotient(__m128i $1, __m128i $2) -> __m128i {
+#if defined(__AVX__)
+            return _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd($1), _mm256_cvtepi32_pd($2)));
+#else
+            __m128d lo = _mm_div_pd(_mm_cvtepi32_pd($1), _mm_cvtepi32_pd($2));
+            __m128d hi = _mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64($1, $1)), _mm_cvtepi32_pd(_mm_unpackhi_epi64($2, $2)));
+            return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+#endif
+        }
+
+        inline static constexpr auto add(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::add($1, $2); } else { return store(_mm_add_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto sub(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::sub($1, $2); } else { return store(_mm_sub_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto div(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::div($1, $2); } else { return store(quotient(load($1), load($2))); }
+        }
+        inline static constexpr auto add(Self const& $1, int32_t const& $2) -> Self {
+            if consteval { return Base::add($1, $2); } else { return store(_mm_add_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto sub(Self const& $1, int32_t const& $2) -> Self {
+            if consteval { return Base::sub($1, $2); } else { return store(_mm_sub_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto div(Self const& $1, int32_t const& $2) -> Self {
+            if consteval { return Base::div($1, $2); } else { return store(quotient(load($1), load($2))); }
+        }
+        inline static constexpr auto add(int32_t const& $1, Self const& $2) -> Self {
+            if consteval { return Base::add($1, $2); } else { return store(_mm_add_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto sub(int32_t const& $1, Self const& $2) -> Self {
+            if consteval { return Base::sub($1, $2); } else { return store(_mm_sub_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto div(int32_t const& $1, Self const& $2) -> Self {
+            if consteval { return Base::div($1, $2); } else { return store(quotient(load($1), load($2))); }
+        }
+        // SSE2 only has <, > and ==; the others are their complements
+        inline static constexpr auto lt(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::lt($1, $2); } else { return mask(_mm_cmplt_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto le(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::le($1, $2); } else { return mask(_mm_xor_si128(_mm_cmpgt_epi32(load($1), load($2)), _mm_set1_epi32(-1))); }
+        }
+        inline static constexpr auto gt(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::gt($1, $2); } else { return mask(_mm_cmpgt_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto ge(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::ge($1, $2); } else { return mask(_mm_xor_si128(_mm_cmplt_epi32(load($1), load($2)), _mm_set1_epi32(-1))); }
+        }
+        inline static constexpr auto eq(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::eq($1, $2); } else { return mask(_mm_cmpeq_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto ne(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::ne($1, $2); } else { return mask(_mm_xor_si128(_mm_cmpeq_epi32(load($1), load($2)), _mm_set1_epi32(-1))); }
+        }
+        inline static constexpr auto select(Mask const& $1, Self const& $2, Self const& $3) -> Self {
+            if consteval {
+                return Base::select($1, $2, $3);
+            } else {
+#if defined(__SSE4_1__)
+                return store(_mm_blendv_epi8(load($3), load($2), load($1)));
+#else
+                __m128i m = load($1);
+                return store(_mm_or_si128(_mm_and_si128(m, load($2)), _mm_andnot_si128(m, load($3))));
+#endif
+            }
+        }
+        inline static constexpr auto movemask(Mask const& $1) -> uint32_t {
+            if consteval { return Base::movemask($1); } else { return uint32_t(_mm_movemask_ps(_mm_castsi128_ps(load($1)))); }
+        }
+        inline static constexpr auto csum(Self const& $1) -> int32_t {
+            if consteval { return Base::csum($1); } else { return reduce(load($1)); }
+        }
+#if defined(__SSSE3__)
+        inline static constexpr auto abs(Self const& $1) -> Self {
+            if consteval { return Base::abs($1); } else { return store(_mm_abs_epi32(load($1))); }
+        }
+        inline static constexpr auto sign(Self const& $1) -> Self {
+            if consteval { return Base::sign($1); } else { return store(_mm_sign_epi32(_mm_set1_epi32(1), load($1))); }
+        }
+#endif
+#if defined(__SSE4_1__)
+        inline static constexpr auto mul(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::mul($1, $2); } else { return store(_mm_mullo_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto mul(Self const& $1, int32_t const& $2) -> Self {
+            if consteval { return Base::mul($1, $2); } else { return store(_mm_mullo_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto mul(int32_t const& $1, Self const& $2) -> Self {
+            if consteval { return Base::mul($1, $2); } else { return store(_mm_mullo_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto min(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::min($1, $2); } else { return store(_mm_min_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto max(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::max($1, $2); } else { return store(_mm_max_epi32(load($1), load($2))); }
+        }
+        inline static constexpr auto dot(Self const& $1, Self const& $2) -> int32_t {
+            if consteval { return Base::dot($1, $2); } else { return reduce(_mm_mullo_epi32(load($1), load($2))); }
+        }
+#endif
+    };
+#endif
+
+#if defined(__AVX__)
+    template<>
+    struct vec_impl<double, 4> : vec_scalar<double, 4> {
+        using Base = vec_scalar<double, 4>;
+        using Self = vec_t<double, 4>;
+        using Mask = mask_t<double, 4>;
+
+        using Base::add;
+        using Base::sub;
+        using Base::mul;
+        using Base::div;
+        using Base::min;
+        using Base::max;
+        using Base::abs;
+        using Base::sign;
+        using Base::floor;
+        using Base::ceil;
+        using Base::round;
+        using Base::sqrt;
+        using Base::dot;
+        using Base::csum;
+
+        inline static auto load(Self const& $1) -> __m256d {
+            return _mm256_loadu_pd($1.__fields);
+        }
+        inline static auto load(double const& $1) -> __m256d {
+            return _mm256_set1_pd($1);
+        }
+        inline static auto store(__m256d $1) -> Self {
+            Self out;
+            _mm256_storeu_pd(out.__fields, $1);
+            return out;
+        }
+        inline static auto load(Mask const& $1) -> __m256d {
+            return _mm256_loadu_pd(reinterpret_cast<double const*>($1.__fields));
+        }
+        inline static auto mask(__m256d $1) -> Mask {
+            Mask out;
+            _mm256_storeu_pd(reinterpret_cast<double*>(out.__fields), $1);
+            return out;
+        }
+        // folds lanes as x + (y + (z + w)), the same order as the scalar fold expression
+        inline static auto reduce(__m256d $1) -> double {
+            __m128d xy = _mm256_castpd256_pd128($1);
+            __m128d zw = _mm256_extractf128_pd($1, 1);
+            __m128d sum = _mm_add_sd(_mm_unpackhi_pd(zw, zw), zw);
+            sum = _mm_add_sd(_mm_unpackhi_pd(xy, xy), sum);
+            return _mm_cvtsd_f64(_mm_add_sd(xy, sum));
+        }
+
+        inline static constexpr auto add(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::add($1, $2); } else { return store(_mm256_add_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto sub(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::sub($1, $2); } else { return store(_mm256_sub_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto mul(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::mul($1, $2); } else { return store(_mm256_mul_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto div(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::div($1, $2); } else { return store(_mm256_div_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto add(Self const& $1, double const& $2) -> Self {
+            if consteval { return Base::add($1, $2); } else { return store(_mm256_add_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto sub(Self const& $1, double const& $2) -> Self {
+            if consteval { return Base::sub($1, $2); } else { return store(_mm256_sub_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto mul(Self const& $1, double const& $2) -> Self {
+            if consteval { return Base::mul($1, $2); } else { return store(_mm256_mul_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto div(Self const& $1, double const& $2) -> Self {
+            if consteval { return Base::div($1, $2); } else { return store(_mm256_div_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto add(double const& $1, Self const& $2) -> Self {
+            if consteval { return Base::add($1, $2); } else { return store(_mm256_add_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto sub(double const& $1, Self const& $2) -> Self {
+            if consteval { return Base::sub($1, $2); } else { return store(_mm256_sub_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto mul(double const& $1, Self const& $2) -> Self {
+            if consteval { return Base::mul($1, $2); } else { return store(_mm256_mul_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto div(double const& $1, Self const& $2) -> Self {
+            if consteval { return Base::div($1, $2); } else { return store(_mm256_div_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto min(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::min($1, $2); } else { return store(_mm256_min_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto max(Self const& $1, Self const& $2) -> Self {
+            if consteval { return Base::max($1, $2); } else { return store(_mm256_max_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto abs(Self const& $1) -> Self {
+            if consteval { return Base::abs($1); } else { return store(_mm256_andnot_pd(_mm256_set1_pd(-0.0), load($1))); }
+        }
+        inline static constexpr auto sign(Self const& $1) -> Self {
+            if consteval {
+                return Base::sign($1);
+            } else {
+                __m256d v = load($1);
+                __m256d neg = _mm256_and_pd(_mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_LT_OQ), _mm256_set1_pd(-1.0));
+                __m256d pos = _mm256_and_pd(_mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_GT_OQ), _mm256_set1_pd(+1.0));
+                return store(_mm256_or_pd(neg, pos));
+            }
+        }
+        inline static constexpr auto floor(Self const& $1) -> Self {
+            if consteval { return Base::floor($1); } else { return store(_mm256_floor_pd(load($1))); }
+        }
+        inline static constexpr auto ceil(Self const& $1) -> Self {
+            if consteval { return Base::ceil($1); } else { return store(_mm256_ceil_pd(load($1))); }
+        }
+        // std::round breaks ties away from zero, so truncate and step out when the dropped fraction is >= 0.5
+        inline static constexpr auto round(Self const& $1) -> Self {
+            if consteval {
+                return Base::round($1);
+            } else {
+                __m256d v = load($1);
+                __m256d t = _mm256_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+                __m256d f = _mm256_andnot_pd(_mm256_set1_pd(-0.0), _mm256_sub_pd(v, t));
+                __m256d s = _mm256_and_pd(v, _mm256_set1_pd(-0.0));
+                __m256d step = _mm256_and_pd(_mm256_cmp_pd(f, _mm256_set1_pd(0.5), _CMP_GE_OQ), _mm256_set1_pd(1.0));
+                return store(_mm256_add_pd(t, _mm256_or_pd(step, s)));
+            }
+        }
+        inline static constexpr auto sqrt(Self const& $1) -> Self {
+            if consteval { return Base::sqrt($1); } else { return store(_mm256_sqrt_pd(load($1))); }
+        }
+        inline static constexpr auto dot(Self const& $1, Self const& $2) -> double {
+            if consteval { return Base::dot($1, $2); } else { return reduce(_mm256_mul_pd(load($1), load($2))); }
+        }
+        inline static constexpr auto lt(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::lt($1, $2); } else { return mask(_mm256_cmp_pd(load($1), load($2), _CMP_LT_OQ)); }
+        }
+        inline static constexpr auto le(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::le($1, $2); } else { return mask(_mm256_cmp_pd(load($1), load($2), _CMP_LE_OQ)); }
+        }
+        inline static constexpr auto gt(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::gt($1, $2); } else { return mask(_mm256_cmp_pd(load($1), load($2), _CMP_GT_OQ)); }
+        }
+        inline static constexpr auto ge(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::ge($1, $2); } else { return mask(_mm256_cmp_pd(load($1), load($2), _CMP_GE_OQ)); }
+        }
+        inline static constexpr auto eq(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::eq($1, $2); } else { return mask(_mm256_cmp_pd(load($1), load($2), _CMP_EQ_OQ)); }
+        }
+        inline static constexpr auto ne(Self const& $1, Self const& $2) -> Mask {
+            if consteval { return Base::ne($1, $2); } else { return mask(_mm256_cmp_pd(load($1), load($2), _CMP_NEQ_UQ)); }
+        }
+        inline static constexpr auto select(Mask const& $1, Self const& $2, Self const& $3) -> Self {
+            if consteval { return Base::select($1, $2, $3); } else { return store(_mm256_blendv_pd(load($3), load($2), load($1))); }
+        }
+        inline static constexpr auto movemask(Mask const& $1) -> uint32_t {
+            if consteval { return Base::movemask($1); } else { return uint32_t(_mm256_movemask_pd(load($1))); }
+        }
+        inline static constexpr auto csum(Self const& $1) -> double {
+            if consteval { return Base::csum($1); } else { return reduce(load($1)); }
+        }
+    };
+#endif
+
+    template<typename T, size_t Width>
+    struct simd;
+
+    template<typename T>
+    inline constexpr size_t simd_width = 1;
+
+#if defined(__AVX512F__)
+    template<> inline constexpr size_t simd_width<float> = 16;
+    template<> inline constexpr size_t simd_width<double> = 8;
+#elif defined(__AVX__)
+    template<> inline constexpr size_t simd_width<float> = 8;
+    template<> inline constexpr size_t simd_width<double> = 4;
+#elif defined(__SSE4_1__)
+    template<> inline constexpr size_t simd_width<float> = 4;
+    template<> inline constexpr size_t simd_width<double> = 2;
+#endif
+
+    template<typename T>
+    struct simd<T, 1> {
+        using Self = simd;
+
+        static constexpr size_t width = 1;
+
+        T __value;
+
+        inline static auto load(T const* $1) -> Self {
+            return Self{*$1};
+        }
+        inline static auto broadcast(T const& $1) -> Self {
+            return Self{$1};
+        }
+        inline void store(this Self const& self, T* $1) {
+            *$1 = self.__value;
+        }
+
+        friend auto operator+(Self $1, Self $2) -> Self { return Self{$1.__value + $2.__value}; }
+        friend auto operator-(Self $1, Self $2) -> Self { return Self{$1.__value - $2.__value}; }
+        friend auto operator*(Self $1, Self $2) -> Self { return Self{$1.__value * $2.__value}; }
+        friend auto operator/(Self $1, Self $2) -> Self { return Self{$1.__value / $2.__value}; }
+        inline static auto min(Self $1, Self $2) -> Self { return Self{$1.__value < $2.__value ? $1.__value : $2.__value}; }
+        inline static auto max(Self $1, Self $2) -> Self { return Self{$1.__value > $2.__value ? $1.__value : $2.__value}; }
+        inline static auto sqrt(Self $1) -> Self { return Self{std::sqrt($1.__value)}; }
+        inline static auto floor(Self $1) -> Self { return Self{std::floor($1.__value)}; }
+        inline static auto round(Self $1) -> Self { return Self{std::nearbyint($1.__value)}; }
+        inline static auto madd(Self $1, Self $2, Self $3) -> Self {
+#if defined(__FMA__)
+            return Self{std::fma($1.__value, $2.__value, $3.__value)};
+#else
+            return Self{$1.__value * $2.__value + $3.__value};
+#endif
+        }
+
+        using Mask = bool;
+        using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+
+        inline static auto band(Self $1, Self $2) -> Self { return Self{std::bit_cast<T>(Bits(std::bit_cast<Bits>($1.__value) & std::bit_cast<Bits>($2.__value)))}; }
+        inline static auto bor(Self $1, Self $2) -> Self { return Self{std::bit_cast<T>(Bits(std::bit_cast<Bits>($1.__value) | std::bit_cast<Bits>($2.__value)))}; }
+        inline static auto bxor(Self $1, Self $2) -> Self { return Self{std::bit_cast<T>(Bits(std::bit_cast<Bits>($1.__value) ^ std::bit_cast<Bits>($2.__value)))}; }
+        inline static auto lt(Self $1, Self $2) -> Mask { return $1.__value < $2.__value; }
+        inline static auto gt(Self $1, Self $2) -> Mask { return $1.__value > $2.__value; }
+        inline static auto eq(Self $1, Self $2) -> Mask { return $1.__value == $2.__value; }
+        inline static auto isnan(Self $1) -> Mask { return $1.__value != $1.__value; }
+        inline static auto select(Mask $1, Self $2, Self $3) -> Self { return $1 ? $2 : $3; }
+        inline static auto movemask(Mask $1) -> uint32_t { return uint32_t($1); }
+        // float(bits of $1 as int32) and bits of int32($1), the two halves of exponent bit tricks
+        inline static auto itof(Self $1) -> Self requires(sizeof(T) == 4) { return Self{T(std::bit_cast<int32_t>($1.__value))}; }
+        inline static auto ftoi(Self $1) -> Self requires(sizeof(T) == 4) { return Self{std::bit_cast<T>(int32_t(std::lrint($1.__value)))}; }
+    };
+
+#if defined(__SSE4_1__)
+    template<>
+    struct simd<float, 4> {
+        using Self = simd;
+
+        static constexpr size_t width = 4;
+
+        __m128 __value;
+
+        inline static auto load(float const* $1) -> Self {
+            return Self{_mm_loadu_ps($1)};
+        }
+        inline static auto broadcast(float const& $1) -> Self {
+            return Self{_mm_set1_ps($1)};
+        }
+        inline void store(this Self const& self, float* $1) {
+            _mm_storeu_ps($1, self.__value);
+        }
+
+        friend auto operator+(Self $1, Self $2) -> Self { return Self{_mm_add_ps($1.__value, $2.__value)}; }
+        friend auto operator-(Self $1, Self $2) -> Self { return Self{_mm_sub_ps($1.__value, $2.__value)}; }
+        friend auto operator*(Self $1, Self $2) -> Self { return Self{_mm_mul_ps($1.__value, $2.__value)}; }
+        friend auto operator/(Self $1, Self $2) -> Self { return Self{_mm_div_ps($1.__value, $2.__value)}; }
+        inline static auto min(Self $1, Self $2) -> Self { return Self{_mm_min_ps($1.__value, $2.__value)}; }
+        inline static auto max(Self $1, Self $2) -> Self { return Self{_mm_max_ps($1.__value, $2.__value)}; }
+        inline static auto sqrt(Self $1) -> Self { return Self{_mm_sqrt_ps($1.__value)}; }
+        inline static auto floor(Self $1) -> Self { return Self{_mm_floor_ps($1.__value)}; }
+        inline static auto round(Self $1) -> Self { return Self{_mm_round_ps($1.__value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+        inline static auto madd(Self $1, Self $2, Self $3) -> Self {
+#if defined(__FMA__)
+            return Self{_mm_fmadd_ps($1.__value, $2.__value, $3.__value)};
+#else
+            return Self{_mm_add_ps(_mm_mul_ps($1.__value, $2.__value), $3.__value)};
+#endif
+        }
+
+        using Mask = __m128;
+
+        inline static auto band(Self $1, Self $2) -> Self { return Self{_mm_and_ps($1.__value, $2.__value)}; }
+        inline static auto bor(Self $1, Self $2) -> Self { return Self{_mm_or_ps($1.__value, $2.__value)}; }
+        inline static auto bxor(Self $1, Self $2) -> Self { return Self{_mm_xor_ps($1.__value, $2.__value)}; }
+        inline static auto lt(Self $1, Self $2) -> Mask { return _mm_cmplt_ps($1.__value, $2.__value); }
+        inline static auto gt(Self $1, Self $2) -> Mask { return _mm_cmpgt_ps($1.__value, $2.__value); }
+        inline static auto eq(Self $1, Self $2) -> Mask { return _mm_cmpeq_ps($1.__value, $2.__value); }
+        inline static auto isnan(Self $1) -> Mask { return _mm_cmpunord_ps($1.__value, $1.__value); }
+        inline static auto select(Mask $1, Self $2, Self $3) -> Self { return Self{_mm_blendv_ps($3.__value, $2.__value, $1)}; }
+        inline static auto movemask(Mask $1) -> uint32_t { return uint32_t(_mm_movemask_ps($1)); }
+        inline static auto itof(Self $1) -> Self { return Self{_mm_cvtepi32_ps(_mm_castps_si128($1.__value))}; }
+        inline static auto ftoi(Self $1) -> Self { return Self{_mm_castsi128_ps(_mm_cvtps_epi32($1.__value))}; }
+    };
+
+    template<>
+    struct simd<double, 2> {
+        using Self = simd;
+
+        static constexpr size_t width = 2;
+
+        __m128d __value;
+
+        inline static auto load(double const* $1) -> Self {
+            return Self{_mm_loadu_pd($1)};
+        }
+        inline static auto broadcast(double const& $1) -> Self {
+            return Self{_mm_set1_pd($1)};
+        }
+        inline void store(this Self const& self, double* $1) {
+            _mm_storeu_pd($1, self.__value);
+        }
+
+        friend auto operator+(Self $1, Self $2) -> Self { return Self{_mm_add_pd($1.__value, $2.__value)}; }
+        friend auto operator-(Self $1, Self $2) -> Self { return Self{_mm_sub_pd($1.__value, $2.__value)}; }
+        friend auto operator*(Self $1, Self $2) -> Self { return Self{_mm_mul_pd($1.__value, $2.__value)}; }
+        friend auto operator/(Self $1, Self $2) -> Self { return Self{_mm_div_pd($1.__value, $2.__value)}; }
+        inline static auto min(Self $1, Self $2) -> Self { return Self{_mm_min_pd($1.__value, $2.__value)}; }
+        inline static auto max(Self $1, Self $2) -> Self { return Self{_mm_max_pd($1.__value, $2.__value)}; }
+        inline static auto sqrt(Self $1) -> Self { return Self{_mm_sqrt_pd($1.__value)}; }
+        inline static auto floor(Self $1) -> Self { return Self{_mm_floor_pd($1.__value)}; }
+        inline static auto madd(Self $1, Self $2, Self $3) -> Self {
+#if defined(__FMA__)
+            return Self{_mm_fmadd_pd($1.__value, $2.__value, $3.__value)};
+#else
+            return Self{_mm_add_pd(_mm_mul_pd($1.__value, $2.__value), $3.__value)};
+#endif
+        }
+    };
+#endif
+
+#if defined(__AVX__)
+    template<>
+    struct simd<float, 8> {
+        using Self = simd;
+
+        static constexpr size_t width = 8;
+
+        __m256 __value;
+
+        inline static auto load(float const* $1) -> Self {
+            return Self{_mm256_loadu_ps($1)};
+        }
+        inline static auto broadcast(float const& $1) -> Self {
+            return Self{_mm256_set1_ps($1)};
+        }
+        inline void store(this Self const& self, float* $1) {
+            _mm256_storeu_ps($1, self.__value);
+        }
+
+        friend auto operator+(Self $1, Self $2) -> Self { return Self{_mm256_add_ps($1.__value, $2.__value)}; }
+        friend auto operator-(Self $1, Self $2) -> Self { return Self{_mm256_sub_ps($1.__value, $2.__value)}; }
+        friend auto operator*(Self $1, Self $2) -> Self { return Self{_mm256_mul_ps($1.__value, $2.__value)}; }
+        friend auto operator/(Self $1, Self $2) -> Self { return Self{_mm256_div_ps($1.__value, $2.__value)}; }
+        inline static auto min(Self $1, Self $2) -> Self { return Self{_mm256_min_ps($1.__value, $2.__value)}; }
+        inline static auto max(Self $1, Self $2) -> Self { return Self{_mm256_max_ps($1.__value, $2.__value)}; }
+        inline static auto sqrt(Self $1) -> Self { return Self{_mm256_sqrt_ps($1.__value)}; }
+        inline static auto floor(Self $1) -> Self { return Self{_mm256_floor_ps($1.__value)}; }
+        inline static auto round(Self $1) -> Self { return Self{_mm256_round_ps($1.__value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+        inline static auto madd(Self $1, Self $2, Self $3) -> Self {
+#if defined(__FMA__)
+            return Self{_mm256_fmadd_ps($1.__value, $2.__value, $3.__value)};
+#else
+            return Self{_mm256_add_ps(_mm256_mul_ps($1.__value, $2.__value), $3.__value)};
+#endif
+        }
+
+        using Mask = __m256;
+
+        inline static auto band(Self $1, Self $2) -> Self { return Self{_mm256_and_ps($1.__value, $2.__value)}; }
+        inline static auto bor(Self $1, Self $2) -> Self { return Self{_mm256_or_ps($1.__value, $2.__value)}; }
+        inline static auto bxor(Self $1, Self $2) -> Self { return Self{_mm256_xor_ps($1.__value, $2.__value)}; }
+        inline static auto lt(Self $1, Self $2) -> Mask { return _mm256_cmp_ps($1.__value, $2.__value, _CMP_LT_OQ); }
+        inline static auto gt(Self $1, Self $2) -> Mask { return _mm256_cmp_ps($1.__value, $2.__value, _CMP_GT_OQ); }
+        inline static auto eq(Self $1, Self $2) -> Mask { return _mm256_cmp_ps($1.__value, $2.__value, _CMP_EQ_OQ); }
+        inline static auto isnan(Self $1) -> Mask { return _mm256_cmp_ps($1.__value, $1.__value, _CMP_UNORD_Q); }
+        inline static auto select(Mask $1, Self $2, Self $3) -> Self { return Self{_mm256_blendv_ps($3.__value, $2.__value, $1)}; }
+        inline static auto movemask(Mask $1) -> uint32_t { return uint32_t(_mm256_movemask_ps($1)); }
+        inline static auto itof(Self $1) -> Self { return Self{_mm256_cvtepi32_ps(_mm256_castps_si256($1.__value))}; }
+        inline static auto ftoi(Self $1) -> Self { return Self{_mm256_castsi256_ps(_mm256_cvtps_epi32($1.__value))}; }
+    };
+
+    template<>
+    struct simd<double, 4> {
+        using Self = simd;
+
+        static constexpr size_t width = 4;
+
+        __m256d __value;
+
+        inline static auto load(double const* $1) -> Self {
+            return Self{_mm256_loadu_pd($1)};
+        }
+        inline static auto broadcast(double const& $1) -> Self {
+            return Self{_mm256_set1_pd($1)};
+        }
+        inline void store(this Self const& self, double* $1) {
+            _mm256_storeu_pd($1, self.__value);
+        }
+
+        friend auto operator+(Self $1, Self $2) -> Self { return Self{_mm256_add_pd($1.__value, $2.__value)}; }
+        friend auto operator-(Self $1, Self $2) -> Self { return Self{_mm256_sub_pd($1.__value, $2.__value)}; }
+        friend auto operator*(Self $1, Self $2) -> Self { return Self{_mm256_mul_pd($1.__value, $2.__value)}; }
+        friend auto operator/(Self $1, Self $2) -> Self { return Self{_mm256_div_pd($1.__value, $2.__value)}; }
+        inline static auto min(Self $1, Self $2) -> Self { return Self{_mm256_min_pd($1.__value, $2.__value)}; }
+        inline static auto max(Self $1, Self $2) -> Self { return Self{_mm256_max_pd($1.__value, $2.__value)}; }
+        inline static auto sqrt(Self $1) -> Self { return Self{_mm256_sqrt_pd($1.__value)}; }
+        inline static auto floor(Self $1) -> Self { return Self{_mm256_floor_pd($1.__value)}; }
+        inline static auto madd(Self $1, Self $2, Self $3) -> Self {
+#if defined(__FMA__)
+            return Self{_mm256_fmadd_pd($1.__value, $2.__value, $3.__value)};
+#else
+            return Self{_mm256_add_pd(_mm256_mul_pd($1.__value, $2.__value), $3.__value)};
+#endif
+        }
+    };
+#endif
+
+#if defined(__AVX512F__)
+    template<>
+    struct simd<float, 16> {
+        using Self = simd;
+
+        static constexpr size_t width = 16;
+
+        __m512 __value;
+
+        inline static auto load(float const* $1) -> Self {
+            return Self{_mm512_loadu_ps($1)};
+        }
+        inline static auto broadcast(float const& $1) -> Self {
+            return Self{_mm512_set1_ps($1)};
+        }
+        inline void store(this Self const& self, float* $1) {
+            _mm512_storeu_ps($1, self.__value);
+        }
+
+        friend auto operator+(Self $1, Self $2) -> Self { return Self{_mm512_add_ps($1.__value, $2.__value)}; }
+        friend auto operator-(Self $1, Self $2) -> Self { return Self{_mm512_sub_ps($1.__value, $2.__value)}; }
+        friend auto operator*(Self $1, Self $2) -> Self { return Self{_mm512_mul_ps($1.__value, $2.__value)}; }
+        friend auto operator/(Self $1, Self $2) -> Self { return Self{_mm512_div_ps($1.__value, $2.__value)}; }
+        inline static auto min(Self $1, Self $2) -> Self { return Self{_mm512_min_ps($1.__value, $2.__value)}; }
+        inline static auto max(Self $1, Self $2) -> Self { return Self{_mm512_max_ps($1.__value, $2.__value)}; }
+        inline static auto sqrt(Self $1) -> Self { return Self{_mm512_sqrt_ps($1.__value)}; }
+        inline static auto floor(Self $1) -> Self { return Self{_mm512_roundscale_ps($1.__value, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)}; }
+        inline static auto round(Self $1) -> Self { return Self{_mm512_roundscale_ps($1.__value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+        inline static auto madd(Self $1, Self $2, Self $3) -> Self { return Self{_mm512_fmadd_ps($1.__value, $2.__value, $3.__value)}; }
+
+        using Mask = __mmask16;
+
+        inline static auto band(Self $1, Self $2) -> Self { return Self{_mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512($1.__value), _mm512_castps_si512($2.__value)))}; }
+        inline static auto bor(Self $1, Self $2) -> Self { return Self{_mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512($1.__value), _mm512_castps_si512($2.__value)))}; }
+        inline static auto bxor(Self $1, Self $2) -> Self { return Self{_mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512($1.__value), _mm512_castps_si512($2.__value)))}; }
+        inline static auto lt(Self $1, Self $2) -> Mask { return _mm512_cmp_ps_mask($1.__value, $2.__value, _CMP_LT_OQ); }
+        inline static auto gt(Self $1, Self $2) -> Mask { return _mm512_cmp_ps_mask($1.__value, $2.__value, _CMP_GT_OQ); }
+        inline static auto eq(Self $1, Self $2) -> Mask { return _mm512_cmp_ps_mask($1.__value, $2.__value, _CMP_EQ_OQ); }
+        inline static auto isnan(Self $1) -> Mask { return _mm512_cmp_ps_mask($1.__value, $1.__value, _CMP_UNORD_Q); }
+        inline static auto select(Mask $1, Self $2, Self $3) -> Self { return Self{_mm512_mask_blend_ps($1, $3.__value, $2.__value)}; }
+        inline static auto movemask(Mask $1) -> uint32_t { return uint32_t($1); }
+        inline static auto itof(Self $1) -> Self { return Self{_mm512_cvtepi32_ps(_mm512_castps_si512($1.__value))}; }
+        inline static auto ftoi(Self $1) -> Self { return Self{_mm512_castsi512_ps(_mm512_cvtps_epi32($1.__value))}; }
+    };
+
+    template<>
+    struct simd<double, 8> {
+        using Self = simd;
+
+        static constexpr size_t width = 8;
+
+        __m512d __value;
+
+        inline static auto load(double const* $1) -> Self {
+            return Self{_mm512_loadu_pd($1)};
+        }
+        inline static auto broadcast(double const& $1) -> Self {
+            return Self{_mm512_set1_pd($1)};
+        }
+        inline void store(this Self const& self, double* $1) {
+            _mm512_storeu_pd($1, self.__value);
+        }
+
+        friend auto operator+(Self $1, Self $2) -> Self { return Self{_mm512_add_pd($1.__value, $2.__value)}; }
+        friend auto operator-(Self $1, Self $2) -> Self { return Self{_mm512_sub_pd($1.__value, $2.__value)}; }
+        friend auto operator*(Self $1, Self $2) -> Self { return Self{_mm512_mul_pd($1.__value, $2.__value)}; }
+        friend auto operator/(Self $1, Self $2) -> Self { return Self{_mm512_div_pd($1.__value, $2.__value)}; }
+        inline static auto min(Self $1, Self $2) -> Self { return Self{_mm512_min_pd($1.__value, $2.__value)}; }
+        inline static auto max(Self $1, Self $2) -> Self { return Self{_mm512_max_pd($1.__value, $2.__value)}; }
+        inline static auto sqrt(Self $1) -> Self { return Self{_mm512_sqrt_pd($1.__value)}; }
+        inline static auto floor(Self $1) -> Self { return Self{_mm512_roundscale_pd($1.__value, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)}; }
+        inline static auto madd(Self $1, Self $2, Self $3) -> Self { return Self{_mm512_fmadd_pd($1.__value, $2.__value, $3.__value)}; }
+    };
+#endif
+
+    template<typename T, size_t Cols, size_t Rows, size_t... Ci, size_t... Ri>
+    struct mat_scalar<T, Cols, Rows, std::index_sequence<Ci...>, std::index_sequence<Ri...>> {
+        using Self = mat_t<T, Cols, Rows>;
+
+        inline static constexpr auto col(Self const& self, size_t i) -> vec_t<T, Rows> {
+            return self.__columns[i];
+        }
+        inline static constexpr auto row(Self const& self, size_t i) -> vec_t<T, Cols> {
+            return vec_t<T, Cols>{self.__columns[Ci][i]...};
+        }
+        inline static constexpr auto mul(Self const& $1, Self const& $2) -> Self {
+            return Self{$1 * $2.__columns[Ci]...};
+        }
+        inline static constexpr auto mul(Self const& $1, vec_t<T, Cols> const& $2) -> vec_t<T, Cols> {
+            return (($1.__columns[Ci] * $2[Ci]) + ...);
+        }
+        inline static constexpr auto mul(vec_t<T, Cols> const& $1, Self const& $2) -> vec_t<T, Cols> {
+            return (($1[Ci] * $2.row(Ri)) + ...);
+        }
+        inline static constexpr auto transpose(Self const& $1) -> mat_t<T, Rows, Cols> {
+            return mat_t<T, Rows, Cols>{row($1, Ri)...};
+        }
+        inline static constexpr auto mul_transpose(Self const& $1, Self const& $2) -> mat_t<T, Rows, Cols> {
+            return transpose(mul($1, $2));
+        }
+        inline static constexpr auto inverse(Self const& $1, T& $2) -> Self requires(Cols == 4 && Rows == 4) {
+            vec_t<T, 4> A = row($1, 0);
+            vec_t<T, 4> B = row($1, 1);
+            vec_t<T, 4> C = row($1, 2);
+            vec_t<T, 4> D = row($1, 3);
+
+            vec_t<T, 4> C2211 = C.zzyy;
+            vec_t<T, 4> B2211 = B.zzyy;
+            vec_t<T, 4> A2211 = A.zzyy;
+            vec_t<T, 4> D3332 = D.wwwz;
+            vec_t<T, 4> C3332 = C.wwwz;
+            vec_t<T, 4> B3332 = B.wwwz;
+            vec_t<T, 4> D2211 = D.zzyy;
+            vec_t<T, 4> A3332 = A.wwwz;
+            vec_t<T, 4> B1000 = B.yxxx;
+            vec_t<T, 4> A1000 = A.yxxx;
+            vec_t<T, 4> C1000 = C.yxxx;
+            vec_t<T, 4> D1000 = D.yxxx;
+
+            vec_t<T, 4> $00 = C2211 * D3332 - D2211 * C3332;
+            vec_t<T, 4> $01 = B2211 * D3332 - D2211 * B3332;
+            vec_t<T, 4> $02 = B2211 * C3332 - C2211 * B3332;
+            vec_t<T, 4> $03 = A2211 * D3332 - D2211 * A3332;
+            vec_t<T, 4> $04 = A2211 * C3332 - C2211 * A3332;
+            vec_t<T, 4> $05 = A2211 * B3332 - B2211 * A3332;
+
+            vec_t<T, 4> m00 = (B1000 * $00 - C1000 * $01 + D1000 * $02) * vec_t<T, 4>{+1, -1, +1, -1};
+            vec_t<T, 4> m01 = (A1000 * $00 - C1000 * $03 + D1000 * $04) * vec_t<T, 4>{-1, +1, -1, +1};
+            vec_t<T, 4> m02 = (A1000 * $01 - B1000 * $03 + D1000 * $05) * vec_t<T, 4>{+1, -1, +1, -1};
+            vec_t<T, 4> m03 = (A1000 * $02 - B1000 * $04 + C1000 * $05) * vec_t<T, 4>{-1, +1, -1, +1};
+
+            $2 = dot(A, m00);
+            return Self{
+                m00 / $2,
+                m01 / $2,
+                m02 / $2,
+                m03 / $2
+            };
+        }
+        // linear part inverted through its adjugate, so scale and shear are handled; the last row is assumed (0, 0, 0, 1)
+        inline static constexpr auto inverse_affine(Self const& $1) -> Self requires(Cols == 4 && Rows == 4) {
+            vec_t<T, 3> a = $1.__columns[0].xyz;
+            vec_t<T, 3> b = $1.__columns[1].xyz;
+            vec_t<T, 3> c = $1.__columns[2].xyz;
+            vec_t<T, 3> t = $1.__columns[3].xyz;
+
+            vec_t<T, 3> r0 = cross(b, c);
+            vec_t<T, 3> r1 = cross(c, a);
+            vec_t<T, 3> r2 = cross(a, b);
+
+            T det = dot(a, r0);
+            vec_t<T, 3> c0 = vec_t<T, 3>{r0.x, r1.x, r2.x} / det;
+            vec_t<T, 3> c1 = vec_t<T, 3>{r0.y, r1.y, r2.y} / det;
+            vec_t<T, 3> c2 = vec_t<T, 3>{r0.z, r1.z, r2.z} / det;
+            vec_t<T, 3> c3 = T(0) - (c0 * t.x + (c1 * t.y + c2 * t.z));
+            return Self{
+                vec4(c0, T(0)),
+                vec4(c1, T(0)),
+                vec4(c2, T(0)),
+                vec4(c3, T(1))
+            };
+        }
+        // orthonormal linear part: the inverse rotation is the transpose
+        inline static constexpr auto inverse_rigid(Self const& $1) -> Self requires(Cols == 4 && Rows == 4) {
+            vec_t<T, 3> a = $1.__columns[0].xyz;
+            vec_t<T, 3> b = $1.__columns[1].xyz;
+            vec_t<T, 3> c = $1.__columns[2].xyz;
+            vec_t<T, 3> t = $1.__columns[3].xyz;
+
+            vec_t<T, 3> c0 = vec_t<T, 3>{a.x, b.x, c.x};
+            vec_t<T, 3> c1 = vec_t<T, 3>{a.y, b.y, c.y};
+            vec_t<T, 3> c2 = vec_t<T, 3>{a.z, b.z, c.z};
+            vec_t<T, 3> c3 = T(0) - (c0 * t.x + (c1 * t.y + c2 * t.z));
+            return Self{
+                vec4(c0, T(0)),
+                vec4(c1, T(0)),
+                vec4(c2, T(0)),
+                vec4(c3, T(1))
+            };
+        }
+    };
+
+    export template<typename T, size_t Cols, size_t Rows>
+    struct mat_impl : mat_scalar<T, Cols, Rows> {};
+
+#if defined(__SSE2__)
+    template<>
+    struct mat_impl<float, 4, 4> : mat_scalar<float, 4, 4> {
+        using Base = mat_scalar<float, 4, 4>;
+        using Self = mat_t<float, 4, 4>;
+
+        using Base::mul;
+        using Base::transpose;
+        using Base::mul_transpose;
+        using Base::inverse;
+        using Base::inverse_affine;
+        using Base::inverse_rigid;
+
+        inline static void load(Self const& $1, __m128 (&$2)[4]) {
+            for (size_t i = 0; i < 4; i += 1) {
+                $2[i] = _mm_loadu_ps($1.__columns[i].__fields);
+            }
+        }
+        inline static auto store(__m128 const (&$1)[4]) -> Self {
+            Self out;
+            for (size_t i = 0; i < 4; i += 1) {
+                _mm_storeu_ps(out.__columns[i].__fields, $1[i]);
+            }
+            return out;
+        }
+        inline static auto madd(__m128 $1, __m128 $2, __m128 $3) -> __m128 {
+#if defined(__FMA__)
+            return _mm_fmadd_ps($1, $2, $3);
+#else
+            return _mm_add_ps(_mm_mul_ps($1, $2), $3);
+#endif
+        }
+        // a * b for one column b, folded as a0 * b.x + (a1 * b.y + (a2 * b.z + a3 * b.w)) like the scalar path
+        inline static auto column(__m128 const (&$1)[4], __m128 $2) -> __m128 {
+            __m128 sum = _mm_mul_ps($1[3], _mm_shuffle_ps($2, $2, _MM_SHUFFLE(3, 3, 3, 3)));
+            sum = madd($1[2], _mm_shuffle_ps($2, $2, _MM_SHUFFLE(2, 2, 2, 2)), sum);
+            sum = madd($1[1], _mm_shuffle_ps($2, $2, _MM_SHUFFLE(1, 1, 1, 1)), sum);
+            return madd($1[0], _mm_shuffle_ps($2, $2, _MM_SHUFFLE(0, 0, 0, 0)), sum);
+        }
+        inline static void mul(__m128 const (&$1)[4], Self const& $2, __m128 (&$3)[4]) {
+            for (size_t i = 0; i < 4; i += 1) {
+                $3[i] = column($1, _mm_loadu_ps($2.__columns[i].__fields));
+            }
+        }
+        inline static void transpose(__m128 (&$1)[4]) {
+            _MM_TRANSPOSE4_PS($1[0], $1[1], $1[2], $1[3]);
+        }
+
+        inline static constexpr auto mul(Self const& $1, Self const& $2) -> Self {
+            if consteval {
+                return Base::mul($1, $2);
+            } else {
+                __m128 a[4], c[4];
+                load($1, a);
+                mul(a, $2, c);
+                return store(c);
+            }
+        }
+        inline static constexpr auto mul(Self const& $1, vec_t<float, 4> const& $2) -> vec_t<float, 4> {
+            if consteval {
+                return Base::mul($1, $2);
+            } else {
+                __m128 a[4];
+                load($1, a);
+                vec_t<float, 4> out;
+                _mm_storeu_ps(out.__fields, column(a, _mm_loadu_ps($2.__fields)));
+                return out;
+            }
+        }
+        inline static constexpr auto transpose(Self const& $1) -> Self {
+            if consteval {
+                return Base::transpose($1);
+            } else {
+                __m128 m[4];
+                load($1, m);
+                transpose(m);
+                return store(m);
+            }
+        }
+        inline static constexpr auto mul_transpose(Self const& $1, Self const& $2) -> Self {
+            if consteval {
+                return Base::mul_transpose($1, $2);
+            } else {
+                __m128 a[4], c[4];
+                load($1, a);
+                mul(a, $2, c);
+                transpose(c);
+                return store(c);
+            }
+        }
+        // (x, y, z) -> (y, z, x) and (z, x, y), the lane rotations behind cross products
+        inline static auto yzx(__m128 $1) -> __m128 {
+            return _mm_shuffle_ps($1, $1, _MM_SHUFFLE(3, 0, 2, 1));
+        }
+        inline static auto zxy(__m128 $1) -> __m128 {
+            return _mm_shuffle_ps($1, $1, _MM_SHUFFLE(3, 1, 0, 2));
+        }
+        inline static auto cross(__m128 $1, __m128 $2) -> __m128 {
+            return _mm_sub_ps(_mm_mul_ps(yzx($1), zxy($2)), _mm_mul_ps(zxy($1), yzx($2)));
+        }
+        // c0 * t.x + (c1 * t.y + c2 * t.z), negated, with w forced to 1
+        inline static auto translation(__m128 const (&$1)[4], __m128 $2) -> __m128 {
+            __m128 sum = _mm_add_ps(
+                _mm_mul_ps($1[1], _mm_shuffle_ps($2, $2, _MM_SHUFFLE(1, 1, 1, 1))),
+                _mm_mul_ps($1[2], _mm_shuffle_ps($2, $2, _MM_SHUFFLE(2, 2, 2, 2)))
+            );
+            sum = _mm_add_ps(_mm_mul_ps($1[0], _mm_shuffle_ps($2, $2, _MM_SHUFFLE(0, 0, 0, 0))), sum);
+            __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+            return _mm_or_ps(_mm_and_ps(_mm_sub_ps(_mm_setzero_ps(), sum), xyz), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+        }
+
+        inline static constexpr auto inverse(Self const& $1, float& $2) -> Self {
+            if consteval {
+                return Base::inverse($1, $2);
+            } else {
+                __m128 m[4];
+                load($1, m);
+                transpose(m);
+
+                __m128 C2211 = _mm_shuffle_ps(m[2], m[2], _MM_SHUFFLE(1, 1, 2, 2));
+                __m128 B2211 = _mm_shuffle_ps(m[1], m[1], _MM_SHUFFLE(1, 1, 2, 2));
+                __m128 A2211 = _mm_shuffle_ps(m[0], m[0], _MM_SHUFFLE(1, 1, 2, 2));
+                __m128 D3332 = _mm_shuffle_ps(m[3], m[3], _MM_SHUFFLE(2, 3, 3, 3));
+                __m128 C3332 = _mm_shuffle_ps(m[2], m[2], _MM_SHUFFLE(2, 3, 3, 3));
+                __m128 B3332 = _mm_shuffle_ps(m[1], m[1], _MM_SHUFFLE(2, 3, 3, 3));
+                __m128 D2211 = _mm_shuffle_ps(m[3], m[3], _MM_SHUFFLE(1, 1, 2, 2));
+                __m128 A3332 = _mm_shuffle_ps(m[0], m[0], _MM_SHUFFLE(2, 3, 3, 3));
+                __m128 B1000 = _mm_shuffle_ps(m[1], m[1], _MM_SHUFFLE(0, 0, 0, 1));
+                __m128 A1000 = _mm_shuffle_ps(m[0], m[0], _MM_SHUFFLE(0, 0, 0, 1));
+                __m128 C1000 = _mm_shuffle_ps(m[2], m[2], _MM_SHUFFLE(0, 0, 0, 1));
+                __m128 D1000 = _mm_shuffle_ps(m[3], m[3], _MM_SHUFFLE(0, 0, 0, 1));
+
+                __m128 $00 = _mm_sub_ps(_mm_mul_ps(C2211, D3332), _mm_mul_ps(D2211, C3332));
+                __m128 $01 = _mm_sub_ps(_mm_mul_ps(B2211, D3332), _mm_mul_ps(D2211, B3332));
+                __m128 $02 = _mm_sub_ps(_mm_mul_ps(B2211, C3332), _mm_mul_ps(C2211, B3332));
+                __m128 $03 = _mm_sub_ps(_mm_mul_ps(A2211, D3332), _mm_mul_ps(D2211, A3332));
+                __m128 $04 = _mm_sub_ps(_mm_mul_ps(A2211, C3332), _mm_mul_ps(C2211, A3332));
+                __m128 $05 = _mm_sub_ps(_mm_mul_ps(A2211, B3332), _mm_mul_ps(B2211, A3332));
+
+                __m128 even = _mm_setr_ps(+1.0f, -1.0f, +1.0f, -1.0f);
+                __m128 odd = _mm_setr_ps(-1.0f, +1.0f, -1.0f, +1.0f);
+
+                __m128 c[4];
+                c[0] = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(B1000, $00), _mm_mul_ps(C1000, $01)), _mm_mul_ps(D1000, $02)), even);
+                c[1] = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(A1000, $00), _mm_mul_ps(C1000, $03)), _mm_mul_ps(D1000, $04)), odd);
+                c[2] = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(A1000, $01), _mm_mul_ps(B1000, $03)), _mm_mul_ps(D1000, $05)), even);
+                c[3] = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(A1000, $02), _mm_mul_ps(B1000, $04)), _mm_mul_ps(C1000, $05)), odd);
+
+                $2 = vec_impl<float, 4>::reduce(_mm_mul_ps(m[0], c[0]));
+                __m128 det = _mm_set1_ps($2);
+                for (size_t i = 0; i < 4; i += 1) {
+                    c[i] = _mm_div_ps(c[i], det);
+                }
+                return store(c);
+            }
+        }
+        inline static constexpr auto inverse_affine(Self const& $1) -> Self {
+            if consteval {
+                return Base::inverse_affine($1);
+            } else {
+                __m128 m[4];
+                load($1, m);
+
+                __m128 r[4];
+                r[0] = cross(m[1], m[2]);
+                r[1] = cross(m[2], m[0]);
+                r[2] = cross(m[0], m[1]);
+                r[3] = _mm_setzero_ps();
+
+                __m128 p = _mm_mul_ps(m[0], r[0]);
+                __m128 det = _mm_add_ss(p, _mm_add_ss(_mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)), _mm_movehl_ps(p, p)));
+                det = _mm_shuffle_ps(det, det, _MM_SHUFFLE(0, 0, 0, 0));
+                for (size_t i = 0; i < 3; i += 1) {
+                    r[i] = _mm_div_ps(r[i], det);
+                }
+                transpose(r);
+                r[3] = translation(r, m[3]);
+                return store(r);
+            }
+        }
+        inline static constexpr auto inverse_rigid(Self const& $1) -> Self {
+            if consteval {
+                return Base::inverse_rigid($1);
+            } else {
+                __m128 m[4];
+                load($1, m);
+
+                __m128 t = m[3];
+                m[3] = _mm_setzero_ps();
+                transpose(m);
+                m[3] = translation(m, t);
+                return store(m);
+            }
+        }
+    };
+#endif
+
+#if defined(__AVX__)
+    template<>
+    struct mat_impl<double, 4, 4> : mat_scalar<double, 4, 4> {
+        using Base = mat_scalar<double, 4, 4>;
+        using Self = mat_t<double, 4, 4>;
+
+        using Base::mul;
+        using Base::transpose;
+        using Base::mul_transpose;
+
+        inline static void load(Self const& $1, __m256d (&$2)[4]) {
+            for (size_t i = 0; i < 4; i += 1) {
+                $2[i] = _mm256_loadu_pd($1.__columns[i].__fields);
+            }
+        }
+        inline static auto store(__m256d const (&$1)[4]) -> Self {
+            Self out;
+            for (size_t i = 0; i < 4; i += 1) {
+                _mm256_storeu_pd(out.__columns[i].__fields, $1[i]);
+            }
+            return out;
+        }
+        inline static auto madd(__m256d $1, __m256d $2, __m256d $3) -> __m256d {
+#if defined(__FMA__)
+            return _mm256_fmadd_pd($1, $2, $3);
+#else
+            return _mm256_add_pd(_mm256_mul_pd($1, $2), $3);
+#endif
+        }
+        // a * b for one column b, folded as a0 * b.x + (a1 * b.y + (a2 * b.z + a3 * b.w)) like the scalar path
+        inline static auto column(__m256d const (&$1)[4], double const* $2) -> __m256d {
+            __m256d sum = _mm256_mul_pd($1[3], _mm256_broadcast_sd($2 + 3));
+            sum = madd($1[2], _mm256_broadcast_sd($2 + 2), sum);
+            sum = madd($1[1], _mm256_broadcast_sd($2 + 1), sum);
+            return madd($1[0], _mm256_broadcast_sd($2 + 0), sum);
+        }
+        inline static void mul(__m256d const (&$1)[4], Self const& $2, __m256d (&$3)[4]) {
+            for (size_t i = 0; i < 4; i += 1) {
+                $3[i] = column($1, $2.__columns[i].__fields);
+            }
+        }
+        inline static void transpose(__m256d (&$1)[4]) {
+            __m256d t0 = _mm256_unpacklo_pd($1[0], $1[1]);
+            __m256d t1 = _mm256_unpackhi_pd($1[0], $1[1]);
+            __m256d t2 = _mm256_unpacklo_pd($1[2], $1[3]);
+            __m256d t3 = _mm256_unpackhi_pd($1[2], $1[3]);
+            $1[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+            $1[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+            $1[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+            $1[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+        }
+
+        inline static constexpr auto mul(Self const& $1, Self const& $2) -> Self {
+            if consteval {
+                return Base::mul($1, $2);
+            } else {
+                __m256d a[4], c[4];
+                load($1, a);
+                mul(a, $2, c);
+                return store(c);
+            }
+        }
+        inline static constexpr auto mul(Self const& $1, vec_t<double, 4> const& $2) -> vec_t<double, 4> {
+            if consteval {
+                return Base::mul($1, $2);
+            } else {
+                __m256d a[4];
+                load($1, a);
+                vec_t<double, 4> out;
+                _mm256_storeu_pd(out.__fields, column(a, $2.__fields));
+                return out;
+            }
+        }
+        inline static constexpr auto transpose(Self const& $1) -> Self {
+            if consteval {
+                return Base::transpose($1);
+            } else {
+                __m256d m[4];
+                load($1, m);
+                transpose(m);
+                return store(m);
+            }
+        }
+        inline static constexpr auto mul_transpose(Self const& $1, Self const& $2) -> Self {
+            if consteval {
+                return Base::mul_transpose($1, $2);
+            } else {
+                __m256d a[4], c[4];
+                load($1, a);
+                mul(a, $2, c);
+                transpose(c);
+                return store(c);
+            }
+        }
+    };
+#endif
+
+    export template<typename T, size_t Cols, size_t Rows>
+    inline constexpr auto transpose(mat_t<T, Cols, Rows> const& $1) -> mat_t<T, Rows, Cols> {
+        return mat_impl<T, Cols, Rows>::transpose($1);
+    }
+    // transpose($1 * $2) without the intermediate round trip, e.g. for row-major uploads
+    export template<typename T, size_t Cols, size_t Rows>
+    inline constexpr auto mul_transpose(mat_t<T, Cols, Rows> const& $1, mat_t<T, Cols, Rows> const& $2) -> mat_t<T, Rows, Cols> {
+        return mat_impl<T, Cols, Rows>::mul_transpose($1, $2);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto dot(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> T {
+        return vec_impl<T, Len>::dot($1, $2);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto csum(vec_t<T, Len> const& $1) -> T {
+        return vec_impl<T, Len>::csum($1);
+    }
+    export template<typename U, typename T, size_t Len>
+    inline constexpr auto cast(vec_t<T, Len> const& $1) -> vec_t<U, Len> {
+        return vec_impl<T, Len>::template cast<U>($1);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto floor(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::floor($1);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto ceil(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::ceil($1);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto round(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::round($1);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto sin(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::sin($1);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto cos(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::cos($1);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto sqrt(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::sqrt($1);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto fract(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::fract($1);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto length(vec_t<T, Len> const& $1) -> T {
+        return vec_impl<T, Len>::length($1);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto sign(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::sign($1);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto normalize(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::normalize($1);
+    }
+    // approximate 1/length, up to a few ulp off normalize
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto normalize_fast(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::normalize_fast($1);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto abs(vec_t<T, Len> const& $1) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::abs($1);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto min(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::min($1, $2);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto max(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::max($1, $2);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto lessThan(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> mask_t<T, Len> {
+        return vec_impl<T, Len>::lt($1, $2);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto lessEqual(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> mask_t<T, Len> {
+        return vec_impl<T, Len>::le($1, $2);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto greaterThan(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> mask_t<T, Len> {
+        return vec_impl<T, Len>::gt($1, $2);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto greaterEqual(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> mask_t<T, Len> {
+        return vec_impl<T, Len>::ge($1, $2);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto equal(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> mask_t<T, Len> {
+        return vec_impl<T, Len>::eq($1, $2);
+    }
+    // true for NaN lanes, like the scalar operator
+    export template<typename T, size_t Len>
+    inline constexpr auto notEqual(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> mask_t<T, Len> {
+        return vec_impl<T, Len>::ne($1, $2);
+    }
+    // bit i is set when lane i is
+    export template<typename T, size_t Len>
+    inline constexpr auto movemask(mask_t<T, Len> const& $1) -> uint32_t {
+        return vec_impl<T, Len>::movemask($1);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto any(mask_t<T, Len> const& $1) -> bool {
+        return vec_impl<T, Len>::movemask($1) != 0;
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto all(mask_t<T, Len> const& $1) -> bool {
+        return vec_impl<T, Len>::movemask($1) == (uint32_t(1) << Len) - 1;
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto none(mask_t<T, Len> const& $1) -> bool {
+        return vec_impl<T, Len>::movemask($1) == 0;
+    }
+    // $2 where the mask is set, $3 elsewhere
+    export template<typename T, size_t Len>
+    inline constexpr auto select(mask_t<T, Len> const& $1, vec_t<T, Len> const& $2, vec_t<T, Len> const& $3) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::select($1, $2, $3);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto mix(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2, std::type_identity_t<T> const& $3) -> vec_t<T, Len> {
+        return $1 * (T(1) - $3) + $2 * $3;
+    }
+    export template<std::floating_point T, size_t Len>
+    inline constexpr auto mix(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2, vec_t<T, Len> const& $3) -> vec_t<T, Len> {
+        return $1 * (T(1) - $3) + $2 * $3;
+    }
+    // GLSL semantics: $2 where the mask is set
+    export template<typename T, size_t Len>
+    inline constexpr auto mix(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2, mask_t<T, Len> const& $3) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::select($3, $2, $1);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto clamp(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2, vec_t<T, Len> const& $3) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::min(vec_impl<T, Len>::max($1, $2), $3);
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto clamp(vec_t<T, Len> const& $1, std::type_identity_t<T> const& $2, std::type_identity_t<T> const& $3) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::min(vec_impl<T, Len>::max($1, vec_impl<T, Len>::broadcast($2)), vec_impl<T, Len>::broadcast($3));
+    }
+    // 0 where $2 < $1, 1 elsewhere
+    export template<typename T, size_t Len>
+    inline constexpr auto step(vec_t<T, Len> const& $1, vec_t<T, Len> const& $2) -> vec_t<T, Len> {
+        return vec_impl<T, Len>::select(vec_impl<T, Len>::lt($2, $1), vec_impl<T, Len>::broadcast(T(0)), vec_impl<T, Len>::broadcast(T(1)));
+    }
+    export template<typename T, size_t Len>
+    inline constexpr auto step(std::type_identity_t<T> const& $1, vec_t<T, Len> const& $2) -> vec_t<T, Len> {
+        return step(vec_impl<T, Len>::broadcast($1), $2);
+    }
+
+    export template<typename T>
+    inline constexpr auto cross(vec_t<T, 3> const& $1, vec_t<T, 3> const& $2) -> vec_t<T, 3> {
+        return $1.yzx * $2.zxy - $1.zxy * $2.yzx;
+    }
+
+    export template<typename T>
+    inline constexpr auto vec2(T $1) -> vec_t<T, 2> {
+        return vec_t<T, 2>{$1, $1};
+    }
+    export template<typename T>
+    inline constexpr auto vec2(T $1, T $2)  -> vec_t<T, 2> {
+        return vec_t<T, 2>{$1, $2};
+    }
+    export template<typename T>
+    inline constexpr auto vec3(T $1) -> vec_t<T, 3> {
+        return vec_t<T, 3>{$1, $1, $1};
+    }
+    export template<typename T>
+    inline constexpr auto vec3(T $1, T $2, T $3) -> vec_t<T, 3> {
+        return vec_t<T, 3>{$1, $2, $3};
+    }
+    export template<typename T>
+    inline constexpr auto vec3(vec_t<T, 2> $1, T $2) -> vec_t<T, 3> {
+        return vec_t<T, 3>{$1.x, $1.y, $2};
+    }
+    export template<typename T>
+    inline constexpr auto vec3(T $1, vec_t<T, 2> $2) -> vec_t<T, 3> {
+        return vec_t<T, 3>{$1, $2.x, $2.y};
+    }
+    export template<typename T>
+    inline constexpr auto vec4(T $1) -> vec_t<T, 4> {
+        return vec_t<T, 4>{$1, $1, $1, $1};
+    }
+    export template<typename T>
+    inline constexpr auto vec4(T $1, T $2, T $3, T $4) -> vec_t<T, 4> {
+        return vec_t<T, 4>{$1, $2, $3, $4};
+    }
+    export template<typename T>
+    inline constexpr auto vec4(vec_t<T, 2> $1, T $2, T $3) -> vec_t<T, 4> {
+        return vec_t<T, 4>{$1.x, $1.y, $2, $3};
+    }
+    export template<typename T>
+    inline constexpr auto vec4(T $1, vec_t<T, 2> $2, T $3) -> vec_t<T, 4> {
+        return vec_t<T, 4>{$1, $2.x, $2.y, $3};
+    }
+    export template<typename T>
+    inline constexpr auto vec4(T $1, T $2, vec_t<T, 2> $3) -> vec_t<T, 4> {
+        return vec_t<T, 4>{$1, $2, $3.x, $3.y};
+    }
+    export template<typename T>
+    inline constexpr auto vec4(vec_t<T, 2> $1, vec_t<T, 2> $2) -> vec_t<T, 4> {
+        return vec_t<T, 4>{$1.x, $1.y, $2.x, $2.y};
+    }
+    export template<typename T>
+    inline constexpr auto vec4(vec_t<T, 3> $1, T $2) -> vec_t<T, 4> {
+        return vec_t<T, 4>{$1.x, $1.y, $1.z, $2};
+    }
+    export template<typename T>
+    inline constexpr auto vec4(T $1, vec_t<T, 3> $2) -> vec_t<T, 4> {
+        return vec_t<T, 4>{$1, $2.x, $2.y, $2.z};
+    }
+
+    export template<typename V>
+    struct divisor;
+
+    template<std::integral T, size_t Len>
+    struct divisor_impl;
+
+    // division by an invariant integer as a multiply-high and shifts, after Granlund and Montgomery,
+    // "Division by Invariant Integers using Multiplication" (figures 4.1 and 5.2); both forms are
+    // branch-free and exact for every nonzero divisor, so each lane may divide by something else
+    template<std::integral T, size_t Len, typename = std::make_index_sequence<Len>>
+    struct divisor_scalar;
+
+    template<std::integral T, size_t Len, size_t... I>
+    struct divisor_scalar<T, Len, std::index_sequence<I...>> {
+        using U = std::make_unsigned_t<T>;
+        using Vec = vec_t<T, Len>;
+        using Divisor = divisor<vec_t<T, Len>>;
+
+        static constexpr int bits = std::numeric_limits<U>::digits;
+
+        using Wide = std::conditional_t<(bits < 64), uint64_t, unsigned __int128>;
+        using SignedWide = std::conditional_t<(bits < 64), int64_t, __int128>;
+
+        inline static constexpr auto mulhi(U $1, U $2) -> U {
+            return U((Wide($1) * Wide($2)) >> bits);
+        }
+        inline static constexpr auto mulsh(T $1, T $2) -> T {
+            return T((SignedWide($1) * SignedWide($2)) >> bits);
+        }
+        // ceil(log2($1))
+        inline static constexpr auto log2(U $1) -> int {
+            return $1 > 1 ? bits - std::countl_zero(U($1 - 1)) : 0;
+        }
+        inline static constexpr auto magnitude(T $1) -> U {
+            return $1 < 0 ? U(U(0) - U($1)) : U($1);
+        }
+
+        // the multiplier and shifts of one lane; pre is the 0 or 1 shift of n - t in the unsigned form
+        inline static constexpr void make(T $1, U& magic, U& pre, U& post) {
+            if constexpr (std::is_signed_v<T>) {
+                U d = magnitude($1);
+                int l = std::max(log2(d), 1);
+                magic = U((Wide(1) << (bits + l - 1)) / d + 1 - (Wide(1) << bits));
+                pre = 0;
+                post = U(l - 1);
+            } else {
+                int l = log2($1);
+                magic = U((((Wide(1) << l) - $1) << bits) / $1 + 1);
+                pre = U(l < 1 ? l : 1);
+                post = U(l > 1 ? l - 1 : 0);
+            }
+        }
+
+        // $1 / d, truncated like the built-in operator
+        inline static constexpr auto quotient(T $1, T $2, U magic, U pre, U post) -> T {
+            if constexpr (std::is_signed_v<T>) {
+                T q = T(U(U($1) + U(mulsh(T(magic), $1))));
+                q = T(T(q >> post) - T($1 >> (bits - 1)));
+                T sign = T($2 >> (bits - 1));
+                return T(T(q ^ sign) - sign);
+            } else {
+                U t = mulhi(magic, $1);
+                return T(U(t + U(U($1 - t) >> pre)) >> post);
+            }
+        }
+
+        inline static constexpr auto remainder(T $1, T $2, T $3) -> T {
+            return T(U(U($1) - U($2) * U($3)));
+        }
+        inline static constexpr auto floor_step(T $1, T $2, T $3) -> T {
+            T r = remainder($1, $2, $3);
+            return T($2 - T(r != 0 && (r ^ $3) < 0));
+        }
+        inline static constexpr auto euclid_step(T $1, T $2) -> T {
+            return T(U(U($1) + ($1 < 0 ? magnitude($2) : U(0))));
+        }
+
+        inline static constexpr auto div(Vec const& $1, Divisor const& $2) -> Vec {
+            return Vec{quotient($1[I], $2.__value[I], $2.__magic[I], $2.__pre[I], $2.__post[I])...};
+        }
+        inline static constexpr auto mod(Vec const& $1, Divisor const& $2) -> Vec {
+            Vec q = div($1, $2);
+            return Vec{remainder($1[I], q[I], $2.__value[I])...};
+        }
+        // rounds toward negative infinity, so the remainder takes the sign of the divisor
+        inline static constexpr auto floor_div(Vec const& $1, Divisor const& $2) -> Vec {
+            if constexpr (std::is_signed_v<T>) {
+                Vec q = div($1, $2);
+                return Vec{floor_step($1[I], q[I], $2.__value[I])...};
+            } else {
+                return div($1, $2);
+            }
+        }
+        // always in [0, |d|)
+        inline static constexpr auto euclid_mod(Vec const& $1, Divisor const& $2) -> Vec {
+            if constexpr (std::is_signed_v<T>) {
+                Vec r = mod($1, $2);
+                return Vec{euclid_step(r[I], $2.__value[I])...};
+            } else {
+                return mod($1, $2);
+            }
+        }
+    };
+
+    // precomputed once for a divisor that is reused across many divisions; every lane must be nonzero
+    export template<std::integral T, size_t Len>
+    struct divisor<vec_t<T, Len>> final {
+        using Self = divisor;
+        using U = std::make_unsigned_t<T>;
+
+        vec_t<T, Len> __value;
+        vec_t<U, Len> __magic;
+        vec_t<U, Len> __pre;
+        vec_t<U, Len> __post;
+
+        constexpr explicit divisor(vec_t<T, Len> const& $1) : __value($1), __magic{}, __pre{}, __post{} {
+            for (size_t i = 0; i < Len; i += 1) {
+                divisor_scalar<T, Len>::make($1[i], __magic[i], __pre[i], __post[i]);
+            }
+        }
+        constexpr explicit divisor(T $1) : divisor(vec_impl<T, Len>::broadcast($1)) {}
+
+        friend constexpr auto operator/(vec_t<T, Len> const& $1, Self const& $2) -> vec_t<T, Len> {
+            return divisor_impl<T, Len>::div($1, $2);
+        }
+        friend constexpr auto operator%(vec_t<T, Len> const& $1, Self const& $2) -> vec_t<T, Len> {
+            return divisor_impl<T, Len>::mod($1, $2);
+        }
+    };
+
+    template<std::integral T, size_t Len>
+    struct divisor_impl : divisor_scalar<T, Len> {};
+
+#if defined(__AVX2__)
+    // 32-bit lanes in one register: the multiply-high is two _mm_mul_ep[iu]32 on the even and odd lanes,
+    // and the per-lane shifts are AVX2 variable shifts; a single lane stays scalar, since the 64-bit
+    // load and store below would touch past its 4 bytes
+    template<std::integral T, size_t Len> requires(sizeof(T) == 4 && Len >= 2 && Len <= 4)
+    struct divisor_impl<T, Len> : divisor_scalar<T, Len> {
+        using Base = divisor_scalar<T, Len>;
+        using Vec = vec_t<T, Len>;
+        using Divisor = divisor<vec_t<T, Len>>;
+
+        template<typename E>
+        inline static auto load(vec_t<E, Len> const& $1) -> __m128i {
+            if constexpr (Len == 4) {
+                return _mm_loadu_si128(reinterpret_cast<__m128i const*>($1.__fields));
+            } else if constexpr (Len == 3) {
+                return _mm_insert_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>($1.__fields)), int($1.__fields[2]), 2);
+            } else {
+                return _mm_loadl_epi64(reinterpret_cast<__m128i const*>($1.__fields));
+            }
+        }
+        inline static auto store(__m128i $1) -> Vec {
+            Vec out;
+            if constexpr (Len == 4) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out.__fields), $1);
+            } else {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out.__fields), $1);
+                if constexpr (Len == 3) {
+                    out.__fields[2] = T(_mm_extract_epi32($1, 2));
+                }
+            }
+            return out;
+        }
+        inline static auto mulhi(__m128i $1, __m128i $2) -> __m128i {
+            if constexpr (std::is_signed_v<T>) {
+                __m128i even = _mm_srli_epi64(_mm_mul_epi32($1, $2), 32);
+                __m128i odd = _mm_mul_epi32(_mm_srli_epi64($1, 32), _mm_srli_epi64($2, 32));
+                return _mm_blend_epi16(even, odd, 0b11001100);
+            } else {
+                __m128i even = _mm_srli_epi64(_mm_mul_epu32($1, $2), 32);
+                __m128i odd = _mm_mul_epu32(_mm_srli_epi64($1, 32), _mm_srli_epi64($2, 32));
+                return _mm_blend_epi16(even, odd, 0b11001100);
+            }
+        }
+        inline static auto quotient(__m128i $1, Divisor const& $2) -> __m128i {
+            __m128i t = mulhi(load($2.__magic), $1);
+            if constexpr (std::is_signed_v<T>) {
+                __m128i sign = _mm_srai_epi32(load($2.__value), 31);
+                __m128i q = _mm_sub_epi32(_mm_srav_epi32(_mm_add_epi32($1, t), load($2.__post)), _mm_srai_epi32($1, 31));
+                return _mm_sub_epi32(_mm_xor_si128(q, sign), sign);
+            } else {
+                __m128i q = _mm_add_epi32(t, _mm_srlv_epi32(_mm_sub_epi32($1, t), load($2.__pre)));
+                return _mm_srlv_epi32(q, load($2.__post));
+            }
+        }
+        inline static auto remainder(__m128i $1, __m128i $2, __m128i $3) -> __m128i {
+            return _mm_sub_epi32($1, _mm_mullo_epi32($2, $3));
+        }
+
+        inline static constexpr auto div(Vec const& $1, Divisor const& $2) -> Vec {
+            if consteval { return Base::div($1, $2); } else { return store(quotient(load($1), $2)); }
+        }
+        inline static constexpr auto mod(Vec const& $1, Divisor const& $2) -> Vec {
+            if consteval {
+                return Base::mod($1, $2);
+            } else {
+                __m128i n = load($1);
+                return store(remainder(n, quotient(n, $2), load($2.__value)));
+            }
+        }
+        inline static constexpr auto floor_div(Vec const& $1, Divisor const& $2) -> Vec {
+            if consteval {
+                return Base::floor_div($1, $2);
+            } else {
+                __m128i n = load($1);
+                __m128i d = load($2.__value);
+                __m128i q = quotient(n, $2);
+                if constexpr (std::is_signed_v<T>) {
+                    __m128i r = remainder(n, q, d);
+                    __m128i step = _mm_andnot_si128(_mm_cmpeq_epi32(r, _mm_setzero_si128()), _mm_srai_epi32(_mm_xor_si128(r, d), 31));
+                    q = _mm_add_epi32(q, step);
+                }
+                return store(q);
+            }
+        }
+        inline static constexpr auto euclid_mod(Vec const& $1, Divisor const& $2) -> Vec {
+            if consteval {
+                return Base::euclid_mod($1, $2);
+            } else {
+                __m128i n = load($1);
+                __m128i d = load($2.__value);
+                __m128i r = remainder(n, quotient(n, $2), d);
+                if constexpr (std::is_signed_v<T>) {
+                    r = _mm_add_epi32(r, _mm_and_si128(_mm_srai_epi32(r, 31), _mm_abs_epi32(d)));
+                }
+                return store(r);
+            }
+        }
+    };
+#endif
+
+    // floor($1 / d); equals $1 / d for unsigned lanes
+    export template<std::integral T, size_t Len>
+    inline constexpr auto floor_div(vec_t<T, Len> const& $1, divisor<vec_t<T, Len>> const& $2) -> vec_t<T, Len> {
+        return divisor_impl<T, Len>::floor_div($1, $2);
+    }
+    // $1 mod |d| in [0, |d|), e.g. the cell within a chunk for negative world coordinates
+    export template<std::integral T, size_t Len>
+    inline constexpr auto euclid_mod(vec_t<T, Len> const& $1, divisor<vec_t<T, Len>> const& $2) -> vec_t<T, Len> {
+        return divisor_impl<T, Len>::euclid_mod($1, $2);
+    }
+
+    // batch functions that read whole arrays of vec_t take any contiguous range of them (span, vector,
+    // array) as a vec_range, so T and Len come from the elements instead of from a hand-written span
+    template<typename V>
+    struct vec_range_traits;
+
+    template<typename T, size_t Len>
+    struct vec_range_traits<vec_t<T, Len>> {
+        using Scalar = T;
+        static constexpr size_t length = Len;
+    };
+
+    template<typename Range>
+    using range_vec_t = std::remove_cvref_t<std::ranges::range_reference_t<Range>>;
+
+    template<typename Range>
+    concept vec_range = std::ranges::contiguous_range<Range> && requires { vec_range_traits<range_vec_t<Range>>::length; };
+
+    template<typename Range>
+    using vec_range_span = std::span<range_vec_t<Range> const>;
+
+    template<typename Range>
+    using vec_range_scalar = typename vec_range_traits<range_vec_t<Range>>::Scalar;
+
+    template<typename Range>
+    inline constexpr size_t vec_range_length = vec_range_traits<range_vec_t<Range>>::length;
+
+    // Z-order keys: bit i of component k lands at bit i * Len + k, so cells that are close in space
+    // mostly get close keys. A 64-bit key holds 32 bits per axis in 2D and 21 in 3D; higher bits are dropped
+    template<std::unsigned_integral T, size_t Len> requires(Len == 2 || Len == 3)
+    struct morton_scalar {
+        static constexpr int bits = std::min(std::numeric_limits<T>::digits, 64 / int(Len));
+
+        using Key = std::conditional_t<(bits * int(Len) <= 32), uint32_t, uint64_t>;
+        using Vec = vec_t<T, Len>;
+
+        // the key bits of component 0
+        static constexpr uint64_t lanes = Len == 2 ? 0x5555555555555555 : 0x1249249249249249;
+        static constexpr Key mask = Key(bits * int(Len) == 64 ? lanes : lanes & ((uint64_t(1) << (bits * int(Len))) - 1));
+
+        inline static constexpr auto spread(uint64_t $1) -> uint64_t {
+            if constexpr (Len == 2) {
+                $1 &= 0x00000000ffffffff;
+                $1 = ($1 | ($1 << 16)) & 0x0000ffff0000ffff;
+                $1 = ($1 | ($1 << 8)) & 0x00ff00ff00ff00ff;
+                $1 = ($1 | ($1 << 4)) & 0x0f0f0f0f0f0f0f0f;
+                $1 = ($1 | ($1 << 2)) & 0x3333333333333333;
+                $1 = ($1 | ($1 << 1)) & 0x5555555555555555;
+            } else {
+                $1 &= 0x00000000001fffff;
+                $1 = ($1 | ($1 << 32)) & 0x001f00000000ffff;
+                $1 = ($1 | ($1 << 16)) & 0x001f0000ff0000ff;
+                $1 = ($1 | ($1 << 8)) & 0x100f00f00f00f00f;
+                $1 = ($1 | ($1 << 4)) & 0x10c30c30c30c30c3;
+                $1 = ($1 | ($1 << 2)) & 0x1249249249249249;
+            }
+            return $1;
+        }
+        inline static constexpr auto compact(uint64_t $1) -> uint64_t {
+            if constexpr (Len == 2) {
+                $1 &= 0x5555555555555555;
+                $1 = ($1 | ($1 >> 1)) & 0x3333333333333333;
+                $1 = ($1 | ($1 >> 2)) & 0x0f0f0f0f0f0f0f0f;
+                $1 = ($1 | ($1 >> 4)) & 0x00ff00ff00ff00ff;
+                $1 = ($1 | ($1 >> 8)) & 0x0000ffff0000ffff;
+                $1 = ($1 | ($1 >> 16)) & 0x00000000ffffffff;
+            } else {
+                $1 &= 0x1249249249249249;
+                $1 = ($1 | ($1 >> 2)) & 0x10c30c30c30c30c3;
+                $1 = ($1 | ($1 >> 4)) & 0x100f00f00f00f00f;
+                $1 = ($1 | ($1 >> 8)) & 0x001f0000ff0000ff;
+                $1 = ($1 | ($1 >> 16)) & 0x001f00000000ffff;
+                $1 = ($1 | ($1 >> 32)) & 0x00000000001fffff;
+            }
+            return $1;
+        }
+
+        inline static constexpr auto encode(Vec const& $1) -> Key {
+            uint64_t key = spread(uint64_t($1[0])) | (spread(uint64_t($1[1])) << 1);
+            if constexpr (Len == 3) {
+                key |= spread(uint64_t($1[2])) << 2;
+            }
+            return Key(key);
+        }
+        inline static constexpr auto decode(Key $1) -> Vec {
+            if constexpr (Len == 2) {
+                return Vec{T(compact($1)), T(compact($1 >> 1))};
+            } else {
+                return Vec{T(compact($1)), T(compact($1 >> 1)), T(compact($1 >> 2))};
+            }
+        }
+        inline static void encode(std::span<Vec const> $1, std::span<Key> $2) {
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                $2[i] = encode($1[i]);
+            }
+        }
+    };
+
+#if defined(__BMI2__)
+    // one pdep or pext per component; the masks select the key bits of that component
+    template<std::unsigned_integral T, size_t Len> requires(Len == 2 || Len == 3)
+    struct morton_impl : morton_scalar<T, Len> {
+        using Base = morton_scalar<T, Len>;
+        using Key = typename Base::Key;
+        using Vec = vec_t<T, Len>;
+
+        using Base::mask;
+
+        inline static auto deposit(T $1, Key $2) -> Key {
+            if constexpr (sizeof(Key) == 4) {
+                return _pdep_u32(uint32_t($1), $2);
+            } else {
+                return _pdep_u64(uint64_t($1), $2);
+            }
+        }
+        inline static auto extract(Key $1, Key $2) -> T {
+            if constexpr (sizeof(Key) == 4) {
+                return T(_pext_u32($1, $2));
+            } else {
+                return T(_pext_u64($1, $2));
+            }
+        }
+
+        inline static constexpr auto encode(Vec const& $1) -> Key {
+            if consteval {
+                return Base::encode($1);
+            } else {
+                Key key = deposit($1[0], mask) | deposit($1[1], Key(mask << 1));
+                if constexpr (Len == 3) {
+                    key |= deposit($1[2], Key(mask << 2));
+                }
+                return key;
+            }
+        }
+        inline static constexpr auto decode(Key $1) -> Vec {
+            if consteval {
+                return Base::decode($1);
+            } else {
+                if constexpr (Len == 2) {
+                    return Vec{extract($1, mask), extract($1, Key(mask << 1))};
+                } else {
+                    return Vec{extract($1, mask), extract($1, Key(mask << 1)), extract($1, Key(mask << 2))};
+                }
+            }
+        }
+        inline static void encode(std::span<Vec const> $1, std::span<Key> $2) {
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                $2[i] = encode($1[i]);
+            }
+        }
+    };
+#else
+    template<std::unsigned_integral T, size_t Len> requires(Len == 2 || Len == 3)
+    struct morton_impl : morton_scalar<T, Len> {};
+#endif
+
+    // stable LSD radix sort with one byte per pass. Bytes that every key shares are skipped, so keys
+    // that use few of their bits take few passes, and each pass counts the digits of the next one.
+    // Inputs must have fewer than 2^32 elements
+    template<std::unsigned_integral K>
+    struct radix_impl {
+        // indices are 32 bits, so at most 2^32 keys
+        inline static auto order(std::span<K const> $1) -> std::vector<uint32_t> {
+            size_t count = $1.size();
+            if (count > size_t(std::numeric_limits<uint32_t>::max()) + 1) {
+                throw std::length_error("math::radix_impl::order: more than 2^32 keys");
+            }
+            K varying = 0;
+            for (K key : $1) {
+                varying |= key ^ $1[0];
+            }
+
+            size_t digits[sizeof(K)];
+            size_t passes = 0;
+            for (size_t p = 0; p < sizeof(K); p += 1) {
+                if (((varying >> (p * 8)) & 0xff) != 0) {
+                    digits[passes++] = p * 8;
+                }
+            }
+
+            std::vector<uint32_t> order(count);
+            if (passes == 0) {
+                for (size_t i = 0; i < count; i += 1) {
+                    order[i] = uint32_t(i);
+                }
+                return order;
+            }
+
+            size_t histogram[256] = {};
+            for (K key : $1) {
+                histogram[(key >> digits[0]) & 0xff] += 1;
+            }
+
+            // keys travel with their source index, so each pass scatters to one array
+            struct entry {
+                K key;
+                uint32_t index;
+            };
+            std::vector<entry> entries(count);
+            std::vector<entry> next_entries(count);
+            for (size_t p = 0; p < passes; p += 1) {
+                size_t offsets[256];
+                size_t sum = 0;
+                for (size_t d = 0; d < 256; d += 1) {
+                    offsets[d] = sum;
+                    sum += histogram[d];
+                    histogram[d] = 0;
+                }
+
+                size_t shift = digits[p];
+                size_t next = p + 1 < passes ? digits[p + 1] : 0;
+                if (p == 0) {
+                    for (size_t i = 0; i < count; i += 1) {
+                        K key = $1[i];
+                        next_entries[offsets[(key >> shift) & 0xff]++] = entry{key, uint32_t(i)};
+                        histogram[(key >> next) & 0xff] += 1;
+                    }
+                } else {
+                    for (entry const& e : entries) {
+                        next_entries[offsets[(e.key >> shift) & 0xff]++] = e;
+                        histogram[(e.key >> next) & 0xff] += 1;
+                    }
+                }
+                entries.swap(next_entries);
+            }
+            for (size_t i = 0; i < count; i += 1) {
+                order[i] = entries[i].index;
+            }
+            return order;
+        }
+
+        // $1[i] = old $1[$2[i]]
+        template<typename E>
+        inline static void permute(std::span<E> $1, std::span<uint32_t const> $2) {
+            require_size($1.size(), $2.size(), "math::radix_impl::permute: span is shorter than the order");
+            std::vector<E> sorted;
+            sorted.reserve($2.size());
+            for (uint32_t i : $2) {
+                sorted.push_back(std::move($1[i]));
+            }
+            std::move(sorted.begin(), sorted.end(), $1.begin());
+        }
+    };
+
+    export template<std::unsigned_integral T, size_t Len> requires(Len == 2 || Len == 3)
+    using morton_key_t = typename morton_scalar<T, Len>::Key;
+
+    export template<std::unsigned_integral T, size_t Len> requires(Len == 2 || Len == 3)
+    inline constexpr auto morton_encode(vec_t<T, Len> const& $1) -> morton_key_t<T, Len> {
+        return morton_impl<T, Len>::encode($1);
+    }
+    // morton_decode<uint32_t, 3>(key)
+    export template<std::unsigned_integral T, size_t Len> requires(Len == 2 || Len == 3)
+    inline constexpr auto morton_decode(std::type_identity_t<morton_key_t<T, Len>> $1) -> vec_t<T, Len> {
+        return morton_impl<T, Len>::decode($1);
+    }
+    template<typename Range>
+    concept morton_range = vec_range<Range> && std::unsigned_integral<vec_range_scalar<Range>> && (vec_range_length<Range> == 2 || vec_range_length<Range> == 3);
+
+    template<typename Range>
+    using morton_range_impl = morton_impl<vec_range_scalar<Range>, vec_range_length<Range>>;
+
+    // $1 is any contiguous range of cells, e.g. a std::vector<u32vec3>; $2 must hold at least as many keys
+    export template<morton_range Range>
+    inline void morton_encode(Range&& $1, std::span<morton_key_t<vec_range_scalar<Range>, vec_range_length<Range>>> $2) {
+        vec_range_span<Range> cells($1);
+        require_size($2.size(), cells.size(), "math::morton_encode: output is shorter than the cells");
+        morton_range_impl<Range>::encode(cells, $2);
+    }
+    // sorts $1 into Morton order and applies the same permutation to the first $1.size() elements of
+    // each companion range, e.g. the positions that belong to the cells; stable, so equal cells keep their order.
+    // Every companion must hold at least $1.size() elements, and $1 at most 2^32
+    export template<morton_range Range, std::ranges::contiguous_range... C>
+    inline void morton_sort(Range&& $1, C&&... $2) {
+        using Key = morton_key_t<vec_range_scalar<Range>, vec_range_length<Range>>;
+        std::span<range_vec_t<Range>> cells($1);
+        std::vector<Key> keys(cells.size());
+        morton_range_impl<Range>::encode(vec_range_span<Range>(cells), std::span<Key>(keys));
+        std::vector<uint32_t> order = radix_impl<Key>::order(keys);
+        (require_size(std::ranges::size($2), cells.size(), "math::morton_sort: companion range is shorter than the cells"), ...);
+        radix_impl<Key>::permute(cells, std::span<uint32_t const>(order));
+        (radix_impl<Key>::permute(std::span<std::remove_reference_t<std::ranges::range_reference_t<C>>>($2), std::span<uint32_t const>(order)), ...);
+    }
+
+    // multiplies every component by its own odd constant, sums, then folds a 64x64->128 product so that
+    // all output bits depend on all input bits; the flat tables take their 7-bit tags from the low bits
+    export struct vec_hash {
+        template<std::integral T, size_t Len>
+        inline constexpr auto operator()(vec_t<T, Len> const& $1) const noexcept -> size_t {
+            using U = std::make_unsigned_t<T>;
+            constexpr uint64_t factors[4] = {0x9e3779b97f4a7c15, 0xc2b2ae3d27d4eb4f, 0x165667b19e3779f9, 0xd6e8feb86659fd93};
+            uint64_t sum = [&]<size_t... I>(std::index_sequence<I...>) {
+                return ((uint64_t(U($1[I])) * factors[I]) + ...);
+            }(std::make_index_sequence<Len>{});
+            unsigned __int128 product = static_cast<unsigned __int128>(sum ^ 0xa0761d6478bd642f) * 0xe7037ed1a0b428db;
+            return size_t(uint64_t(product) ^ uint64_t(product >> 64));
+        }
+    };
+
+    // control bytes of a 16-slot group: empty and erased slots have the high bit set, a full slot
+    // holds the low 7 bits of its key's hash
+    struct group_scalar {
+        static constexpr size_t width = 16;
+        static constexpr int8_t empty = -128;
+        static constexpr int8_t erased = -2;
+
+        inline static auto match(int8_t const* $1, int8_t $2) -> uint32_t {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < width; i += 1) {
+                mask |= uint32_t($1[i] == $2) << i;
+            }
+            return mask;
+        }
+        inline static auto match_empty(int8_t const* $1) -> uint32_t {
+            return match($1, empty);
+        }
+        inline static auto match_free(int8_t const* $1) -> uint32_t {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < width; i += 1) {
+                mask |= uint32_t($1[i] < 0) << i;
+            }
+            return mask;
+        }
+    };
+
+#if defined(__SSE2__)
+    struct group_impl : group_scalar {
+        inline static auto match(int8_t const* $1, int8_t $2) -> uint32_t {
+            __m128i ctrl = _mm_loadu_si128(reinterpret_cast<__m128i const*>($1));
+            return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8($2))));
+        }
+        inline static auto match_empty(int8_t const* $1) -> uint32_t {
+            return match($1, empty);
+        }
+        inline static auto match_free(int8_t const* $1) -> uint32_t {
+            return uint32_t(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>($1))));
+        }
+    };
+#else
+    struct group_impl : group_scalar {};
+#endif
+
+    // value storage of a flat table; sets have none
+    template<typename V>
+    struct flat_values {
+        using type = std::vector<V>;
+    };
+    template<>
+    struct flat_values<void> {
+        struct type {};
+    };
+
+    // open addressing over groups of 16 slots: the hash picks a start group and a 7-bit tag, a probe
+    // compares the tag against a whole group at once and only reads keys whose tag matches, and it stops
+    // at the first group that still has an empty slot. Groups are visited in triangular steps, which
+    // reaches every group of a power-of-two table. Keys and values live in separate arrays, so probing
+    // touches only control bytes and keys. V is void for sets; otherwise it must be default-constructible
+    template<typename K, typename V, typename Hash>
+    struct flat_table {
+        using Group = group_impl;
+        using Values = typename flat_values<V>::type;
+
+        static constexpr size_t npos = size_t(-1);
+        static constexpr size_t block = 16;
+
+        std::vector<int8_t> __ctrl;
+        std::vector<K> __keys;
+        [[no_unique_address]] Values __values;
+        [[no_unique_address]] Hash __hash;
+        size_t __size = 0;
+        // empty slots that can still be filled before the load factor reaches 7/8
+        size_t __growth = 0;
+
+        inline static constexpr auto limit(size_t $1) -> size_t {
+            return $1 - $1 / 8;
+        }
+
+        inline auto size() const -> size_t {
+            return __size;
+        }
+        inline auto empty() const -> bool {
+            return __size == 0;
+        }
+        inline auto capacity() const -> size_t {
+            return __ctrl.size();
+        }
+
+        inline auto locate(K const& $1, size_t $2) const -> size_t {
+            if (__ctrl.empty()) {
+                return npos;
+            }
+            size_t mask = __ctrl.size() / Group::width - 1;
+            int8_t tag = int8_t($2 & 0x7f);
+            size_t group = ($2 >> 7) & mask;
+            for (size_t step = 1;; step += 1) {
+                int8_t const* ctrl = __ctrl.data() + group * Group::width;
+                for (uint32_t m = Group::match(ctrl, tag); m != 0; m &= m - 1) {
+                    size_t slot = group * Group::width + size_t(std::countr_zero(m));
+                    if (__keys[slot] == $1) {
+                        return slot;
+                    }
+                }
+                if (Group::match_empty(ctrl) != 0) {
+                    return npos;
+                }
+                group = (group + step) & mask;
+            }
+        }
+        inline auto locate(K const& $1) const -> size_t {
+            return locate($1, __hash($1));
+        }
+
+        // hashes a block of keys and prefetches their first groups before probing any of them, so the
+        // cache misses of the whole block overlap; $2(i, slot) gets npos for a missing key
+        template<typename Fn>
+        inline void locate(std::span<K const> $1, Fn&& $2) const {
+            if (__ctrl.empty()) {
+                for (size_t i = 0; i < $1.size(); i += 1) {
+                    $2(i, npos);
+                }
+                return;
+            }
+            size_t mask = __ctrl.size() / Group::width - 1;
+            size_t hashes[block];
+            for (size_t i = 0; i < $1.size(); i += block) {
+                size_t count = std::min(block, $1.size() - i);
+                for (size_t j = 0; j < count; j += 1) {
+                    hashes[j] = __hash($1[i + j]);
+                    size_t first = ((hashes[j] >> 7) & mask) * Group::width;
+                    __builtin_prefetch(__ctrl.data() + first);
+                    __builtin_prefetch(__keys.data() + first);
+                }
+                for (size_t j = 0; j < count; j += 1) {
+                    $2(i + j, locate($1[i + j], hashes[j]));
+                }
+            }
+        }
+
+        // first empty or erased slot on the probe sequence of hash $1
+        inline auto free_slot(size_t $1) const -> size_t {
+            size_t mask = __ctrl.size() / Group::width - 1;
+            size_t group = ($1 >> 7) & mask;
+            for (size_t step = 1;; step += 1) {
+                if (uint32_t m = Group::match_free(__ctrl.data() + group * Group::width); m != 0) {
+                    return group * Group::width + size_t(std::countr_zero(m));
+                }
+                group = (group + step) & mask;
+            }
+        }
+
+        // the slot of $1 and whether it was just taken; a new slot holds $1 and a default value
+        inline auto claim(K const& $1) -> std::pair<size_t, bool> {
+            size_t hash = __hash($1);
+            if (size_t slot = locate($1, hash); slot != npos) {
+                return {slot, false};
+            }
+            if (__growth == 0) {
+                // reuse the same capacity when erased slots hold at least half of the load
+                size_t capacity = __ctrl.size();
+                rehash(capacity == 0 ? Group::width : __size >= limit(capacity) / 2 ? capacity * 2 : capacity);
+            }
+            size_t slot = free_slot(hash);
+            if (__ctrl[slot] == Group::empty) {
+                __growth -= 1;
+            }
+            __ctrl[slot] = int8_t(hash & 0x7f);
+            __keys[slot] = $1;
+            __size += 1;
+            return {slot, true};
+        }
+
+        inline void release(size_t $1) {
+            // probes only continue past groups without an empty slot, so if this group has one
+            // no probe depends on the slot staying occupied
+            if (Group::match_empty(__ctrl.data() + $1 / Group::width * Group::width) != 0) {
+                __ctrl[$1] = Group::empty;
+                __growth += 1;
+            } else {
+                __ctrl[$1] = Group::erased;
+            }
+            if constexpr (!std::is_void_v<V>) {
+                __values[$1] = V{};
+            }
+            __size -= 1;
+        }
+
+        // $1 is a power of two and at least one group
+        inline void rehash(size_t $1) {
+            std::vector<int8_t> ctrl = std::exchange(__ctrl, std::vector<int8_t>($1, Group::empty));
+            std::vector<K> keys = std::exchange(__keys, std::vector<K>($1));
+            Values values;
+            if constexpr (!std::is_void_v<V>) {
+                values = std::exchange(__values, Values($1));
+            }
+            __growth = limit($1) - __size;
+            for (size_t i = 0; i < ctrl.size(); i += 1) {
+                if (ctrl[i] >= 0) {
+                    size_t slot = free_slot(__hash(keys[i]));
+                    __ctrl[slot] = ctrl[i];
+                    __keys[slot] = keys[i];
+                    if constexpr (!std::is_void_v<V>) {
+                        __values[slot] = std::move(values[i]);
+                    }
+                }
+            }
+        }
+
+        // room for $1 elements without rehashing
+        inline void reserve(size_t $1) {
+            size_t capacity = Group::width;
+            while (limit(capacity) < $1) {
+                capacity *= 2;
+            }
+            if (capacity > __ctrl.size()) {
+                rehash(capacity);
+            }
+        }
+        inline void clear() {
+            for (size_t i = 0; i < __ctrl.size(); i += 1) {
+                if constexpr (!std::is_void_v<V>) {
+                    if (__ctrl[i] >= 0) {
+                        __values[i] = V{};
+                    }
+                }
+                __ctrl[i] = Group::empty;
+            }
+            __size = 0;
+            __growth = limit(__ctrl.size());
+        }
+
+        inline auto contains(K const& $1) const -> bool {
+            return locate($1) != npos;
+        }
+        inline void contains(std::span<K const> $1, std::span<bool> $2) const {
+            locate($1, [&](size_t i, size_t slot) {
+                $2[i] = slot != npos;
+            });
+        }
+        inline auto erase(K const& $1) -> bool {
+            size_t slot = locate($1);
+            if (slot == npos) {
+                return false;
+            }
+            release(slot);
+            return true;
+        }
+    };
+
+    export template<typename K, typename V, typename Hash = vec_hash>
+    struct flat_map : flat_table<K, V, Hash> {
+        using Base = flat_table<K, V, Hash>;
+
+        flat_map() = default;
+        explicit flat_map(size_t $1) {
+            Base::reserve($1);
+        }
+
+        // nullptr when $1 is missing
+        template<typename Self>
+        inline auto find(this Self& self, K const& $1) -> std::conditional_t<std::is_const_v<Self>, V const*, V*> {
+            size_t slot = self.locate($1);
+            return slot == Base::npos ? nullptr : self.__values.data() + slot;
+        }
+        inline void find(std::span<K const> $1, std::span<V*> $2) {
+            Base::locate($1, [&](size_t i, size_t slot) {
+                $2[i] = slot == Base::npos ? nullptr : Base::__values.data() + slot;
+            });
+        }
+        inline void find(std::span<K const> $1, std::span<V const*> $2) const {
+            Base::locate($1, [&](size_t i, size_t slot) {
+                $2[i] = slot == Base::npos ? nullptr : Base::__values.data() + slot;
+            });
+        }
+
+        // leaves an existing value unchanged; true when $1 was added
+        inline auto insert(K const& $1, V $2) -> bool {
+            auto [slot, inserted] = Base::claim($1);
+            if (inserted) {
+                Base::__values[slot] = std::move($2);
+            }
+            return inserted;
+        }
+        inline auto insert_or_assign(K const& $1, V $2) -> bool {
+            auto [slot, inserted] = Base::claim($1);
+            Base::__values[slot] = std::move($2);
+            return inserted;
+        }
+        inline auto operator[](K const& $1) -> V& {
+            return Base::__values[Base::claim($1).first];
+        }
+
+        // $1(key, value) for every element, in slot order
+        template<typename Self, typename Fn>
+        inline void for_each(this Self& self, Fn&& $1) {
+            for (size_t i = 0; i < self.__ctrl.size(); i += 1) {
+                if (self.__ctrl[i] >= 0) {
+                    $1(std::as_const(self.__keys[i]), self.__values[i]);
+                }
+            }
+        }
+    };
+
+    export template<typename K, typename Hash = vec_hash>
+    struct flat_set : flat_table<K, void, Hash> {
+        using Base = flat_table<K, void, Hash>;
+
+        flat_set() = default;
+        explicit flat_set(size_t $1) {
+            Base::reserve($1);
+        }
+
+        // true when $1 was added
+        inline auto insert(K const& $1) -> bool {
+            return Base::claim($1).second;
+        }
+
+        template<typename Fn>
+        inline void for_each(Fn&& $1) const {
+            for (size_t i = 0; i < Base::__ctrl.size(); i += 1) {
+                if (Base::__ctrl[i] >= 0) {
+                    $1(Base::__keys[i]);
+                }
+            }
+        }
+    };
+
+    export template<typename T>
+    inline constexpr auto mat2x2(mat_t<T, 3, 3> const& $1) -> mat_t<T, 2, 2> {
+        return {
+            $1.__columns[0].xy,
+            $1.__columns[1].xy,
+        };
+    }
+
+    export template<typename T>
+    inline constexpr auto mat3x3(mat_t<T, 4, 4> const& $1) -> mat_t<T, 3, 3> {
+        return {
+            $1.__columns[0].xyz,
+            $1.__columns[1].xyz,
+            $1.__columns[2].xyz,
+        };
+    }
+
+    export template<std::floating_point T>
+    inline constexpr auto inverse(mat_t<T, 4, 4> const& $1) -> mat_t<T, 4, 4> {
+        T det;
+        return mat_impl<T, 4, 4>::inverse($1, det);
+    }
+    // also reports the determinant, so singular input can be detected without a second pass
+    export template<std::floating_point T>
+    inline constexpr auto inverse(mat_t<T, 4, 4> const& $1, T& $2) -> mat_t<T, 4, 4> {
+        return mat_impl<T, 4, 4>::inverse($1, $2);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto inverse_affine(mat_t<T, 4, 4> const& $1) -> mat_t<T, 4, 4> {
+        return mat_impl<T, 4, 4>::inverse_affine($1);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto inverse_rigid(mat_t<T, 4, 4> const& $1) -> mat_t<T, 4, 4> {
+        return mat_impl<T, 4, 4>::inverse_rigid($1);
+    }
+    template<std::floating_point T>
+    struct inverse_batch {
+        using Mat = mat_t<T, 4, 4>;
+
+        inline static void inverse(std::span<Mat const> $1, std::span<Mat> $2, std::span<T> $3) {
+            T det;
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                $2[i] = mat_impl<T, 4, 4>::inverse($1[i], det);
+                if (!$3.empty()) {
+                    $3[i] = det;
+                }
+            }
+        }
+        inline static void inverse_affine(std::span<Mat const> $1, std::span<Mat> $2) {
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                $2[i] = mat_impl<T, 4, 4>::inverse_affine($1[i]);
+            }
+        }
+        inline static void inverse_rigid(std::span<Mat const> $1, std::span<Mat> $2) {
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                $2[i] = mat_impl<T, 4, 4>::inverse_rigid($1[i]);
+            }
+        }
+    };
+
+    // one overload per element type, as for normalize_all, so containers and mutable spans convert;
+    // $3 receives the determinants when it is not empty
+    export inline void inverse(std::span<mat_t<float, 4, 4> const> $1, std::span<mat_t<float, 4, 4>> $2, std::span<float> $3 = {}) {
+        inverse_batch<float>::inverse($1, $2, $3);
+    }
+    export inline void inverse(std::span<mat_t<double, 4, 4> const> $1, std::span<mat_t<double, 4, 4>> $2, std::span<double> $3 = {}) {
+        inverse_batch<double>::inverse($1, $2, $3);
+    }
+    export inline void inverse_affine(std::span<mat_t<float, 4, 4> const> $1, std::span<mat_t<float, 4, 4>> $2) {
+        inverse_batch<float>::inverse_affine($1, $2);
+    }
+    export inline void inverse_affine(std::span<mat_t<double, 4, 4> const> $1, std::span<mat_t<double, 4, 4>> $2) {
+        inverse_batch<double>::inverse_affine($1, $2);
+    }
+    export inline void inverse_rigid(std::span<mat_t<float, 4, 4> const> $1, std::span<mat_t<float, 4, 4>> $2) {
+        inverse_batch<float>::inverse_rigid($1, $2);
+    }
+    export inline void inverse_rigid(std::span<mat_t<double, 4, 4> const> $1, std::span<mat_t<double, 4, 4>> $2) {
+        inverse_batch<double>::inverse_rigid($1, $2);
+    }
+
+    // one counter for every cached matrix in the process, so a generation is never handed out twice:
+    // a copy, an assignment or a write can never bring back a value that a product recorded earlier
+    inline auto next_generation() -> uint64_t {
+        static std::atomic<uint64_t> counter = 0;
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    // a 4x4 matrix with its inverse and normal matrix computed on first use after each write. Every read,
+    // const or not, may fill a cache and counts a hit or miss, so an instance and every product over it
+    // belong to one thread at a time; a copy per thread is the cheap way to share one
+    export template<std::floating_point T>
+    struct cached_transform {
+        using Mat = mat_t<T, 4, 4>;
+
+        static constexpr uint64_t stale = std::numeric_limits<uint64_t>::max();
+
+        // written through set() only: a direct write bumps no generation, so caches and products keep the old value
+        Mat __matrix;
+        // fresh from next_generation() on construction and on every write; products compare it to notice changes
+        uint64_t __generation = next_generation();
+        mutable Mat __inverse{};
+        mutable mat_t<T, 3, 3> __normal{};
+        // __generation when each cache was filled
+        mutable uint64_t __inverse_generation = stale;
+        mutable uint64_t __normal_generation = stale;
+        mutable size_t __hits = 0;
+        mutable size_t __misses = 0;
+
+        cached_transform() : __matrix{{{T(1), T(0), T(0), T(0)}, {T(0), T(1), T(0), T(0)}, {T(0), T(0), T(1), T(0)}, {T(0), T(0), T(0), T(1)}}} {}
+        explicit cached_transform(Mat const& $1) : __matrix($1) {}
+        cached_transform(cached_transform const& $1) {
+            adopt($1);
+        }
+        inline auto operator=(cached_transform const& $1) -> cached_transform& {
+            if (this != &$1) {
+                adopt($1);
+            }
+            return *this;
+        }
+
+        inline auto matrix() const -> Mat const& {
+            return __matrix;
+        }
+        inline auto generation() const -> uint64_t {
+            return __generation;
+        }
+        inline void set(Mat const& $1) {
+            __matrix = $1;
+            __generation = next_generation();
+        }
+
+        inline auto inverse() const -> Mat const& {
+            if (miss(__inverse_generation)) {
+                T det;
+                __inverse = mat_impl<T, 4, 4>::inverse(__matrix, det);
+            }
+            return __inverse;
+        }
+        // inverse transpose of the upper 3x3, which keeps normals perpendicular under non-uniform scale:
+        // its columns are the cofactor rows over the determinant
+        inline auto normal_matrix() const -> mat_t<T, 3, 3> const& {
+            if (miss(__normal_generation)) {
+                vec_t<T, 3> a = __matrix.__columns[0].xyz;
+                vec_t<T, 3> b = __matrix.__columns[1].xyz;
+                vec_t<T, 3> c = __matrix.__columns[2].xyz;
+                vec_t<T, 3> r0 = cross(b, c);
+                T det = dot(a, r0);
+                __normal = mat_t<T, 3, 3>{r0 / det, cross(c, a) / det, cross(a, b) / det};
+            }
+            return __normal;
+        }
+
+        // cache reads served without recomputing, and those that recomputed
+        inline auto hits() const -> size_t {
+            return __hits;
+        }
+        inline auto misses() const -> size_t {
+            return __misses;
+        }
+
+        // true when the cache filled at generation $1 is out of date, which marks it current for the caller to refill
+        inline auto miss(uint64_t& $1) const -> bool {
+            if ($1 == __generation) {
+                __hits += 1;
+                return false;
+            }
+            $1 = __generation;
+            __misses += 1;
+            return true;
+        }
+        // takes the matrix and whatever caches $1 has current under a fresh generation; the counters stay
+        inline void adopt(cached_transform const& $1) {
+            __matrix = $1.__matrix;
+            __generation = next_generation();
+            __inverse = $1.__inverse;
+            __normal = $1.__normal;
+            __inverse_generation = $1.__inverse_generation == $1.__generation ? __generation : stale;
+            __normal_generation = $1.__normal_generation == $1.__generation ? __generation : stale;
+        }
+    };
+
+    // $1 * $2 of two cached transforms or products, such as view * projection, recomputed on the first
+    // read after either side was written. Both sides must outlive the product, and reads write its caches,
+    // so it stays on the thread that owns the sides
+    export template<typename L, typename R>
+    struct cached_product {
+        using Mat = std::remove_cvref_t<decltype(std::declval<L const&>().matrix())>;
+        using T = std::remove_cvref_t<decltype(std::declval<Mat const&>().__columns[0][0])>;
+
+        L const* __lhs;
+        R const* __rhs;
+        // the product, so its inverse and normal matrix are cached as well
+        mutable cached_transform<T> __value;
+        // generation of each side at the last product
+        mutable uint64_t __lhs_generation = cached_transform<T>::stale;
+        mutable uint64_t __rhs_generation = cached_transform<T>::stale;
+        mutable size_t __hits = 0;
+        mutable size_t __misses = 0;
+
+        cached_product(L const& $1, R const& $2) : __lhs(&$1), __rhs(&$2) {}
+
+        inline auto matrix() const -> Mat const& {
+            return value().matrix();
+        }
+        inline auto inverse() const -> Mat const& {
+            return value().inverse();
+        }
+        inline auto normal_matrix() const -> mat_t<T, 3, 3> const& {
+            return value().normal_matrix();
+        }
+        // the generation of the cached product, fresh after each recompute, so products can nest
+        inline auto generation() const -> uint64_t {
+            refresh();
+            return __value.generation();
+        }
+
+        // the product's own reads plus those of its inverse and normal matrix
+        inline auto hits() const -> size_t {
+            return __hits + __value.hits();
+        }
+        inline auto misses() const -> size_t {
+            return __misses + __value.misses();
+        }
+
+        // recomputes the product when either side was written since the last one; true when it did
+        inline auto refresh() const -> bool {
+            uint64_t lhs = __lhs->generation();
+            uint64_t rhs = __rhs->generation();
+            if (__lhs_generation == lhs && __rhs_generation == rhs) {
+                return false;
+            }
+            __lhs_generation = lhs;
+            __rhs_generation = rhs;
+            __misses += 1;
+            __value.set(mat_impl<T, 4, 4>::mul(__lhs->matrix(), __rhs->matrix()));
+            return true;
+        }
+        inline auto value() const -> cached_transform<T> const& {
+            if (!refresh()) {
+                __hits += 1;
+            }
+            return __value;
+        }
+    };
+
+    export template<typename T, size_t Align = 64>
+    struct aligned_allocator {
+        using value_type = T;
+
+        template<typename U>
+        struct rebind {
+            using other = aligned_allocator<U, Align>;
+        };
+
+        constexpr aligned_allocator() noexcept = default;
+
+        template<typename U>
+        constexpr aligned_allocator(aligned_allocator<U, Align> const&) noexcept {}
+
+        auto allocate(size_t count) -> T* {
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{Align}));
+        }
+        void deallocate(T* ptr, size_t) noexcept {
+            ::operator delete(ptr, std::align_val_t{Align});
+        }
+
+        friend constexpr auto operator==(aligned_allocator const&, aligned_allocator const&) -> bool = default;
+    };
+
+    template<typename T, size_t Len, typename = std::make_index_sequence<Len>>
+    struct soa_impl;
+
+    export template<typename T, size_t Len>
+    struct vec_soa;
+
+    export template<typename T, size_t Len, typename Soa>
+    struct vec_soa_ref final {
+        using Self = vec_soa_ref;
+
+        Soa* __soa;
+        size_t __index;
+
+        constexpr operator vec_t<T, Len>() const {
+            return soa_impl<T, Len>::get(*__soa, __index);
+        }
+        constexpr auto operator=(vec_t<T, Len> const& $1) const -> Self const& requires(!std::is_const_v<Soa>) {
+            soa_impl<T, Len>::put(*__soa, __index, $1);
+            return *this;
+        }
+        constexpr auto operator=(Self const& $1) const -> Self const& requires(!std::is_const_v<Soa>) {
+            return *this = static_cast<vec_t<T, Len>>($1);
+        }
+        constexpr auto operator[](size_t i) const -> forward_like_t<Soa&, T> {
+            return __soa->__streams[i][__index];
+        }
+    };
+
+    export template<typename T, size_t Len>
+    struct vec_soa final {
+        using Self = vec_soa;
+        using value_type = vec_t<T, Len>;
+
+        std::vector<T, aligned_allocator<T>> __streams[Len];
+
+        constexpr auto size(this Self const& self) -> size_t {
+            return self.__streams[0].size();
+        }
+        constexpr auto empty(this Self const& self) -> bool {
+            return self.__streams[0].empty();
+        }
+        constexpr void resize(this Self& self, size_t count) {
+            for (auto& stream : self.__streams) {
+                stream.resize(count);
+            }
+        }
+        constexpr void reserve(this Self& self, size_t count) {
+            for (auto& stream : self.__streams) {
+                stream.reserve(count);
+            }
+        }
+        constexpr void clear(this Self& self) {
+            for (auto& stream : self.__streams) {
+                stream.clear();
+            }
+        }
+        constexpr void push_back(this Self& self, vec_t<T, Len> const& $1) {
+            soa_impl<T, Len>::push_back(self, $1);
+        }
+        constexpr void assign(this Self& self, std::span<vec_t<T, Len> const> $1) {
+            soa_impl<T, Len>::assign(self, $1);
+        }
+        constexpr void copy_to(this Self const& self, std::span<vec_t<T, Len>> $1) {
+            soa_impl<T, Len>::copy_to(self, $1);
+        }
+
+        template<typename Self>
+        constexpr auto stream(this Self&& self, size_t i) -> std::span<std::remove_reference_t<forward_like_t<Self, T>>> {
+            return self.__streams[i];
+        }
+        template<typename Self>
+        constexpr auto operator[](this Self&& self, size_t i) -> vec_soa_ref<T, Len, std::remove_reference_t<Self>> {
+            return {&self, i};
+        }
+    };
+
+    template<typename T, size_t Len, size_t... I>
+    struct soa_impl<T, Len, std::index_sequence<I...>> {
+        using Self = vec_soa<T, Len>;
+        using Pack = simd<T, simd_width<T>>;
+        using Lane = simd<T, 1>;
+
+        // runs kernel over full packs, then finishes the tail one lane at a time
+        template<typename Kernel>
+        inline static void each(size_t count, Kernel const& kernel) {
+            size_t i = 0;
+            for (; i + Pack::width <= count; i += Pack::width) {
+                kernel(Pack{}, i);
+            }
+            for (; i < count; i += 1) {
+                kernel(Lane{}, i);
+            }
+        }
+
+        template<typename P>
+        inline static auto dot(Self const& $1, Self const& $2, size_t i) -> P {
+            return ((P::load($1.__streams[I].data() + i) * P::load($2.__streams[I].data() + i)) + ...);
+        }
+
+        inline static constexpr auto get(Self const& $1, size_t i) -> vec_t<T, Len> {
+            return vec_t<T, Len>{$1.__streams[I][i]...};
+        }
+        inline static constexpr void put(Self& $1, size_t i, vec_t<T, Len> const& $2) {
+            (($1.__streams[I][i] = $2[I]), ...);
+        }
+        inline static constexpr void push_back(Self& $1, vec_t<T, Len> const& $2) {
+            ($1.__streams[I].push_back($2[I]), ...);
+        }
+        inline static constexpr void assign(Self& $1, std::span<vec_t<T, Len> const> $2) {
+            $1.resize($2.size());
+            for (size_t i = 0; i < $2.size(); i += 1) {
+                put($1, i, $2[i]);
+            }
+        }
+        inline static constexpr void copy_to(Self const& $1, std::span<vec_t<T, Len>> $2) {
+            require_size($2.size(), $1.size(), "math::vec_soa::copy_to: output is shorter than the input");
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                $2[i] = get($1, i);
+            }
+        }
+
+        inline static void add(Self const& $1, Self const& $2, Self& $3) {
+            require_size($2.size(), $1.size(), "math::add: second operand is shorter than the first");
+            $3.resize($1.size());
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                ((P::load($1.__streams[I].data() + i) + P::load($2.__streams[I].data() + i)).store($3.__streams[I].data() + i), ...);
+            });
+        }
+        inline static void sub(Self const& $1, Self const& $2, Self& $3) {
+            require_size($2.size(), $1.size(), "math::sub: second operand is shorter than the first");
+            $3.resize($1.size());
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                ((P::load($1.__streams[I].data() + i) - P::load($2.__streams[I].data() + i)).store($3.__streams[I].data() + i), ...);
+            });
+        }
+        inline static void mul(Self const& $1, Self const& $2, Self& $3) {
+            require_size($2.size(), $1.size(), "math::mul: second operand is shorter than the first");
+            $3.resize($1.size());
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                ((P::load($1.__streams[I].data() + i) * P::load($2.__streams[I].data() + i)).store($3.__streams[I].data() + i), ...);
+            });
+        }
+        inline static void mul(Self const& $1, T const& $2, Self& $3) {
+            $3.resize($1.size());
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                ((P::load($1.__streams[I].data() + i) * P::broadcast($2)).store($3.__streams[I].data() + i), ...);
+            });
+        }
+        inline static void div(Self const& $1, Self const& $2, Self& $3) {
+            require_size($2.size(), $1.size(), "math::div: second operand is shorter than the first");
+            $3.resize($1.size());
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                ((P::load($1.__streams[I].data() + i) / P::load($2.__streams[I].data() + i)).store($3.__streams[I].data() + i), ...);
+            });
+        }
+        inline static void min(Self const& $1, Self const& $2, Self& $3) {
+            require_size($2.size(), $1.size(), "math::min: second operand is shorter than the first");
+            $3.resize($1.size());
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                (P::min(P::load($1.__streams[I].data() + i), P::load($2.__streams[I].data() + i)).store($3.__streams[I].data() + i), ...);
+            });
+        }
+        inline static void max(Self const& $1, Self const& $2, Self& $3) {
+            require_size($2.size(), $1.size(), "math::max: second operand is shorter than the first");
+            $3.resize($1.size());
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                (P::max(P::load($1.__streams[I].data() + i), P::load($2.__streams[I].data() + i)).store($3.__streams[I].data() + i), ...);
+            });
+        }
+        inline static void floor(Self const& $1, Self& $2) requires std::floating_point<T> {
+            $2.resize($1.size());
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                (P::floor(P::load($1.__streams[I].data() + i)).store($2.__streams[I].data() + i), ...);
+            });
+        }
+        inline static void fract(Self const& $1, Self& $2) requires std::floating_point<T> {
+            $2.resize($1.size());
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                ((P::load($1.__streams[I].data() + i) - P::floor(P::load($1.__streams[I].data() + i))).store($2.__streams[I].data() + i), ...);
+            });
+        }
+        inline static void dot(Self const& $1, Self const& $2, std::span<T> $3) {
+            require_size($2.size(), $1.size(), "math::dot: second operand is shorter than the first");
+            require_size($3.size(), $1.size(), "math::dot: output is shorter than the input");
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                dot<P>($1, $2, i).store($3.data() + i);
+            });
+        }
+        inline static void length(Self const& $1, std::span<T> $2) requires std::floating_point<T> {
+            require_size($2.size(), $1.size(), "math::length: output is shorter than the input");
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                P::sqrt(dot<P>($1, $1, i)).store($2.data() + i);
+            });
+        }
+        inline static void normalize(Self const& $1, Self& $2) requires std::floating_point<T> {
+            $2.resize($1.size());
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                P len = P::sqrt(dot<P>($1, $1, i));
+                ((P::load($1.__streams[I].data() + i) / len).store($2.__streams[I].data() + i), ...);
+            });
+        }
+    };
+
+    export template<typename T, size_t Len>
+    inline void add(vec_soa<T, Len> const& $1, vec_soa<T, Len> const& $2, vec_soa<T, Len>& $3) {
+        soa_impl<T, Len>::add($1, $2, $3);
+    }
+    export template<typename T, size_t Len>
+    inline void sub(vec_soa<T, Len> const& $1, vec_soa<T, Len> const& $2, vec_soa<T, Len>& $3) {
+        soa_impl<T, Len>::sub($1, $2, $3);
+    }
+    export template<typename T, size_t Len>
+    inline void mul(vec_soa<T, Len> const& $1, vec_soa<T, Len> const& $2, vec_soa<T, Len>& $3) {
+        soa_impl<T, Len>::mul($1, $2, $3);
+    }
+    export template<typename T, size_t Len>
+    inline void mul(vec_soa<T, Len> const& $1, T const& $2, vec_soa<T, Len>& $3) {
+        soa_impl<T, Len>::mul($1, $2, $3);
+    }
+    export template<typename T, size_t Len>
+    inline void div(vec_soa<T, Len> const& $1, vec_soa<T, Len> const& $2, vec_soa<T, Len>& $3) {
+        soa_impl<T, Len>::div($1, $2, $3);
+    }
+    export template<typename T, size_t Len>
+    inline void min(vec_soa<T, Len> const& $1, vec_soa<T, Len> const& $2, vec_soa<T, Len>& $3) {
+        soa_impl<T, Len>::min($1, $2, $3);
+    }
+    export template<typename T, size_t Len>
+    inline void max(vec_soa<T, Len> const& $1, vec_soa<T, Len> const& $2, vec_soa<T, Len>& $3) {
+        soa_impl<T, Len>::max($1, $2, $3);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline void floor(vec_soa<T, Len> const& $1, vec_soa<T, Len>& $2) {
+        soa_impl<T, Len>::floor($1, $2);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline void fract(vec_soa<T, Len> const& $1, vec_soa<T, Len>& $2) {
+        soa_impl<T, Len>::fract($1, $2);
+    }
+    // T comes from the streams alone, so any contiguous container of T converts to the output span
+    export template<typename T, size_t Len>
+    inline void dot(vec_soa<T, Len> const& $1, vec_soa<T, Len> const& $2, std::span<std::type_identity_t<T>> $3) {
+        soa_impl<T, Len>::dot($1, $2, $3);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline void length(vec_soa<T, Len> const& $1, std::span<std::type_identity_t<T>> $2) {
+        soa_impl<T, Len>::length($1, $2);
+    }
+    export template<std::floating_point T, size_t Len>
+    inline void normalize(vec_soa<T, Len> const& $1, vec_soa<T, Len>& $2) {
+        soa_impl<T, Len>::normalize($1, $2);
+    }
+
+    // lazy expression nodes: every node yields component c of element i as a pack P, so a whole tree
+    // evaluates in one pass with no intermediate vectors; leaves hold references, so an expression
+    // has to be evaluated before the vectors it names go out of scope
+    template<typename E>
+    struct lazy_impl;
+
+    template<typename E>
+    inline constexpr bool is_lazy = false;
+
+    template<typename E>
+    inline constexpr bool is_lazy_mul = false;
+
+    template<typename T, size_t Len>
+    struct lazy_vec {
+        using Self = lazy_vec;
+        using Scalar = T;
+
+        static constexpr size_t length = Len;
+        static constexpr bool streamed = false;
+
+        vec_t<T, Len> const& __value;
+
+        template<typename P>
+        inline auto lane(this Self const& self, size_t c, size_t) -> P {
+            return P::broadcast(self.__value.__fields[c]);
+        }
+        template<typename P>
+        inline auto whole(this Self const& self) -> P {
+            return P::load(self.__value.__fields);
+        }
+        inline static constexpr auto size() -> size_t {
+            return std::numeric_limits<size_t>::max();
+        }
+    };
+
+    template<typename T, size_t Len>
+    struct lazy_soa {
+        using Self = lazy_soa;
+        using Scalar = T;
+
+        static constexpr size_t length = Len;
+        static constexpr bool streamed = true;
+
+        vec_soa<T, Len> const& __value;
+
+        template<typename P>
+        inline auto lane(this Self const& self, size_t c, size_t i) -> P {
+            return P::load(self.__value.__streams[c].data() + i);
+        }
+        constexpr auto size(this Self const& self) -> size_t {
+            return self.__value.size();
+        }
+    };
+
+    // scalars take their type from the vector side, so lazy(a) * 2 broadcasts 2.0f for float vectors
+    template<typename U>
+    struct lazy_scalar {
+        using Self = lazy_scalar;
+        using Scalar = void;
+
+        static constexpr size_t length = 0;
+        static constexpr bool streamed = false;
+
+        U __value;
+
+        template<typename P>
+        inline auto lane(this Self const& self, size_t, size_t) -> P {
+            return P::broadcast(self.__value);
+        }
+        template<typename P>
+        inline auto whole(this Self const& self) -> P {
+            return P::broadcast(self.__value);
+        }
+        inline static constexpr auto size() -> size_t {
+            return std::numeric_limits<size_t>::max();
+        }
+    };
+
+    template<typename... E>
+    struct lazy_node {
+        using Scalar = std::common_type_t<typename std::conditional_t<E::length == 0, std::type_identity<float>, std::type_identity<typename E::Scalar>>::type...>;
+
+        static constexpr size_t length = std::max({E::length...});
+        static constexpr bool streamed = (E::streamed || ...);
+
+        static_assert(((E::length == 0 || E::length == length) && ...), "lazy operands must have the same length");
+    };
+
+    struct lazy_add {
+        template<typename P>
+        inline static auto apply(P $1, P $2) -> P {
+            return $1 + $2;
+        }
+    };
+
+    struct lazy_sub {
+        template<typename P>
+        inline static auto apply(P $1, P $2) -> P {
+            return $1 - $2;
+        }
+    };
+
+    struct lazy_mul {
+        template<typename P>
+        inline static auto apply(P $1, P $2) -> P {
+            return $1 * $2;
+        }
+    };
+
+    struct lazy_div {
+        template<typename P>
+        inline static auto apply(P $1, P $2) -> P {
+            return $1 / $2;
+        }
+    };
+
+    template<typename Op, typename L, typename R>
+    struct lazy_binary : lazy_node<L, R> {
+        using Self = lazy_binary;
+
+        L __lhs;
+        R __rhs;
+
+        operator vec_t<typename Self::Scalar, Self::length>(this Self const& self) {
+            return lazy_impl<Self>::eval(self);
+        }
+
+        template<typename P>
+        inline auto lane(this Self const& self, size_t c, size_t i) -> P {
+            return Op::apply(self.__lhs.template lane<P>(c, i), self.__rhs.template lane<P>(c, i));
+        }
+        template<typename P>
+        inline auto whole(this Self const& self) -> P {
+            return Op::apply(self.__lhs.template whole<P>(), self.__rhs.template whole<P>());
+        }
+        constexpr auto size(this Self const& self) -> size_t {
+            return std::min(self.__lhs.size(), self.__rhs.size());
+        }
+    };
+
+    // a * b + c as one rounding where the target has FMA
+    template<typename A, typename B, typename C>
+    struct lazy_madd : lazy_node<A, B, C> {
+        using Self = lazy_madd;
+
+        A __a;
+        B __b;
+        C __c;
+
+        operator vec_t<typename Self::Scalar, Self::length>(this Self const& self) {
+            return lazy_impl<Self>::eval(self);
+        }
+
+        template<typename P>
+        inline auto lane(this Self const& self, size_t c, size_t i) -> P {
+            return P::madd(self.__a.template lane<P>(c, i), self.__b.template lane<P>(c, i), self.__c.template lane<P>(c, i));
+        }
+        template<typename P>
+        inline auto whole(this Self const& self) -> P {
+            return P::madd(self.__a.template whole<P>(), self.__b.template whole<P>(), self.__c.template whole<P>());
+        }
+        constexpr auto size(this Self const& self) -> size_t {
+            return std::min({self.__a.size(), self.__b.size(), self.__c.size()});
+        }
+    };
+
+    // -0 - x flips the sign of zeros too, unlike 0 - x
+    template<typename X>
+    struct lazy_neg : lazy_node<X> {
+        using Self = lazy_neg;
+
+        X __x;
+
+        operator vec_t<typename Self::Scalar, Self::length>(this Self const& self) {
+            return lazy_impl<Self>::eval(self);
+        }
+
+        template<typename P>
+        inline auto lane(this Self const& self, size_t c, size_t i) -> P {
+            return P::broadcast(-0.0) - self.__x.template lane<P>(c, i);
+        }
+        template<typename P>
+        inline auto whole(this Self const& self) -> P {
+            return P::broadcast(-0.0) - self.__x.template whole<P>();
+        }
+        constexpr auto size(this Self const& self) -> size_t {
+            return self.__x.size();
+        }
+    };
+
+    template<typename T, size_t Len>
+    inline constexpr bool is_lazy<lazy_vec<T, Len>> = true;
+    template<typename T, size_t Len>
+    inline constexpr bool is_lazy<lazy_soa<T, Len>> = true;
+    template<typename U>
+    inline constexpr bool is_lazy<lazy_scalar<U>> = true;
+    template<typename Op, typename L, typename R>
+    inline constexpr bool is_lazy<lazy_binary<Op, L, R>> = true;
+    template<typename A, typename B, typename C>
+    inline constexpr bool is_lazy<lazy_madd<A, B, C>> = true;
+    template<typename X>
+    inline constexpr bool is_lazy<lazy_neg<X>> = true;
+    template<typename L, typename R>
+    inline constexpr bool is_lazy_mul<lazy_binary<lazy_mul, L, R>> = true;
+
+    template<typename E>
+    inline constexpr bool is_lazy_operand = is_lazy<E> || std::is_arithmetic_v<E>;
+    template<typename T, size_t Len>
+    inline constexpr bool is_lazy_operand<vec_t<T, Len>> = std::floating_point<T>;
+    template<typename T, size_t Len>
+    inline constexpr bool is_lazy_operand<vec_soa<T, Len>> = std::floating_point<T>;
+
+    template<typename L, typename R>
+    concept lazy_operands = (is_lazy<L> || is_lazy<R>) && is_lazy_operand<L> && is_lazy_operand<R>;
+
+    template<typename E> requires is_lazy<E>
+    inline auto lift(E const& $1) -> E {
+        return $1;
+    }
+    template<typename U> requires std::is_arithmetic_v<U>
+    inline auto lift(U const& $1) -> lazy_scalar<U> {
+        return {$1};
+    }
+    template<typename T, size_t Len>
+    inline auto lift(vec_t<T, Len> const& $1) -> lazy_vec<T, Len> {
+        return {$1};
+    }
+    template<typename T, size_t Len>
+    inline auto lift(vec_soa<T, Len> const& $1) -> lazy_soa<T, Len> {
+        return {$1};
+    }
+
+    template<typename E>
+    struct lazy_impl {
+        using T = typename E::Scalar;
+        static constexpr size_t Len = E::length;
+
+        // a vector that fills a whole pack is computed in one register, otherwise lane by lane
+        inline static auto eval(E const& $1) -> vec_t<T, Len> {
+            static_assert(!E::streamed, "expressions over vec_soa are evaluated with math::eval(expr, out)");
+            if constexpr (requires { simd<T, Len>::width; } && Len > 1) {
+                vec_t<T, Len> out;
+                $1.template whole<simd<T, Len>>().store(out.__fields);
+                return out;
+            } else {
+                return [&]<size_t... C>(std::index_sequence<C...>) {
+                    return vec_t<T, Len>{$1.template lane<simd<T, 1>>(C, 0).__value...};
+                }(std::make_index_sequence<Len>{});
+            }
+        }
+
+        // component c at index i reads only component c at index i of each operand, so $2 may also be an operand;
+        // the size is the shortest operand, so resizing $2 never reallocates a stream that is being read
+        template<size_t... C>
+        inline static void eval(E const& $1, vec_soa<T, Len>& $2, std::index_sequence<C...>) {
+            $2.resize($1.size());
+            soa_impl<T, Len>::each($2.size(), [&]<typename P>(P, size_t i) {
+                ($1.template lane<P>(C, i).store($2.__streams[C].data() + i), ...);
+            });
+        }
+    };
+
+    // lazy(a) * b + c builds an expression instead of a vec_t; products feeding an add or subtract contract
+    // to fused multiply-add, so results can differ from the eager operators in the last bit
+    export template<std::floating_point T, size_t Len>
+    inline auto lazy(vec_t<T, Len> const& $1) -> lazy_vec<T, Len> {
+        return {$1};
+    }
+    export template<std::floating_point T, size_t Len>
+    inline auto lazy(vec_soa<T, Len> const& $1) -> lazy_soa<T, Len> {
+        return {$1};
+    }
+    export template<typename T, size_t Len>
+    void lazy(vec_t<T, Len> const&&) = delete;
+    export template<typename T, size_t Len>
+    void lazy(vec_soa<T, Len> const&&) = delete;
+
+    export template<typename L, typename R> requires lazy_operands<L, R>
+    inline auto operator+(L const& $1, R const& $2) {
+        auto l = lift($1);
+        auto r = lift($2);
+        if constexpr (is_lazy_mul<decltype(l)>) {
+            return lazy_madd<decltype(l.__lhs), decltype(l.__rhs), decltype(r)>{{}, l.__lhs, l.__rhs, r};
+        } else if constexpr (is_lazy_mul<decltype(r)>) {
+            return lazy_madd<decltype(r.__lhs), decltype(r.__rhs), decltype(l)>{{}, r.__lhs, r.__rhs, l};
+        } else {
+            return lazy_binary<lazy_add, decltype(l), decltype(r)>{{}, l, r};
+        }
+    }
+    export template<typename L, typename R> requires lazy_operands<L, R>
+    inline auto operator-(L const& $1, R const& $2) {
+        auto l = lift($1);
+        auto r = lift($2);
+        if constexpr (is_lazy_mul<decltype(l)>) {
+            return lazy_madd<decltype(l.__lhs), decltype(l.__rhs), lazy_neg<decltype(r)>>{{}, l.__lhs, l.__rhs, {{}, r}};
+        } else if constexpr (is_lazy_mul<decltype(r)>) {
+            return lazy_madd<lazy_neg<decltype(r.__lhs)>, decltype(r.__rhs), decltype(l)>{{}, {{}, r.__lhs}, r.__rhs, l};
+        } else {
+            return lazy_binary<lazy_sub, decltype(l), decltype(r)>{{}, l, r};
+        }
+    }
+    export template<typename L, typename R> requires lazy_operands<L, R>
+    inline auto operator*(L const& $1, R const& $2) {
+        return lazy_binary<lazy_mul, decltype(lift($1)), decltype(lift($2))>{{}, lift($1), lift($2)};
+    }
+    export template<typename L, typename R> requires lazy_operands<L, R>
+    inline auto operator/(L const& $1, R const& $2) {
+        return lazy_binary<lazy_div, decltype(lift($1)), decltype(lift($2))>{{}, lift($1), lift($2)};
+    }
+    export template<typename X> requires is_lazy<X>
+    inline auto operator-(X const& $1) -> lazy_neg<X> {
+        return {{}, $1};
+    }
+
+    // writes an expression over vec_soa operands into $2, one pack of elements at a time; the vec_soa
+    // operands give the element count, so an expression of vec_t and scalars alone converts to vec_t instead
+    export template<typename E> requires is_lazy<E>
+    inline void eval(E const& $1, vec_soa<typename E::Scalar, E::length>& $2) {
+        static_assert(E::streamed, "expressions without a vec_soa operand convert to vec_t");
+        lazy_impl<E>::eval($1, $2, std::make_index_sequence<E::length>{});
+    }
+
+    export enum class store_mode {
+        cached,
+        streaming,
+    };
+
+    enum class transform_kind {
+        point,
+        vector,
+        projected,
+    };
+
+    template<typename T>
+    struct transform_scalar {
+        using Mat = mat_t<T, 4, 4>;
+
+        template<transform_kind Kind>
+        inline static void apply(Mat const& $1, std::span<vec_t<T, 3> const> $2, std::span<vec_t<T, 3>> $3) {
+            vec_t<T, 4> c0 = $1.__columns[0];
+            vec_t<T, 4> c1 = $1.__columns[1];
+            vec_t<T, 4> c2 = $1.__columns[2];
+            vec_t<T, 4> c3 = $1.__columns[3];
+
+            for (size_t i = 0; i < $2.size(); i += 1) {
+                vec_t<T, 3> p = $2[i];
+                if constexpr (Kind == transform_kind::vector) {
+                    $3[i] = (c0 * p.x + (c1 * p.y + c2 * p.z)).xyz;
+                } else if constexpr (Kind == transform_kind::point) {
+                    $3[i] = (c0 * p.x + (c1 * p.y + (c2 * p.z + c3))).xyz;
+                } else {
+                    vec_t<T, 4> h = c0 * p.x + (c1 * p.y + (c2 * p.z + c3));
+                    $3[i] = h.xyz / h.w;
+                }
+            }
+        }
+
+        inline static void points(Mat const& $1, std::span<vec_t<T, 3> const> $2, std::span<vec_t<T, 3>> $3, store_mode) {
+            apply<transform_kind::point>($1, $2, $3);
+        }
+        inline static void vectors(Mat const& $1, std::span<vec_t<T, 3> const> $2, std::span<vec_t<T, 3>> $3, store_mode) {
+            apply<transform_kind::vector>($1, $2, $3);
+        }
+        inline static void projected(Mat const& $1, std::span<vec_t<T, 3> const> $2, std::span<vec_t<T, 3>> $3, store_mode) {
+            apply<transform_kind::projected>($1, $2, $3);
+        }
+        inline static void homogeneous(Mat const& $1, std::span<vec_t<T, 4> const> $2, std::span<vec_t<T, 4>> $3, store_mode) {
+            for (size_t i = 0; i < $2.size(); i += 1) {
+                $3[i] = $1 * $2[i];
+            }
+        }
+    };
+
+    template<typename T>
+    struct transform_impl : transform_scalar<T> {};
+
+#if defined(__AVX__)
+    template<>
+    struct transform_impl<float> : transform_scalar<float> {
+        using Mat = mat_t<float, 4, 4>;
+
+        inline static auto madd(__m256 $1, __m256 $2, __m256 $3) -> __m256 {
+#if defined(__FMA__)
+            return _mm256_fmadd_ps($1, $2, $3);
+#else
+            return _mm256_add_ps(_mm256_mul_ps($1, $2), $3);
+#endif
+        }
+
+        // 24 floats of eight vec3 split into x/y/z registers
+        inline static void load3(float const* $1, __m256& x, __m256& y, __m256& z) {
+            __m256 m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps($1 + 0)), _mm_loadu_ps($1 + 12), 1);
+            __m256 m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps($1 + 4)), _mm_loadu_ps($1 + 16), 1);
+            __m256 m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps($1 + 8)), _mm_loadu_ps($1 + 20), 1);
+
+            __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+            __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+            x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+            y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+            z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+        }
+        // x/y/z registers interleaved back into 24 floats
+        inline static void store3(float* $1, __m256 rx, __m256 ry, __m256 rz, bool stream) {
+            __m256 rxy = _mm256_shuffle_ps(rx, ry, _MM_SHUFFLE(2, 0, 2, 0));
+            __m256 ryz = _mm256_shuffle_ps(ry, rz, _MM_SHUFFLE(3, 1, 3, 1));
+            __m256 rzx = _mm256_shuffle_ps(rz, rx, _MM_SHUFFLE(3, 1, 2, 0));
+            __m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+            __m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+            __m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+
+            if (stream) {
+                _mm_stream_ps($1 + 0, _mm256_castps256_ps128(r03));
+                _mm_stream_ps($1 + 4, _mm256_castps256_ps128(r14));
+                _mm_stream_ps($1 + 8, _mm256_castps256_ps128(r25));
+                _mm_stream_ps($1 + 12, _mm256_extractf128_ps(r03, 1));
+                _mm_stream_ps($1 + 16, _mm256_extractf128_ps(r14, 1));
+                _mm_stream_ps($1 + 20, _mm256_extractf128_ps(r25, 1));
+            } else {
+                _mm_storeu_ps($1 + 0, _mm256_castps256_ps128(r03));
+                _mm_storeu_ps($1 + 4, _mm256_castps256_ps128(r14));
+                _mm_storeu_ps($1 + 8, _mm256_castps256_ps128(r25));
+                _mm_storeu_ps($1 + 12, _mm256_extractf128_ps(r03, 1));
+                _mm_storeu_ps($1 + 16, _mm256_extractf128_ps(r14, 1));
+                _mm_storeu_ps($1 + 20, _mm256_extractf128_ps(r25, 1));
+            }
+        }
+
+        // eight vec3 per call: 24 floats are split into x/y/z registers, transformed, and interleaved back
+        template<transform_kind Kind>
+        inline static void kernel3(__m256 const (&m)[4][4], float const* $1, float* $2, bool stream) {
+            __m256 x, y, z;
+            load3($1, x, y, z);
+
+            __m256 rx, ry, rz;
+            if constexpr (Kind == transform_kind::vector) {
+                rx = madd(m[0][0], x, madd(m[1][0], y, _mm256_mul_ps(m[2][0], z)));
+                ry = madd(m[0][1], x, madd(m[1][1], y, _mm256_mul_ps(m[2][1], z)));
+                rz = madd(m[0][2], x, madd(m[1][2], y, _mm256_mul_ps(m[2][2], z)));
+            } else {
+                rx = madd(m[0][0], x, madd(m[1][0], y, madd(m[2][0], z, m[3][0])));
+                ry = madd(m[0][1], x, madd(m[1][1], y, madd(m[2][1], z, m[3][1])));
+                rz = madd(m[0][2], x, madd(m[1][2], y, madd(m[2][2], z, m[3][2])));
+            }
+            if constexpr (Kind == transform_kind::projected) {
+                __m256 rw = madd(m[0][3], x, madd(m[1][3], y, madd(m[2][3], z, m[3][3])));
+                rx = _mm256_div_ps(rx, rw);
+                ry = _mm256_div_ps(ry, rw);
+                rz = _mm256_div_ps(rz, rw);
+            }
+            store3($2, rx, ry, rz, stream);
+        }
+
+        // runs fewer than eight vec3 through the kernel via a padded local copy
+        template<transform_kind Kind>
+        inline static void partial(__m256 const (&m)[4][4], float const* $1, float* $2, size_t count) {
+            float src[24] = {};
+            float dst[24];
+            std::memcpy(src, $1, count * sizeof(float) * 3);
+            kernel3<Kind>(m, src, dst, false);
+            std::memcpy($2, dst, count * sizeof(float) * 3);
+        }
+
+        template<transform_kind Kind>
+        inline static void apply(Mat const& $1, std::span<vec_t<float, 3> const> $2, std::span<vec_t<float, 3>> $3, store_mode $4) {
+            __m256 m[4][4];
+            for (size_t c = 0; c < 4; c += 1) {
+                for (size_t r = 0; r < 4; r += 1) {
+                    m[c][r] = _mm256_set1_ps($1.__columns[c][r]);
+                }
+            }
+
+            float const* src = reinterpret_cast<float const*>($2.data());
+            float* dst = reinterpret_cast<float*>($3.data());
+            size_t count = $2.size();
+            size_t i = 0;
+
+            bool stream = $4 == store_mode::streaming;
+            if (stream) {
+                size_t head = 0;
+                while (head < count && reinterpret_cast<uintptr_t>(dst + head * 3) % 16 != 0) {
+                    head += 1;
+                }
+                if (head > 0) {
+                    partial<Kind>(m, src, dst, head);
+                }
+                i = head;
+            }
+            for (; i + 8 <= count; i += 8) {
+                kernel3<Kind>(m, src + i * 3, dst + i * 3, stream);
+            }
+            if (i < count) {
+                partial<Kind>(m, src + i * 3, dst + i * 3, count - i);
+            }
+            if (stream) {
+                _mm_sfence();
+            }
+        }
+
+        inline static auto kernel4(__m256 const (&c)[4], __m256 v) -> __m256 {
+            __m256 x = _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0));
+            __m256 y = _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1));
+            __m256 z = _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2));
+            __m256 w = _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3));
+            return madd(c[0], x, madd(c[1], y, madd(c[2], z, _mm256_mul_ps(c[3], w))));
+        }
+
+        inline static void points(Mat const& $1, std::span<vec_t<float, 3> const> $2, std::span<vec_t<float, 3>> $3, store_mode $4) {
+            apply<transform_kind::point>($1, $2, $3, $4);
+        }
+        inline static void vectors(Mat const& $1, std::span<vec_t<float, 3> const> $2, std::span<vec_t<float, 3>> $3, store_mode $4) {
+            apply<transform_kind::vector>($1, $2, $3, $4);
+        }
+        inline static void projected(Mat const& $1, std::span<vec_t<float, 3> const> $2, std::span<vec_t<float, 3>> $3, store_mode $4) {
+            apply<transform_kind::projected>($1, $2, $3, $4);
+        }
+        // two vec4 per register, each 128-bit half holding a copy of the matrix columns
+        inline static void homogeneous(Mat const& $1, std::span<vec_t<float, 4> const> $2, std::span<vec_t<float, 4>> $3, store_mode $4) {
+            __m256 c[4];
+            for (size_t i = 0; i < 4; i += 1) {
+                __m128 column = _mm_loadu_ps($1.__columns[i].__fields);
+                c[i] = _mm256_insertf128_ps(_mm256_castps128_ps256(column), column, 1);
+            }
+
+            float const* src = reinterpret_cast<float const*>($2.data());
+            float* dst = reinterpret_cast<float*>($3.data());
+            size_t count = $2.size();
+            size_t i = 0;
+
+            bool stream = $4 == store_mode::streaming && reinterpret_cast<uintptr_t>(dst) % 16 == 0;
+            if (stream && count > 0 && reinterpret_cast<uintptr_t>(dst) % 32 != 0) {
+                __m256 v = kernel4(c, _mm256_castps128_ps256(_mm_loadu_ps(src)));
+                _mm_storeu_ps(dst, _mm256_castps256_ps128(v));
+                i = 1;
+            }
+            for (; i + 2 <= count; i += 2) {
+                __m256 v = kernel4(c, _mm256_loadu_ps(src + i * 4));
+                if (stream) {
+                    _mm256_stream_ps(dst + i * 4, v);
+                } else {
+                    _mm256_storeu_ps(dst + i * 4, v);
+                }
+            }
+            if (i < count) {
+                __m256 v = kernel4(c, _mm256_castps128_ps256(_mm_loadu_ps(src + i * 4)));
+                _mm_storeu_ps(dst + i * 4, _mm256_castps256_ps128(v));
+            }
+            if (stream) {
+                _mm_sfence();
+            }
+        }
+    };
+#endif
+
+    template<typename T>
+    struct normalize_scalar {
+        // the squared length is clamped to the smallest normal, so a zero vector scales to zero instead of NaN
+        template<size_t Len>
+        inline static void apply(std::span<vec_t<T, Len> const> $1, std::span<vec_t<T, Len>> $2) {
+            T const tiny = std::numeric_limits<T>::min();
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                T d = dot($1[i], $1[i]);
+                $2[i] = $1[i] * (T(1) / std::sqrt(d > tiny ? d : tiny));
+            }
+        }
+    };
+
+    template<typename T>
+    struct normalize_impl : normalize_scalar<T> {};
+
+#if defined(__AVX__)
+    template<>
+    struct normalize_impl<float> : normalize_scalar<float> {
+        // rsqrt estimate refined by one Newton-Raphson step; the clamp keeps zero input at zero
+        inline static auto rsqrt(__m256 $1) -> __m256 {
+            __m256 d = _mm256_max_ps($1, _mm256_set1_ps(std::numeric_limits<float>::min()));
+            __m256 r = _mm256_rsqrt_ps(d);
+            __m256 h = _mm256_mul_ps(_mm256_set1_ps(0.5f), d);
+            return _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(h, _mm256_mul_ps(r, r))));
+        }
+
+        inline static void kernel3(float const* $1, float* $2) {
+            __m256 x, y, z;
+            transform_impl<float>::load3($1, x, y, z);
+            __m256 d = transform_impl<float>::madd(x, x, transform_impl<float>::madd(y, y, _mm256_mul_ps(z, z)));
+            __m256 r = rsqrt(d);
+            transform_impl<float>::store3($2, _mm256_mul_ps(x, r), _mm256_mul_ps(y, r), _mm256_mul_ps(z, r), false);
+        }
+        // two vec4 per register, the squared length summed within each 128-bit half
+        inline static auto kernel4(__m256 $1) -> __m256 {
+            __m256 d = _mm256_mul_ps($1, $1);
+            d = _mm256_add_ps(d, _mm256_permute_ps(d, _MM_SHUFFLE(2, 3, 0, 1)));
+            d = _mm256_add_ps(d, _mm256_permute_ps(d, _MM_SHUFFLE(1, 0, 3, 2)));
+            return _mm256_mul_ps($1, rsqrt(d));
+        }
+
+        inline static void apply(std::span<vec_t<float, 3> const> $1, std::span<vec_t<float, 3>> $2) {
+            float const* src = reinterpret_cast<float const*>($1.data());
+            float* dst = reinterpret_cast<float*>($2.data());
+            size_t count = $1.size();
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                kernel3(src + i * 3, dst + i * 3);
+            }
+            if (i < count) {
+                float a[24] = {};
+                float b[24];
+                std::memcpy(a, src + i * 3, (count - i) * sizeof(float) * 3);
+                kernel3(a, b);
+                std::memcpy(dst + i * 3, b, (count - i) * sizeof(float) * 3);
+            }
+        }
+        inline static void apply(std::span<vec_t<float, 4> const> $1, std::span<vec_t<float, 4>> $2) {
+            float const* src = reinterpret_cast<float const*>($1.data());
+            float* dst = reinterpret_cast<float*>($2.data());
+            size_t count = $1.size();
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                _mm256_storeu_ps(dst + i * 4, kernel4(_mm256_loadu_ps(src + i * 4)));
+            }
+            if (i < count) {
+                __m256 v = kernel4(_mm256_castps128_ps256(_mm_loadu_ps(src + i * 4)));
+                _mm_storeu_ps(dst + i * 4, _mm256_castps256_ps128(v));
+            }
+        }
+    };
+#endif
+
+    // zero-length input yields zero; the f32 path uses rsqrt plus one Newton-Raphson step
+    export inline void normalize_all(std::span<vec_t<float, 3> const> $1, std::span<vec_t<float, 3>> $2) {
+        normalize_impl<float>::apply($1, $2);
+    }
+    export inline void normalize_all(std::span<vec_t<float, 4> const> $1, std::span<vec_t<float, 4>> $2) {
+        normalize_impl<float>::apply($1, $2);
+    }
+    export inline void normalize_all(std::span<vec_t<double, 3> const> $1, std::span<vec_t<double, 3>> $2) {
+        normalize_impl<double>::apply($1, $2);
+    }
+    export inline void normalize_all(std::span<vec_t<double, 4> const> $1, std::span<vec_t<double, 4>> $2) {
+        normalize_impl<double>::apply($1, $2);
+    }
+
+    export template<typename T>
+    inline void transform_points(mat_t<T, 4, 4> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<vec_t<std::type_identity_t<T>, 3>> $3, store_mode $4 = store_mode::cached) {
+        transform_impl<T>::points($1, $2, $3, $4);
+    }
+    export template<typename T>
+    inline void transform_vectors(mat_t<T, 4, 4> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<vec_t<std::type_identity_t<T>, 3>> $3, store_mode $4 = store_mode::cached) {
+        transform_impl<T>::vectors($1, $2, $3, $4);
+    }
+    export template<typename T>
+    inline void transform_projected(mat_t<T, 4, 4> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<vec_t<std::type_identity_t<T>, 3>> $3, store_mode $4 = store_mode::cached) {
+        transform_impl<T>::projected($1, $2, $3, $4);
+    }
+    export template<typename T>
+    inline void transform_homogeneous(mat_t<T, 4, 4> const& $1, std::span<vec_t<std::type_identity_t<T>, 4> const> $2, std::span<vec_t<std::type_identity_t<T>, 4>> $3, store_mode $4 = store_mode::cached) {
+        transform_impl<T>::homogeneous($1, $2, $3, $4);
+    }
+
+    template<typename T>
+    struct quat_impl;
+
+    // rotation quaternion; x, y and z hold the vector part, w the scalar part
+    export template<typename T>
+    struct quat_t final {
+        using Self = quat_t;
+
+        vec_t<T, 4> __xyzw;
+
+        friend constexpr auto operator==(Self const& $1, Self const& $2) -> bool = default;
+
+        friend constexpr auto operator*(Self const& $1, Self const& $2) -> Self {
+            return quat_impl<T>::mul($1, $2);
+        }
+        friend constexpr auto operator*(Self const& $1, vec_t<T, 3> const& $2) -> vec_t<T, 3> {
+            return quat_impl<T>::rotate($1, $2);
+        }
+    };
+
+    template<typename T>
+    struct quat_scalar {
+        using Quat = quat_t<T>;
+        using Vec3 = vec_t<T, 3>;
+        using Vec4 = vec_t<T, 4>;
+
+        // sin(t * θ) / sin(θ) for cos(θ) in [0, 1] as a series in cos(θ) - 1 (Eberly); the last term is
+        // scaled to absorb the truncated tail, keeping the weights within 1e-6 without any trig
+        static constexpr size_t slerp_terms = 12;
+
+        struct slerp_series {
+            T u[slerp_terms];
+            T v[slerp_terms];
+        };
+
+        inline static constexpr slerp_series slerp_coefficients = [] {
+            slerp_series out{};
+            for (size_t i = 1; i <= slerp_terms; i += 1) {
+                double scale = i == slerp_terms ? 1.8937247563710522 : 1.0;
+                out.u[i - 1] = T(scale / double(i * (2 * i + 1)));
+                out.v[i - 1] = T(scale * double(i) / double(2 * i + 1));
+            }
+            return out;
+        }();
+
+        inline static constexpr auto slerp_weight(T t, T xm1) -> T {
+            T s = t * t;
+            T acc = T(1);
+            for (size_t i = slerp_terms; i > 0; i -= 1) {
+                acc = T(1) + (slerp_coefficients.u[i - 1] * s - slerp_coefficients.v[i - 1]) * xm1 * acc;
+            }
+            return t * acc;
+        }
+
+        // weights of the two endpoints for a non-negative cosine; float uses the series, wider types use trig
+        inline static constexpr auto slerp_weights(T t, T d) -> vec_t<T, 2> {
+            if constexpr (std::is_same_v<T, float>) {
+                return vec_t<T, 2>{slerp_weight(T(1) - t, d - T(1)), slerp_weight(t, d - T(1))};
+            } else {
+                T theta = std::acos(d < T(1) ? d : T(1));
+                T s = std::sin(theta);
+                if (s < std::numeric_limits<T>::epsilon()) {
+                    return vec_t<T, 2>{T(1) - t, t};
+                }
+                return vec_t<T, 2>{std::sin((T(1) - t) * theta) / s, std::sin(t * theta) / s};
+            }
+        }
+
+        inline static constexpr auto mul(Quat const& $1, Quat const& $2) -> Quat {
+            Vec4 const& p = $1.__xyzw;
+            Vec4 const& q = $2.__xyzw;
+            return Quat{Vec4{
+                p[3] * q[0] + p[0] * q[3] + p[1] * q[2] - p[2] * q[1],
+                p[3] * q[1] - p[0] * q[2] + p[1] * q[3] + p[2] * q[0],
+                p[3] * q[2] + p[0] * q[1] - p[1] * q[0] + p[2] * q[3],
+                p[3] * q[3] - p[0] * q[0] - p[1] * q[1] - p[2] * q[2],
+            }};
+        }
+        inline static constexpr auto conjugate(Quat const& $1) -> Quat {
+            return Quat{Vec4{-$1.__xyzw[0], -$1.__xyzw[1], -$1.__xyzw[2], $1.__xyzw[3]}};
+        }
+        inline static constexpr auto inverse(Quat const& $1) -> Quat {
+            return Quat{conjugate($1).__xyzw / dot($1.__xyzw, $1.__xyzw)};
+        }
+        inline static constexpr auto normalize(Quat const& $1) -> Quat {
+            return Quat{math::normalize($1.__xyzw)};
+        }
+        // v + 2w (u x v) + 2u x (u x v), which is 15 multiplies instead of the 28 of q * v * q^-1
+        inline static constexpr auto rotate(Quat const& $1, Vec3 const& $2) -> Vec3 {
+            Vec3 u = $1.__xyzw.xyz;
+            Vec3 t = cross(u, $2) * T(2);
+            return $2 + t * $1.__xyzw[3] + cross(u, t);
+        }
+        // the shorter arc: $2 is negated when the endpoints lie in opposite hemispheres
+        inline static constexpr auto nlerp(Quat const& $1, Quat const& $2, T $3) -> Quat {
+            T d = dot($1.__xyzw, $2.__xyzw);
+            Vec4 q = $2.__xyzw * (d < T(0) ? T(-1) : T(1));
+            return Quat{math::normalize($1.__xyzw * (T(1) - $3) + q * $3)};
+        }
+        inline static constexpr auto slerp(Quat const& $1, Quat const& $2, T $3) -> Quat {
+            T d = dot($1.__xyzw, $2.__xyzw);
+            T sign = d < T(0) ? T(-1) : T(1);
+            vec_t<T, 2> w = slerp_weights($3, d * sign);
+            return Quat{$1.__xyzw * w[0] + $2.__xyzw * (w[1] * sign)};
+        }
+
+        inline static constexpr auto angle_axis(T $1, Vec3 const& $2) -> Quat {
+            T s = std::sin($1 * T(0.5));
+            T c = std::cos($1 * T(0.5));
+            return Quat{Vec4{$2[0] * s, $2[1] * s, $2[2] * s, c}};
+        }
+        inline static constexpr auto to_mat3(Quat const& $1) -> mat_t<T, 3, 3> {
+            T x = $1.__xyzw[0];
+            T y = $1.__xyzw[1];
+            T z = $1.__xyzw[2];
+            T w = $1.__xyzw[3];
+            T xx = x * x;
+            T yy = y * y;
+            T zz = z * z;
+            T xy = x * y;
+            T xz = x * z;
+            T yz = y * z;
+            T wx = w * x;
+            T wy = w * y;
+            T wz = w * z;
+            return mat_t<T, 3, 3>{
+                Vec3{T(1) - T(2) * (yy + zz), T(2) * (xy + wz), T(2) * (xz - wy)},
+                Vec3{T(2) * (xy - wz), T(1) - T(2) * (xx + zz), T(2) * (yz + wx)},
+                Vec3{T(2) * (xz + wy), T(2) * (yz - wx), T(1) - T(2) * (xx + yy)},
+            };
+        }
+        // Shepperd's method: the largest of w, x, y, z is recovered from the diagonal, the rest from
+        // off-diagonal sums and differences, so no branch divides by a small number
+        template<size_t Size>
+        inline static constexpr auto from_mat(mat_t<T, Size, Size> const& $1) -> Quat {
+            auto m = [&](size_t row, size_t col) -> T { return $1.__columns[col][row]; };
+            T trace = m(0, 0) + m(1, 1) + m(2, 2);
+            if (trace > T(0)) {
+                T s = std::sqrt(trace + T(1)) * T(2);
+                return Quat{Vec4{(m(2, 1) - m(1, 2)) / s, (m(0, 2) - m(2, 0)) / s, (m(1, 0) - m(0, 1)) / s, s * T(0.25)}};
+            }
+            if (m(0, 0) > m(1, 1) && m(0, 0) > m(2, 2)) {
+                T s = std::sqrt(T(1) + m(0, 0) - m(1, 1) - m(2, 2)) * T(2);
+                return Quat{Vec4{s * T(0.25), (m(0, 1) + m(1, 0)) / s, (m(0, 2) + m(2, 0)) / s, (m(2, 1) - m(1, 2)) / s}};
+            }
+            if (m(1, 1) > m(2, 2)) {
+                T s = std::sqrt(T(1) + m(1, 1) - m(0, 0) - m(2, 2)) * T(2);
+                return Quat{Vec4{(m(0, 1) + m(1, 0)) / s, s * T(0.25), (m(1, 2) + m(2, 1)) / s, (m(0, 2) - m(2, 0)) / s}};
+            }
+            T s = std::sqrt(T(1) + m(2, 2) - m(0, 0) - m(1, 1)) * T(2);
+            return Quat{Vec4{(m(0, 2) + m(2, 0)) / s, (m(1, 2) + m(2, 1)) / s, s * T(0.25), (m(1, 0) - m(0, 1)) / s}};
+        }
+
+        inline static void rotate(std::span<Quat const> $1, std::span<Vec3 const> $2, std::span<Vec3> $3) {
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                $3[i] = rotate($1[i], $2[i]);
+            }
+        }
+        inline static void slerp(std::span<Quat const> $1, std::span<Quat const> $2, T $3, std::span<Quat> $4) {
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                $4[i] = slerp($1[i], $2[i], $3);
+            }
+        }
+    };
+
+    template<typename T>
+    struct quat_impl : quat_scalar<T> {};
+
+#if defined(__SSE2__)
+    template<>
+    struct quat_impl<float> : quat_scalar<float> {
+        using Base = quat_scalar<float>;
+        using Vec = vec_impl<float, 4>;
+
+        using Base::rotate;
+        using Base::slerp;
+
+        inline static auto madd(__m128 $1, __m128 $2, __m128 $3) -> __m128 {
+#if defined(__FMA__)
+            return _mm_fmadd_ps($1, $2, $3);
+#else
+            return _mm_add_ps(_mm_mul_ps($1, $2), $3);
+#endif
+        }
+
+        // w1 * q2 plus x1, y1 and z1 times sign-flipped shuffles of q2, in the scalar summation order
+        inline static constexpr auto mul(Quat const& $1, Quat const& $2) -> Quat {
+            if consteval {
+                return Base::mul($1, $2);
+            } else {
+                __m128 p = Vec::load($1.__xyzw);
+                __m128 q = Vec::load($2.__xyzw);
+                __m128 x = _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0));
+                __m128 y = _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1));
+                __m128 z = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2));
+                __m128 w = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3));
+                __m128 qx = _mm_xor_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(0, 1, 2, 3)), _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f));
+                __m128 qy = _mm_xor_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(1, 0, 3, 2)), _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f));
+                __m128 qz = _mm_xor_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(2, 3, 0, 1)), _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f));
+                __m128 r = madd(x, qx, _mm_mul_ps(w, q));
+                r = madd(y, qy, r);
+                r = madd(z, qz, r);
+                return Quat{Vec::store(r)};
+            }
+        }
+
+#if defined(__AVX__)
+        using Transform = transform_impl<float>;
+
+        // 32 floats of eight quaternions split into x/y/z/w registers
+        inline static void load4(float const* $1, __m256& x, __m256& y, __m256& z, __m256& w) {
+            __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps($1 + 0)), _mm_loadu_ps($1 + 16), 1);
+            __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps($1 + 4)), _mm_loadu_ps($1 + 20), 1);
+            __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps($1 + 8)), _mm_loadu_ps($1 + 24), 1);
+            __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps($1 + 12)), _mm_loadu_ps($1 + 28), 1);
+
+            __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+            __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+            __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+            __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+            x = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            y = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            z = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            w = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        }
+        // x/y/z/w registers interleaved back into 32 floats
+        inline static void store4(float* $1, __m256 x, __m256 y, __m256 z, __m256 w) {
+            __m256 t0 = _mm256_unpacklo_ps(x, y);
+            __m256 t1 = _mm256_unpackhi_ps(x, y);
+            __m256 t2 = _mm256_unpacklo_ps(z, w);
+            __m256 t3 = _mm256_unpackhi_ps(z, w);
+            __m256 r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+            _mm_storeu_ps($1 + 0, _mm256_castps256_ps128(r0));
+            _mm_storeu_ps($1 + 4, _mm256_castps256_ps128(r1));
+            _mm_storeu_ps($1 + 8, _mm256_castps256_ps128(r2));
+            _mm_storeu_ps($1 + 12, _mm256_castps256_ps128(r3));
+            _mm_storeu_ps($1 + 16, _mm256_extractf128_ps(r0, 1));
+            _mm_storeu_ps($1 + 20, _mm256_extractf128_ps(r1, 1));
+            _mm_storeu_ps($1 + 24, _mm256_extractf128_ps(r2, 1));
+            _mm_storeu_ps($1 + 28, _mm256_extractf128_ps(r3, 1));
+        }
+
+        inline static void rotate8(float const* $1, float const* $2, float* $3) {
+            __m256 qx, qy, qz, qw;
+            __m256 vx, vy, vz;
+            load4($1, qx, qy, qz, qw);
+            Transform::load3($2, vx, vy, vz);
+
+            __m256 tx = _mm256_sub_ps(_mm256_mul_ps(qy, vz), _mm256_mul_ps(qz, vy));
+            __m256 ty = _mm256_sub_ps(_mm256_mul_ps(qz, vx), _mm256_mul_ps(qx, vz));
+            __m256 tz = _mm256_sub_ps(_mm256_mul_ps(qx, vy), _mm256_mul_ps(qy, vx));
+            tx = _mm256_add_ps(tx, tx);
+            ty = _mm256_add_ps(ty, ty);
+            tz = _mm256_add_ps(tz, tz);
+
+            __m256 rx = _mm256_add_ps(Transform::madd(tx, qw, vx), _mm256_sub_ps(_mm256_mul_ps(qy, tz), _mm256_mul_ps(qz, ty)));
+            __m256 ry = _mm256_add_ps(Transform::madd(ty, qw, vy), _mm256_sub_ps(_mm256_mul_ps(qz, tx), _mm256_mul_ps(qx, tz)));
+            __m256 rz = _mm256_add_ps(Transform::madd(tz, qw, vz), _mm256_sub_ps(_mm256_mul_ps(qx, ty), _mm256_mul_ps(qy, tx)));
+            Transform::store3($3, rx, ry, rz, false);
+        }
+
+        inline static auto slerp_weight(__m256 t, __m256 xm1) -> __m256 {
+            __m256 one = _mm256_set1_ps(1.0f);
+            __m256 s = _mm256_mul_ps(t, t);
+            __m256 acc = one;
+            for (size_t i = slerp_terms; i > 0; i -= 1) {
+                __m256 u = _mm256_set1_ps(slerp_coefficients.u[i - 1]);
+                __m256 v = _mm256_set1_ps(slerp_coefficients.v[i - 1]);
+                __m256 b = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(u, s), v), xm1);
+                acc = Transform::madd(b, acc, one);
+            }
+            return _mm256_mul_ps(t, acc);
+        }
+
+        inline static void slerp8(float const* $1, float const* $2, __m256 t, float* $3) {
+            __m256 ax, ay, az, aw;
+            __m256 bx, by, bz, bw;
+            load4($1, ax, ay, az, aw);
+            load4($2, bx, by, bz, bw);
+
+            __m256 d = Transform::madd(ax, bx, Transform::madd(ay, by, Transform::madd(az, bz, _mm256_mul_ps(aw, bw))));
+            __m256 sign = _mm256_and_ps(d, _mm256_set1_ps(-0.0f));
+            __m256 xm1 = _mm256_sub_ps(_mm256_xor_ps(d, sign), _mm256_set1_ps(1.0f));
+
+            __m256 wa = slerp_weight(_mm256_sub_ps(_mm256_set1_ps(1.0f), t), xm1);
+            __m256 wb = _mm256_xor_ps(slerp_weight(t, xm1), sign);
+            store4(
+                $3,
+                Transform::madd(bx, wb, _mm256_mul_ps(ax, wa)),
+                Transform::madd(by, wb, _mm256_mul_ps(ay, wa)),
+                Transform::madd(bz, wb, _mm256_mul_ps(az, wa)),
+                Transform::madd(bw, wb, _mm256_mul_ps(aw, wa))
+            );
+        }
+
+        inline static void rotate(std::span<Quat const> $1, std::span<Vec3 const> $2, std::span<Vec3> $3) {
+            float const* q = reinterpret_cast<float const*>($1.data());
+            float const* v = reinterpret_cast<float const*>($2.data());
+            float* dst = reinterpret_cast<float*>($3.data());
+            size_t count = $1.size();
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                rotate8(q + i * 4, v + i * 3, dst + i * 3);
+            }
+            if (i < count) {
+                float a[32] = {};
+                float b[24] = {};
+                float c[24];
+                std::memcpy(a, q + i * 4, (count - i) * sizeof(float) * 4);
+                std::memcpy(b, v + i * 3, (count - i) * sizeof(float) * 3);
+                rotate8(a, b, c);
+                std::memcpy(dst + i * 3, c, (count - i) * sizeof(float) * 3);
+            }
+        }
+        inline static void slerp(std::span<Quat const> $1, std::span<Quat const> $2, float $3, std::span<Quat> $4) {
+            float const* a = reinterpret_cast<float const*>($1.data());
+            float const* b = reinterpret_cast<float const*>($2.data());
+            float* dst = reinterpret_cast<float*>($4.data());
+            __m256 t = _mm256_set1_ps($3);
+            size_t count = $1.size();
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                slerp8(a + i * 4, b + i * 4, t, dst + i * 4);
+            }
+            if (i < count) {
+                float x[32] = {};
+                float y[32] = {};
+                float z[32];
+                std::memcpy(x, a + i * 4, (count - i) * sizeof(float) * 4);
+                std::memcpy(y, b + i * 4, (count - i) * sizeof(float) * 4);
+                slerp8(x, y, t, z);
+                std::memcpy(dst + i * 4, z, (count - i) * sizeof(float) * 4);
+            }
+        }
+#endif
+    };
+#endif
+
+    export template<typename T>
+    inline constexpr auto dot(quat_t<T> const& $1, quat_t<T> const& $2) -> T {
+        return dot($1.__xyzw, $2.__xyzw);
+    }
+    export template<typename T>
+    inline constexpr auto conjugate(quat_t<T> const& $1) -> quat_t<T> {
+        return quat_impl<T>::conjugate($1);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto inverse(quat_t<T> const& $1) -> quat_t<T> {
+        return quat_impl<T>::inverse($1);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto normalize(quat_t<T> const& $1) -> quat_t<T> {
+        return quat_impl<T>::normalize($1);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto rotate(quat_t<T> const& $1, vec_t<T, 3> const& $2) -> vec_t<T, 3> {
+        return quat_impl<T>::rotate($1, $2);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto nlerp(quat_t<T> const& $1, quat_t<T> const& $2, std::type_identity_t<T> $3) -> quat_t<T> {
+        return quat_impl<T>::nlerp($1, $2, $3);
+    }
+    // takes the shorter arc; f32 weights come from a trig-free series accurate to 1e-6
+    export template<std::floating_point T>
+    inline constexpr auto slerp(quat_t<T> const& $1, quat_t<T> const& $2, std::type_identity_t<T> $3) -> quat_t<T> {
+        return quat_impl<T>::slerp($1, $2, $3);
+    }
+    // $1 radians about the unit axis $2
+    export template<std::floating_point T>
+    inline constexpr auto angleAxis(T $1, vec_t<T, 3> const& $2) -> quat_t<T> {
+        return quat_impl<T>::angle_axis($1, $2);
+    }
+    // the rotation part of a rotation-only or rigid matrix; scale must be divided out first
+    export template<std::floating_point T>
+    inline constexpr auto quat(mat_t<T, 3, 3> const& $1) -> quat_t<T> {
+        return quat_impl<T>::from_mat($1);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto quat(mat_t<T, 4, 4> const& $1) -> quat_t<T> {
+        return quat_impl<T>::from_mat($1);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto mat3x3(quat_t<T> const& $1) -> mat_t<T, 3, 3> {
+        return quat_impl<T>::to_mat3($1);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto mat4x4(quat_t<T> const& $1) -> mat_t<T, 4, 4> {
+        mat_t<T, 3, 3> m = quat_impl<T>::to_mat3($1);
+        return mat_t<T, 4, 4>{
+            vec_t<T, 4>{m.__columns[0][0], m.__columns[0][1], m.__columns[0][2], T(0)},
+            vec_t<T, 4>{m.__columns[1][0], m.__columns[1][1], m.__columns[1][2], T(0)},
+            vec_t<T, 4>{m.__columns[2][0], m.__columns[2][1], m.__columns[2][2], T(0)},
+            vec_t<T, 4>{T(0), T(0), T(0), T(1)},
+        };
+    }
+    // $3[i] = $1[i] * $2[i], e.g. bone-local offsets by per-bone rotations
+    export inline void rotate(std::span<quat_t<float> const> $1, std::span<vec_t<float, 3> const> $2, std::span<vec_t<float, 3>> $3) {
+        require_size($2.size(), $1.size(), "math::rotate: fewer vectors than rotations");
+        require_size($3.size(), $1.size(), "math::rotate: output is shorter than the input");
+        quat_impl<float>::rotate($1, $2, $3);
+    }
+    export inline void rotate(std::span<quat_t<double> const> $1, std::span<vec_t<double, 3> const> $2, std::span<vec_t<double, 3>> $3) {
+        require_size($2.size(), $1.size(), "math::rotate: fewer vectors than rotations");
+        require_size($3.size(), $1.size(), "math::rotate: output is shorter than the input");
+        quat_impl<double>::rotate($1, $2, $3);
+    }
+    // blends two poses bone by bone with a shared parameter
+    export inline void slerp(std::span<quat_t<float> const> $1, std::span<quat_t<float> const> $2, float $3, std::span<quat_t<float>> $4) {
+        require_size($2.size(), $1.size(), "math::slerp: second pose is shorter than the first");
+        require_size($4.size(), $1.size(), "math::slerp: output is shorter than the input");
+        quat_impl<float>::slerp($1, $2, $3, $4);
+    }
+    export inline void slerp(std::span<quat_t<double> const> $1, std::span<quat_t<double> const> $2, double $3, std::span<quat_t<double>> $4) {
+        require_size($2.size(), $1.size(), "math::slerp: second pose is shorter than the first");
+        require_size($4.size(), $1.size(), "math::slerp: output is shorter than the input");
+        quat_impl<double>::slerp($1, $2, $3, $4);
+    }
+
+    template<typename T>
+    struct affine_impl;
+
+    // the top three rows of an affine 4x4 matrix, the implied last row being (0, 0, 0, 1); rows keep
+    // each register full where three columns of vec_t<T, 4> would carry a padding lane
+    export template<typename T>
+    struct affine_t final {
+        using Self = affine_t;
+
+        vec_t<T, 4> __rows[3];
+
+        friend constexpr auto operator==(Self const& $1, Self const& $2) -> bool = default;
+
+        friend constexpr auto operator*(Self const& $1, Self const& $2) -> Self {
+            return affine_impl<T>::mul($1, $2);
+        }
+    };
+
+    template<typename T>
+    struct affine_scalar {
+        using Affine = affine_t<T>;
+        using Vec3 = vec_t<T, 3>;
+        using Vec4 = vec_t<T, 4>;
+
+        // row $1 of the left operand against the rows of $2, the implied (0, 0, 0, 1) row adding only the translation
+        inline static constexpr auto row(Vec4 const& $1, Affine const& $2) -> Vec4 {
+            Vec4 const& b0 = $2.__rows[0];
+            Vec4 const& b1 = $2.__rows[1];
+            Vec4 const& b2 = $2.__rows[2];
+            return Vec4{
+                b0[0] * $1[0] + (b1[0] * $1[1] + b2[0] * $1[2]),
+                b0[1] * $1[0] + (b1[1] * $1[1] + b2[1] * $1[2]),
+                b0[2] * $1[0] + (b1[2] * $1[1] + b2[2] * $1[2]),
+                b0[3] * $1[0] + (b1[3] * $1[1] + (b2[3] * $1[2] + $1[3])),
+            };
+        }
+        inline static constexpr auto mul(Affine const& $1, Affine const& $2) -> Affine {
+            return Affine{row($1.__rows[0], $2), row($1.__rows[1], $2), row($1.__rows[2], $2)};
+        }
+        inline static constexpr auto point(Vec4 const& $1, Vec3 const& $2) -> T {
+            return $1[0] * $2[0] + ($1[1] * $2[1] + ($1[2] * $2[2] + $1[3]));
+        }
+        inline static constexpr auto vector(Vec4 const& $1, Vec3 const& $2) -> T {
+            return $1[0] * $2[0] + ($1[1] * $2[1] + $1[2] * $2[2]);
+        }
+        inline static constexpr auto point(Affine const& $1, Vec3 const& $2) -> Vec3 {
+            return Vec3{point($1.__rows[0], $2), point($1.__rows[1], $2), point($1.__rows[2], $2)};
+        }
+        inline static constexpr auto vector(Affine const& $1, Vec3 const& $2) -> Vec3 {
+            return Vec3{vector($1.__rows[0], $2), vector($1.__rows[1], $2), vector($1.__rows[2], $2)};
+        }
+        // the columns of the inverse linear part are the cross products of its rows over the determinant,
+        // scaled by one reciprocal instead of nine divisions
+        inline static constexpr auto inverse(Affine const& $1) -> Affine {
+            Vec3 a = $1.__rows[0].xyz;
+            Vec3 b = $1.__rows[1].xyz;
+            Vec3 c = $1.__rows[2].xyz;
+            Vec3 t = Vec3{$1.__rows[0][3], $1.__rows[1][3], $1.__rows[2][3]};
+
+            Vec3 r0 = cross(b, c);
+            T inv = T(1) / dot(a, r0);
+            Vec3 c0 = r0 * inv;
+            Vec3 c1 = cross(c, a) * inv;
+            Vec3 c2 = cross(a, b) * inv;
+            Vec3 c3 = T(0) - (c0 * t.x + (c1 * t.y + c2 * t.z));
+            return Affine{
+                Vec4{c0.x, c1.x, c2.x, c3.x},
+                Vec4{c0.y, c1.y, c2.y, c3.y},
+                Vec4{c0.z, c1.z, c2.z, c3.z},
+            };
+        }
+        // orthonormal linear part: the inverse rotation is the transpose
+        inline static constexpr auto inverse_rigid(Affine const& $1) -> Affine {
+            Vec3 a = $1.__rows[0].xyz;
+            Vec3 b = $1.__rows[1].xyz;
+            Vec3 c = $1.__rows[2].xyz;
+            Vec3 t = Vec3{$1.__rows[0][3], $1.__rows[1][3], $1.__rows[2][3]};
+
+            Vec3 c3 = T(0) - (a * t.x + (b * t.y + c * t.z));
+            return Affine{
+                Vec4{a.x, b.x, c.x, c3.x},
+                Vec4{a.y, b.y, c.y, c3.y},
+                Vec4{a.z, b.z, c.z, c3.z},
+            };
+        }
+        inline static constexpr auto from_mat(mat_t<T, 4, 4> const& $1) -> Affine {
+            return Affine{$1.row(0), $1.row(1), $1.row(2)};
+        }
+        inline static constexpr auto to_mat(Affine const& $1) -> mat_t<T, 4, 4> {
+            Vec4 const& r0 = $1.__rows[0];
+            Vec4 const& r1 = $1.__rows[1];
+            Vec4 const& r2 = $1.__rows[2];
+            return mat_t<T, 4, 4>{
+                Vec4{r0[0], r1[0], r2[0], T(0)},
+                Vec4{r0[1], r1[1], r2[1], T(0)},
+                Vec4{r0[2], r1[2], r2[2], T(0)},
+                Vec4{r0[3], r1[3], r2[3], T(1)},
+            };
+        }
+    };
+
+    template<typename T>
+    struct affine_impl : affine_scalar<T> {};
+
+#if defined(__SSE2__)
+    template<>
+    struct affine_impl<float> : affine_scalar<float> {
+        using Base = affine_scalar<float>;
+        using Mat = mat_impl<float, 4, 4>;
+
+        using Base::row;
+        using Base::point;
+        using Base::vector;
+
+        inline static void load(Affine const& $1, __m128 (&$2)[3]) {
+            for (size_t i = 0; i < 3; i += 1) {
+                $2[i] = _mm_loadu_ps($1.__rows[i].__fields);
+            }
+        }
+        inline static auto store(__m128 $1, __m128 $2, __m128 $3) -> Affine {
+            Affine out;
+            _mm_storeu_ps(out.__rows[0].__fields, $1);
+            _mm_storeu_ps(out.__rows[1].__fields, $2);
+            _mm_storeu_ps(out.__rows[2].__fields, $3);
+            return out;
+        }
+
+        // three madds per row; the translation rides along in lane 3 of the accumulator
+        inline static auto row(__m128 $1, __m128 const (&$2)[3]) -> __m128 {
+            __m128 sum = _mm_and_ps($1, _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1)));
+            sum = Mat::madd($2[2], _mm_shuffle_ps($1, $1, _MM_SHUFFLE(2, 2, 2, 2)), sum);
+            sum = Mat::madd($2[1], _mm_shuffle_ps($1, $1, _MM_SHUFFLE(1, 1, 1, 1)), sum);
+            return Mat::madd($2[0], _mm_shuffle_ps($1, $1, _MM_SHUFFLE(0, 0, 0, 0)), sum);
+        }
+
+        inline static constexpr auto mul(Affine const& $1, Affine const& $2) -> Affine {
+            if consteval {
+                return Base::mul($1, $2);
+            } else {
+                __m128 a[3], b[3];
+                load($1, a);
+                load($2, b);
+                return store(row(a[0], b), row(a[1], b), row(a[2], b));
+            }
+        }
+        // the cross products and the negated translation are built as columns, one transpose turns them into rows
+        inline static constexpr auto inverse(Affine const& $1) -> Affine {
+            if consteval {
+                return Base::inverse($1);
+            } else {
+                __m128 r[3];
+                load($1, r);
+                __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+                __m128 a = _mm_and_ps(r[0], xyz);
+                __m128 b = _mm_and_ps(r[1], xyz);
+                __m128 c = _mm_and_ps(r[2], xyz);
+                __m128 t = _mm_shuffle_ps(_mm_unpackhi_ps(r[0], r[1]), _mm_unpackhi_ps(r[2], _mm_setzero_ps()), _MM_SHUFFLE(3, 2, 3, 2));
+
+                __m128 c0 = Mat::cross(b, c);
+                __m128 det = _mm_mul_ps(a, c0);
+                det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+                det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+                __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), det);
+                c0 = _mm_mul_ps(c0, inv);
+                __m128 c1 = _mm_mul_ps(Mat::cross(c, a), inv);
+                __m128 c2 = _mm_mul_ps(Mat::cross(a, b), inv);
+                __m128 c3 = _mm_add_ps(
+                    _mm_mul_ps(c0, _mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0))),
+                    _mm_add_ps(
+                        _mm_mul_ps(c1, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1))),
+                        _mm_mul_ps(c2, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2)))
+                    )
+                );
+                c3 = _mm_sub_ps(_mm_setzero_ps(), c3);
+                _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+                return store(c0, c1, c2);
+            }
+        }
+        inline static constexpr auto inverse_rigid(Affine const& $1) -> Affine {
+            if consteval {
+                return Base::inverse_rigid($1);
+            } else {
+                __m128 r[3];
+                load($1, r);
+                __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+                __m128 a = _mm_and_ps(r[0], xyz);
+                __m128 b = _mm_and_ps(r[1], xyz);
+                __m128 c = _mm_and_ps(r[2], xyz);
+                __m128 c3 = _mm_add_ps(
+                    _mm_mul_ps(a, _mm_shuffle_ps(r[0], r[0], _MM_SHUFFLE(3, 3, 3, 3))),
+                    _mm_add_ps(
+                        _mm_mul_ps(b, _mm_shuffle_ps(r[1], r[1], _MM_SHUFFLE(3, 3, 3, 3))),
+                        _mm_mul_ps(c, _mm_shuffle_ps(r[2], r[2], _MM_SHUFFLE(3, 3, 3, 3)))
+                    )
+                );
+                c3 = _mm_sub_ps(_mm_setzero_ps(), c3);
+                _MM_TRANSPOSE4_PS(a, b, c, c3);
+                return store(a, b, c);
+            }
+        }
+        inline static constexpr auto to_mat(Affine const& $1) -> mat_t<float, 4, 4> {
+            if consteval {
+                return Base::to_mat($1);
+            } else {
+                __m128 m[4] = {
+                    _mm_loadu_ps($1.__rows[0].__fields),
+                    _mm_loadu_ps($1.__rows[1].__fields),
+                    _mm_loadu_ps($1.__rows[2].__fields),
+                    _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f),
+                };
+                Mat::transpose(m);
+                return Mat::store(m);
+            }
+        }
+    };
+#endif
+
+    export template<typename T>
+    inline constexpr auto transform_point(affine_t<T> const& $1, vec_t<T, 3> const& $2) -> vec_t<T, 3> {
+        return affine_impl<T>::point($1, $2);
+    }
+    export template<typename T>
+    inline constexpr auto transform_vector(affine_t<T> const& $1, vec_t<T, 3> const& $2) -> vec_t<T, 3> {
+        return affine_impl<T>::vector($1, $2);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto inverse(affine_t<T> const& $1) -> affine_t<T> {
+        return affine_impl<T>::inverse($1);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto inverse_rigid(affine_t<T> const& $1) -> affine_t<T> {
+        return affine_impl<T>::inverse_rigid($1);
+    }
+    // drops the last row, which must be (0, 0, 0, 1) for the round trip to be exact
+    export template<typename T>
+    inline constexpr auto affine(mat_t<T, 4, 4> const& $1) -> affine_t<T> {
+        return affine_impl<T>::from_mat($1);
+    }
+    export template<std::floating_point T>
+    inline constexpr auto affine(quat_t<T> const& $1, vec_t<T, 3> const& $2) -> affine_t<T> {
+        mat_t<T, 3, 3> m = quat_impl<T>::to_mat3($1);
+        return affine_t<T>{
+            vec_t<T, 4>{m.__columns[0][0], m.__columns[1][0], m.__columns[2][0], $2[0]},
+            vec_t<T, 4>{m.__columns[0][1], m.__columns[1][1], m.__columns[2][1], $2[1]},
+            vec_t<T, 4>{m.__columns[0][2], m.__columns[1][2], m.__columns[2][2], $2[2]},
+        };
+    }
+    export template<typename T>
+    inline constexpr auto mat4x4(affine_t<T> const& $1) -> mat_t<T, 4, 4> {
+        return affine_impl<T>::to_mat($1);
+    }
+    // the batch kernels already skip w for points and vectors, so they run on the expanded matrix
+    export template<typename T>
+    inline void transform_points(affine_t<T> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<vec_t<std::type_identity_t<T>, 3>> $3, store_mode $4 = store_mode::cached) {
+        transform_impl<T>::points(affine_impl<T>::to_mat($1), $2, $3, $4);
+    }
+    export template<typename T>
+    inline void transform_vectors(affine_t<T> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<vec_t<std::type_identity_t<T>, 3>> $3, store_mode $4 = store_mode::cached) {
+        transform_impl<T>::vectors(affine_impl<T>::to_mat($1), $2, $3, $4);
+    }
+
+    // depth range of clip space: OpenGL maps near to -w, Direct3D and Vulkan to 0
+    export enum class clip_depth {
+        negative_one_to_one,
+        zero_to_one,
+    };
+
+    // left, right, bottom, top, near, far; xyz is the unit normal pointing inside and w the offset,
+    // so dot(xyz, p) + w is the signed distance of p
+    export template<typename T>
+    struct frustum_t final {
+        vec_t<T, 4> __planes[6];
+
+        friend constexpr auto operator==(frustum_t const&, frustum_t const&) -> bool = default;
+    };
+
+    template<typename T>
+    struct cull_scalar {
+        using Vec = vec_t<T, 3>;
+        using Planes = frustum_t<T>;
+
+        inline static auto load(frustum_t<T> const& $1) -> Planes {
+            return $1;
+        }
+        // bit i for every box i of the $4 <= 64 boxes at centers $2 with half extents $3 that no plane
+        // has entirely outside; conservative, a box off a corner of the frustum can pass
+        inline static auto aabbs(Planes const& $1, Vec const* $2, Vec const* $3, size_t $4) -> uint64_t {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < $4; i += 1) {
+                T distance = std::numeric_limits<T>::infinity();
+                for (vec_t<T, 4> const& p : $1.__planes) {
+                    T d = p[0] * $2[i][0] + p[1] * $2[i][1] + p[2] * $2[i][2] + p[3];
+                    T r = std::abs(p[0]) * $3[i][0] + std::abs(p[1]) * $3[i][1] + std::abs(p[2]) * $3[i][2];
+                    distance = std::min(distance, d + r);
+                }
+                mask |= uint64_t(distance >= T(0)) << i;
+            }
+            return mask;
+        }
+        // bit i for every sphere i of the $4 <= 64 spheres at centers $2 with radii $3, as aabbs
+        inline static auto spheres(Planes const& $1, Vec const* $2, T const* $3, size_t $4) -> uint64_t {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < $4; i += 1) {
+                T distance = std::numeric_limits<T>::infinity();
+                for (vec_t<T, 4> const& p : $1.__planes) {
+                    distance = std::min(distance, p[0] * $2[i][0] + p[1] * $2[i][1] + p[2] * $2[i][2] + p[3] + $3[i]);
+                }
+                mask |= uint64_t(distance >= T(0)) << i;
+            }
+            return mask;
+        }
+    };
+
+    template<typename T>
+    struct cull_impl : cull_scalar<T> {};
+
+#if defined(__AVX__)
+    template<>
+    struct cull_impl<float> : cull_scalar<float> {
+        // every plane broadcast once per call, with the absolute normal for the box extents
+        struct Planes {
+            __m256 __planes[6][4];
+            __m256 __normals[6][3];
+        };
+
+        inline static auto load(frustum_t<float> const& $1) -> Planes {
+            Planes r;
+            for (size_t p = 0; p < 6; p += 1) {
+                for (size_t k = 0; k < 4; k += 1) {
+                    r.__planes[p][k] = _mm256_set1_ps($1.__planes[p][k]);
+                }
+                for (size_t k = 0; k < 3; k += 1) {
+                    r.__normals[p][k] = _mm256_set1_ps(std::abs($1.__planes[p][k]));
+                }
+            }
+            return r;
+        }
+
+        // eight objects per step: centers split into x/y/z registers as in transform_points, the
+        // smallest distance over the planes compared once. A short tail is read from a zeroed copy
+        template<typename Fn>
+        inline static auto each(Vec const* $1, size_t $2, Fn const& fn) -> uint64_t {
+            float const* src = reinterpret_cast<float const*>($1);
+            uint64_t mask = 0;
+            for (size_t i = 0; i < $2; i += 8) {
+                __m256 x, y, z;
+                if (i + 8 <= $2) {
+                    transform_impl<float>::load3(src + i * 3, x, y, z);
+                } else {
+                    float a[24] = {};
+                    std::memcpy(a, src + i * 3, ($2 - i) * sizeof(float) * 3);
+                    transform_impl<float>::load3(a, x, y, z);
+                }
+                __m256 distance = fn(i, x, y, z);
+                mask |= uint64_t(_mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ))) << i;
+            }
+            return $2 < 64 ? mask & ((uint64_t(1) << $2) - 1) : mask;
+        }
+
+        inline static auto aabbs(Planes const& $1, Vec const* $2, Vec const* $3, size_t $4) -> uint64_t {
+            float const* extents = reinterpret_cast<float const*>($3);
+            return each($2, $4, [&](size_t i, __m256 x, __m256 y, __m256 z) {
+                __m256 ex, ey, ez;
+                if (i + 8 <= $4) {
+                    transform_impl<float>::load3(extents + i * 3, ex, ey, ez);
+                } else {
+                    float a[24] = {};
+                    std::memcpy(a, extents + i * 3, ($4 - i) * sizeof(float) * 3);
+                    transform_impl<float>::load3(a, ex, ey, ez);
+                }
+                __m256 distance = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+                for (size_t p = 0; p < 6; p += 1) {
+                    __m256 const* plane = $1.__planes[p];
+                    __m256 const* normal = $1.__normals[p];
+                    __m256 d = transform_impl<float>::madd(plane[0], x, transform_impl<float>::madd(plane[1], y, transform_impl<float>::madd(plane[2], z, plane[3])));
+                    __m256 r = transform_impl<float>::madd(normal[0], ex, transform_impl<float>::madd(normal[1], ey, transform_impl<float>::madd(normal[2], ez, d)));
+                    distance = _mm256_min_ps(distance, r);
+                }
+                return distance;
+            });
+        }
+        inline static auto spheres(Planes const& $1, Vec const* $2, float const* $3, size_t $4) -> uint64_t {
+            return each($2, $4, [&](size_t i, __m256 x, __m256 y, __m256 z) {
+                __m256 radius;
+                if (i + 8 <= $4) {
+                    radius = _mm256_loadu_ps($3 + i);
+                } else {
+                    float a[8] = {};
+                    std::memcpy(a, $3 + i, ($4 - i) * sizeof(float));
+                    radius = _mm256_loadu_ps(a);
+                }
+                __m256 distance = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+                for (size_t p = 0; p < 6; p += 1) {
+                    __m256 const* plane = $1.__planes[p];
+                    __m256 d = transform_impl<float>::madd(plane[0], x, transform_impl<float>::madd(plane[1], y, transform_impl<float>::madd(plane[2], z, plane[3])));
+                    distance = _mm256_min_ps(distance, _mm256_add_ps(d, radius));
+                }
+                return distance;
+            });
+        }
+    };
+#endif
+
+    // culling results in blocks of 64 objects, so threaded callers split on 64-object boundaries
+    struct cull_output {
+        // bit i % 64 of $4[i / 64] for every object i in [$1, $2), $3(first, count) masking up to 64 from first
+        template<typename Test>
+        inline static void words(size_t $1, size_t $2, Test const& $3, uint64_t* $4) {
+            for (size_t i = $1; i < $2; i += 64) {
+                $4[i / 64] = $3(i, std::min<size_t>(64, $2 - i));
+            }
+        }
+        // indices of the visible objects in [$1, $2) written to $4, in order; returns their count
+        template<typename Test>
+        inline static auto indices(size_t $1, size_t $2, Test const& $3, uint32_t* $4) -> size_t {
+            size_t count = 0;
+            for (size_t i = $1; i < $2; i += 64) {
+                for (uint64_t mask = $3(i, std::min<size_t>(64, $2 - i)); mask != 0; mask &= mask - 1) {
+                    $4[count++] = uint32_t(i + size_t(std::countr_zero(mask)));
+                }
+            }
+            return count;
+        }
+    };
+
+    // Gribb-Hartmann: the planes are sums and differences of the rows of $1, normalized
+    export template<typename T>
+    inline auto extract_frustum_planes(mat_t<T, 4, 4> const& $1, clip_depth $2 = clip_depth::negative_one_to_one) -> frustum_t<T> {
+        vec_t<T, 4> x = $1.row(0);
+        vec_t<T, 4> y = $1.row(1);
+        vec_t<T, 4> z = $1.row(2);
+        vec_t<T, 4> w = $1.row(3);
+        frustum_t<T> r{{w + x, w - x, w + y, w - y, $2 == clip_depth::zero_to_one ? z : w + z, w - z}};
+        for (vec_t<T, 4>& p : r.__planes) {
+            p = p / std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        }
+        return r;
+    }
+
+    // boxes at centers $2 with half extents $3 that may be visible; writes their indices to $4, which
+    // has room for every box, and returns how many
+    export template<typename T>
+    inline auto cull_aabbs(frustum_t<T> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<vec_t<std::type_identity_t<T>, 3> const> $3, std::span<uint32_t> $4) -> size_t {
+        auto planes = cull_impl<T>::load($1);
+        return cull_output::indices(0, $2.size(), [&](size_t i, size_t n) { return cull_impl<T>::aabbs(planes, $2.data() + i, $3.data() + i, n); }, $4.data());
+    }
+    // bit i % 64 of $4[i / 64] set for every box that may be visible
+    export template<typename T>
+    inline void cull_aabbs(frustum_t<T> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<vec_t<std::type_identity_t<T>, 3> const> $3, std::span<uint64_t> $4) {
+        auto planes = cull_impl<T>::load($1);
+        cull_output::words(0, $2.size(), [&](size_t i, size_t n) { return cull_impl<T>::aabbs(planes, $2.data() + i, $3.data() + i, n); }, $4.data());
+    }
+    export template<typename T>
+    inline auto cull_spheres(frustum_t<T> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<std::type_identity_t<T> const> $3, std::span<uint32_t> $4) -> size_t {
+        auto planes = cull_impl<T>::load($1);
+        return cull_output::indices(0, $2.size(), [&](size_t i, size_t n) { return cull_impl<T>::spheres(planes, $2.data() + i, $3.data() + i, n); }, $4.data());
+    }
+    export template<typename T>
+    inline void cull_spheres(frustum_t<T> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<std::type_identity_t<T> const> $3, std::span<uint64_t> $4) {
+        auto planes = cull_impl<T>::load($1);
+        cull_output::words(0, $2.size(), [&](size_t i, size_t n) { return cull_impl<T>::spheres(planes, $2.data() + i, $3.data() + i, n); }, $4.data());
+    }
+
+    export enum class summation {
+        // halves the input down to blocks of reduce_impl::pairwise_block vectors, error grows with log n
+        pairwise,
+        // compensated per lane, error independent of n at about four times the cost of a plain sum
+        kahan,
+    };
+
+    // componentwise extent of a set of vectors; the empty set is min = +inf, max = -inf so unions need no special case
+    export template<typename T, size_t Len>
+    struct bounds_t final {
+        vec_t<T, Len> __min;
+        vec_t<T, Len> __max;
+
+        friend constexpr auto operator==(bounds_t const&, bounds_t const&) -> bool = default;
+    };
+
+    template<typename T, size_t Len, typename = std::make_index_sequence<Len>>
+    struct reduce_impl;
+
+    // a block of width vectors is Len packs in memory order: lane j of pack k holds component (k * width + j) % Len,
+    // so interleaved spans reduce without a transpose and the packs fold back as width vectors at the end
+    template<typename T, size_t Len, size_t... I>
+    struct reduce_impl<T, Len, std::index_sequence<I...>> {
+        using Vec = vec_t<T, Len>;
+        using Bounds = bounds_t<T, Len>;
+        using Pack = simd<T, simd_width<T>>;
+
+        static constexpr size_t width = Pack::width;
+        static constexpr size_t pairwise_block = 256;
+
+        inline static auto lowest() -> T {
+            if constexpr (std::numeric_limits<T>::has_infinity) {
+                return -std::numeric_limits<T>::infinity();
+            } else {
+                return std::numeric_limits<T>::lowest();
+            }
+        }
+        inline static auto highest() -> T {
+            if constexpr (std::numeric_limits<T>::has_infinity) {
+                return std::numeric_limits<T>::infinity();
+            } else {
+                return std::numeric_limits<T>::max();
+            }
+        }
+
+        inline static auto load(std::span<Vec const> $1, size_t i, size_t k) -> Pack {
+            return Pack::load($1[i].__fields + k * width);
+        }
+        inline static void store(Pack const (&$1)[Len], Vec (&$2)[width]) {
+            ($1[I].store($2[0].__fields + I * width), ...);
+        }
+
+        // $3 on whole blocks, $4 on the folded lanes and the tail
+        template<typename PackOp, typename VecOp>
+        inline static auto fold(std::span<Vec const> $1, Vec $2, PackOp const& $3, VecOp const& $4) -> Vec {
+            size_t i = 0;
+            if ($1.size() >= width) {
+                Pack acc[Len] = {load($1, 0, I)...};
+                for (i = width; i + width <= $1.size(); i += width) {
+                    ((acc[I] = $3(acc[I], load($1, i, I))), ...);
+                }
+                Vec lanes[width];
+                store(acc, lanes);
+                for (Vec const& v : lanes) {
+                    $2 = $4($2, v);
+                }
+            }
+            for (; i < $1.size(); i += 1) {
+                $2 = $4($2, $1[i]);
+            }
+            return $2;
+        }
+
+        inline static auto min(std::span<Vec const> $1) -> Vec {
+            return fold($1, vec_impl<T, Len>::broadcast(highest()), [](Pack a, Pack b) { return Pack::min(a, b); }, [](Vec const& a, Vec const& b) { return vec_impl<T, Len>::min(a, b); });
+        }
+        inline static auto max(std::span<Vec const> $1) -> Vec {
+            return fold($1, vec_impl<T, Len>::broadcast(lowest()), [](Pack a, Pack b) { return Pack::max(a, b); }, [](Vec const& a, Vec const& b) { return vec_impl<T, Len>::max(a, b); });
+        }
+        // min and max in one pass over the input
+        inline static auto bounds(std::span<Vec const> $1) -> Bounds {
+            Bounds r{vec_impl<T, Len>::broadcast(highest()), vec_impl<T, Len>::broadcast(lowest())};
+            size_t i = 0;
+            if ($1.size() >= width) {
+                Pack lo[Len] = {load($1, 0, I)...};
+                Pack hi[Len] = {lo[I]...};
+                for (i = width; i + width <= $1.size(); i += width) {
+                    ((lo[I] = Pack::min(lo[I], load($1, i, I)), hi[I] = Pack::max(hi[I], load($1, i, I))), ...);
+                }
+                Vec lanes[width];
+                store(lo, lanes);
+                for (Vec const& v : lanes) {
+                    r.__min = vec_impl<T, Len>::min(r.__min, v);
+                }
+                store(hi, lanes);
+                for (Vec const& v : lanes) {
+                    r.__max = vec_impl<T, Len>::max(r.__max, v);
+                }
+            }
+            for (; i < $1.size(); i += 1) {
+                r.__min = vec_impl<T, Len>::min(r.__min, $1[i]);
+                r.__max = vec_impl<T, Len>::max(r.__max, $1[i]);
+            }
+            return r;
+        }
+        inline static auto sum(std::span<Vec const> $1) -> Vec {
+            if ($1.size() <= pairwise_block) {
+                return fold($1, Vec{}, [](Pack a, Pack b) { return a + b; }, [](Vec const& a, Vec const& b) { return a + b; });
+            }
+            size_t half = $1.size() / 2;
+            return sum($1.first(half)) + sum($1.subspan(half));
+        }
+        // c collects the low bits that s + y dropped, negated
+        inline static void kahan_step(Pack& $1, Pack& $2, Pack $3) {
+            Pack y = $3 - $2;
+            Pack t = $1 + y;
+            $2 = (t - $1) - y;
+            $1 = t;
+        }
+        // Neumaier would also cover inputs larger than the running sum, plain Kahan keeps the SIMD step at four ops
+        inline static auto kahan(std::span<Vec const> $1) -> Vec requires std::floating_point<T> {
+            Vec s{};
+            Vec c{};
+            auto add = [&](Vec const& x) {
+                Vec y = x - c;
+                Vec t = s + y;
+                c = (t - s) - y;
+                s = t;
+            };
+            size_t i = 0;
+            if ($1.size() >= width) {
+                Pack ps[Len] = {load($1, 0, I)...};
+                Pack pc[Len] = {(I, Pack::broadcast(T(0)))...};
+                for (i = width; i + width <= $1.size(); i += width) {
+                    (kahan_step(ps[I], pc[I], load($1, i, I)), ...);
+                }
+                Vec sums[width];
+                Vec errors[width];
+                store(ps, sums);
+                store(pc, errors);
+                for (size_t j = 0; j < width; j += 1) {
+                    add(sums[j]);
+                    add(T(0) - errors[j]);
+                }
+            }
+            for (; i < $1.size(); i += 1) {
+                add($1[i]);
+            }
+            return s;
+        }
+    };
+
+    // the reductions take any vec_range and read it as a span of const vectors
+    template<typename Range>
+    using vec_range_reduce = reduce_impl<vec_range_scalar<Range>, vec_range_length<Range>>;
+
+    export template<vec_range Range>
+    inline auto reduce_min(Range&& $1) -> range_vec_t<Range> {
+        return vec_range_reduce<Range>::min(vec_range_span<Range>($1));
+    }
+    export template<vec_range Range>
+    inline auto reduce_max(Range&& $1) -> range_vec_t<Range> {
+        return vec_range_reduce<Range>::max(vec_range_span<Range>($1));
+    }
+    export template<vec_range Range>
+    inline auto bounds(Range&& $1) -> typename vec_range_reduce<Range>::Bounds {
+        return vec_range_reduce<Range>::bounds(vec_range_span<Range>($1));
+    }
+    // integer sums are exact in any order, so $2 only matters for floating point
+    export template<vec_range Range>
+    inline auto sum(Range&& $1, summation $2 = summation::pairwise) -> range_vec_t<Range> {
+        if constexpr (std::floating_point<vec_range_scalar<Range>>) {
+            if ($2 == summation::kahan) {
+                return vec_range_reduce<Range>::kahan(vec_range_span<Range>($1));
+            }
+        }
+        return vec_range_reduce<Range>::sum(vec_range_span<Range>($1));
+    }
+    // the zero vector for an empty range
+    export template<vec_range Range> requires std::floating_point<vec_range_scalar<Range>>
+    inline auto centroid(Range&& $1, summation $2 = summation::pairwise) -> range_vec_t<Range> {
+        vec_range_span<Range> items($1);
+        if (items.empty()) {
+            return range_vec_t<Range>{};
+        }
+        return sum(items, $2) / vec_range_scalar<Range>(items.size());
+    }
+
+    // storage encodings; arithmetic happens on the vec_t<float, Len> that unpack returns
+    namespace format {
+        export struct f16 {
+            using Bits = uint16_t;
+        };
+        export struct snorm16 {
+            using Bits = int16_t;
+        };
+        export struct unorm8 {
+            using Bits = uint8_t;
+        };
+        export struct unorm10_10_10_2 {
+            using Bits = uint32_t;
+        };
+        export struct snorm10_10_10_2 {
+            using Bits = uint32_t;
+        };
+    }
+
+    // Len components of Format, tightly packed, so arrays of it can be uploaded as vertex attributes
+    export template<typename F, size_t Len>
+    struct packed_t final {
+        using Self = packed_t;
+        using Format = F;
+        using Bits = typename F::Bits;
+
+        Bits __fields[Len];
+
+        friend constexpr auto operator==(Self const& $1, Self const& $2) -> bool = default;
+    };
+
+    // x, y and z in 10 bits from the least significant end, w in the top 2 bits
+    export template<typename F>
+    struct packed32_t final {
+        using Self = packed32_t;
+        using Format = F;
+        using Bits = typename F::Bits;
+
+        Bits __bits;
+
+        friend constexpr auto operator==(Self const& $1, Self const& $2) -> bool = default;
+    };
+
+    // round half to even, as cvtps2dq does; at run time cvtss2si keeps the caller's multiply from being contracted into the add
+    inline constexpr auto round_even(float $1) -> int32_t {
+#if defined(__SSE2__)
+        if !consteval {
+            return _mm_cvtss_si32(_mm_set_ss($1));
+        }
+#endif
+        return static_cast<int32_t>(($1 + 12582912.0f) - 12582912.0f);
+    }
+
+    template<typename Format>
+    struct codec;
+
+    template<>
+    struct codec<format::f16> {
+        // round to nearest even, overflow to infinity and quieted NaN payloads, bit-exact with vcvtps2ph
+        inline static constexpr auto encode(float $1) -> uint16_t {
+            uint32_t u = std::bit_cast<uint32_t>($1);
+            uint32_t sign = (u >> 16) & 0x8000;
+            uint32_t a = u & 0x7fffffff;
+            if (a >= 0x7f800000) {
+                return static_cast<uint16_t>(sign | 0x7c00 | (a > 0x7f800000 ? 0x0200 | ((a >> 13) & 0x03ff) : 0));
+            }
+            if (a >= 0x477ff000) {
+                return static_cast<uint16_t>(sign | 0x7c00);
+            }
+            if (a < 0x38800000) {
+                // adding 0.5 rounds to a multiple of 2^-24, the subnormal half step
+                float f = std::bit_cast<float>(a) + 0.5f;
+                return static_cast<uint16_t>(sign | (std::bit_cast<uint32_t>(f) - 0x3f000000));
+            }
+            a += 0xc8000fff + ((a >> 13) & 1);
+            return static_cast<uint16_t>(sign | (a >> 13));
+        }
+        inline static constexpr auto decode(uint16_t $1) -> float {
+            uint32_t sign = static_cast<uint32_t>($1 & 0x8000) << 16;
+            uint32_t a = $1 & 0x7fff;
+            if (a >= 0x7c00) {
+                return std::bit_cast<float>(sign | 0x7f800000 | ((a & 0x03ff) << 13) | (a > 0x7c00 ? 0x00400000 : 0));
+            }
+            if (a < 0x0400) {
+                return std::bit_cast<float>(sign | std::bit_cast<uint32_t>(static_cast<float>(a) * 0x1p-24f));
+            }
+            return std::bit_cast<float>(sign | ((a << 13) + 0x38000000));
+        }
+    };
+
+    // clamps are written as min then max with the operand order of minps/maxps, so NaN encodes the same on every path
+    template<>
+    struct codec<format::snorm16> {
+        inline static constexpr auto encode(float $1) -> int16_t {
+            float t = $1 < 1.0f ? $1 : 1.0f;
+            t = t > -1.0f ? t : -1.0f;
+            return static_cast<int16_t>(round_even(t * 32767.0f));
+        }
+        inline static constexpr auto decode(int16_t $1) -> float {
+            float t = static_cast<float>($1) * (1.0f / 32767.0f);
+            return t > -1.0f ? t : -1.0f;
+        }
+    };
+
+    template<>
+    struct codec<format::unorm8> {
+        inline static constexpr auto encode(float $1) -> uint8_t {
+            float t = $1 < 1.0f ? $1 : 1.0f;
+            t = t > 0.0f ? t : 0.0f;
+            return static_cast<uint8_t>(round_even(t * 255.0f));
+        }
+        inline static constexpr auto decode(uint8_t $1) -> float {
+            return static_cast<float>($1) * (1.0f / 255.0f);
+        }
+    };
+
+    template<typename Format>
+    struct pack_impl;
+
+    template<typename Format>
+    struct pack_scalar {
+        using Bits = typename Format::Bits;
+
+        inline static void encode(float const* $1, Bits* $2, size_t $3) {
+            for (size_t i = 0; i < $3; i += 1) {
+                $2[i] = codec<Format>::encode($1[i]);
+            }
+        }
+        inline static void decode(Bits const* $1, float* $2, size_t $3) {
+            for (size_t i = 0; i < $3; i += 1) {
+                $2[i] = codec<Format>::decode($1[i]);
+            }
+        }
+
+        template<size_t Len>
+        inline static constexpr auto pack(vec_t<float, Len> const& $1) -> packed_t<Format, Len> {
+            packed_t<Format, Len> out{};
+            for (size_t i = 0; i < Len; i += 1) {
+                out.__fields[i] = codec<Format>::encode($1[i]);
+            }
+            return out;
+        }
+        template<size_t Len>
+        inline static constexpr auto unpack(packed_t<Format, Len> const& $1) -> vec_t<float, Len> {
+            vec_t<float, Len> out{};
+            for (size_t i = 0; i < Len; i += 1) {
+                out.__fields[i] = codec<Format>::decode($1.__fields[i]);
+            }
+            return out;
+        }
+
+        // both sides are flat component arrays, so a span converts as one run of size * Len values
+        template<size_t Len>
+        inline static void pack_all(std::span<vec_t<float, Len> const> $1, std::span<packed_t<Format, Len>> $2) {
+            pack_impl<Format>::encode(reinterpret_cast<float const*>($1.data()), reinterpret_cast<Bits*>($2.data()), $1.size() * Len);
+        }
+        template<size_t Len>
+        inline static void unpack_all(std::span<packed_t<Format, Len> const> $1, std::span<vec_t<float, Len>> $2) {
+            pack_impl<Format>::decode(reinterpret_cast<Bits const*>($1.data()), reinterpret_cast<float*>($2.data()), $1.size() * Len);
+        }
+    };
+
+    template<typename Format, bool Signed>
+    struct pack_scalar_10_10_10_2 {
+        static constexpr float lo = Signed ? -1.0f : 0.0f;
+
+        inline static constexpr auto scale(size_t $1) -> float {
+            return Signed ? ($1 < 3 ? 511.0f : 1.0f) : ($1 < 3 ? 1023.0f : 3.0f);
+        }
+
+        inline static constexpr auto pack(vec_t<float, 4> const& $1) -> packed32_t<Format> {
+            uint32_t bits = 0;
+            for (size_t i = 0; i < 4; i += 1) {
+                float t = $1[i] < 1.0f ? $1[i] : 1.0f;
+                t = t > lo ? t : lo;
+                auto q = static_cast<uint32_t>(round_even(t * scale(i)));
+                bits |= (q & (i < 3 ? 0x3ffu : 0x3u)) << (i * 10);
+            }
+            return {bits};
+        }
+        inline static constexpr auto unpack(packed32_t<Format> const& $1) -> vec_t<float, 4> {
+            vec_t<float, 4> out{};
+            for (size_t i = 0; i < 4; i += 1) {
+                int32_t q;
+                if constexpr (Signed) {
+                    q = static_cast<int32_t>($1.__bits << (i < 3 ? 22 - i * 10 : 0)) >> (i < 3 ? 22 : 30);
+                } else {
+                    q = static_cast<int32_t>(($1.__bits >> (i * 10)) & (i < 3 ? 0x3ffu : 0x3u));
+                }
+                float t = static_cast<float>(q) * (1.0f / scale(i));
+                out.__fields[i] = t > lo ? t : lo;
+            }
+            return out;
+        }
+
+        inline static void pack_all(std::span<vec_t<float, 4> const> $1, std::span<packed32_t<Format>> $2) {
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                $2[i] = pack_impl<Format>::pack($1[i]);
+            }
+        }
+        inline static void unpack_all(std::span<packed32_t<Format> const> $1, std::span<vec_t<float, 4>> $2) {
+            for (size_t i = 0; i < $1.size(); i += 1) {
+                $2[i] = pack_impl<Format>::unpack($1[i]);
+            }
+        }
+    };
+
+    template<>
+    struct pack_scalar<format::unorm10_10_10_2> : pack_scalar_10_10_10_2<format::unorm10_10_10_2, false> {};
+
+    template<>
+    struct pack_scalar<format::snorm10_10_10_2> : pack_scalar_10_10_10_2<format::snorm10_10_10_2, true> {};
+
+    template<typename Format>
+    struct pack_impl : pack_scalar<Format> {};
+
+#if defined(__SSE4_1__)
+    // four components per register through pack_impl<Format>::encode4/decode4; tails and short vectors are padded in registers
+    template<typename Format>
+    struct pack_lanes : pack_scalar<Format> {
+        using Base = pack_scalar<Format>;
+        using Bits = typename Base::Bits;
+
+        inline static auto load(float const* $1, size_t $2) -> __m128 {
+            float a[4] = {};
+            std::memcpy(a, $1, $2 * sizeof(float));
+            return _mm_loadu_ps(a);
+        }
+        inline static auto load(Bits const* $1, size_t $2) -> __m128i {
+            if ($2 == 4 && sizeof(Bits) == 2) {
+                return _mm_loadl_epi64(reinterpret_cast<__m128i const*>($1));
+            }
+            uint64_t a = 0;
+            std::memcpy(&a, $1, $2 * sizeof(Bits));
+            return _mm_cvtsi64_si128(static_cast<int64_t>(a));
+        }
+        inline static void store(float* $1, __m128 $2, size_t $3) {
+            float a[4];
+            _mm_storeu_ps(a, $2);
+            std::memcpy($1, a, $3 * sizeof(float));
+        }
+        inline static void store(Bits* $1, __m128i $2, size_t $3) {
+            if ($3 == 4 && sizeof(Bits) == 2) {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>($1), $2);
+                return;
+            }
+            auto a = static_cast<uint64_t>(_mm_cvtsi128_si64($2));
+            std::memcpy($1, &a, $3 * sizeof(Bits));
+        }
+
+        inline static void encode(float const* $1, Bits* $2, size_t $3) {
+            size_t i = 0;
+            for (; i + 4 <= $3; i += 4) {
+                store($2 + i, pack_impl<Format>::encode4(_mm_loadu_ps($1 + i)), 4);
+            }
+            if (i < $3) {
+                store($2 + i, pack_impl<Format>::encode4(load($1 + i, $3 - i)), $3 - i);
+            }
+        }
+        inline static void decode(Bits const* $1, float* $2, size_t $3) {
+            size_t i = 0;
+            for (; i + 4 <= $3; i += 4) {
+                _mm_storeu_ps($2 + i, pack_impl<Format>::decode4(load($1 + i, 4)));
+            }
+            if (i < $3) {
+                store($2 + i, pack_impl<Format>::decode4(load($1 + i, $3 - i)), $3 - i);
+            }
+        }
+
+        template<size_t Len>
+        inline static constexpr auto pack(vec_t<float, Len> const& $1) -> packed_t<Format, Len> {
+            if consteval {
+                return Base::pack($1);
+            } else {
+                packed_t<Format, Len> out;
+                store(out.__fields, pack_impl<Format>::encode4(load($1.__fields, Len)), Len);
+                return out;
+            }
+        }
+        template<size_t Len>
+        inline static constexpr auto unpack(packed_t<Format, Len> const& $1) -> vec_t<float, Len> {
+            if consteval {
+                return Base::unpack($1);
+            } else {
+                vec_t<float, Len> out;
+                store(out.__fields, pack_impl<Format>::decode4(load($1.__fields, Len)), Len);
+                return out;
+            }
+        }
+    };
+
+#if defined(__F16C__)
+    template<>
+    struct pack_impl<format::f16> : pack_lanes<format::f16> {
+        inline static auto encode4(__m128 $1) -> __m128i {
+            return _mm_cvtps_ph($1, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        }
+        inline static auto decode4(__m128i $1) -> __m128 {
+            return _mm_cvtph_ps($1);
+        }
+    };
+#endif
+
+    template<>
+    struct pack_impl<format::snorm16> : pack_lanes<format::snorm16> {
+        inline static auto encode4(__m128 $1) -> __m128i {
+            __m128 t = _mm_max_ps(_mm_min_ps($1, _mm_set1_ps(1.0f)), _mm_set1_ps(-1.0f));
+            __m128i q = _mm_cvtps_epi32(_mm_mul_ps(t, _mm_set1_ps(32767.0f)));
+            return _mm_packs_epi32(q, q);
+        }
+        inline static auto decode4(__m128i $1) -> __m128 {
+            __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepi16_epi32($1)), _mm_set1_ps(1.0f / 32767.0f));
+            return _mm_max_ps(t, _mm_set1_ps(-1.0f));
+        }
+    };
+
+    template<>
+    struct pack_impl<format::unorm8> : pack_lanes<format::unorm8> {
+        inline static auto encode4(__m128 $1) -> __m128i {
+            __m128 t = _mm_max_ps(_mm_min_ps($1, _mm_set1_ps(1.0f)), _mm_setzero_ps());
+            __m128i q = _mm_cvtps_epi32(_mm_mul_ps(t, _mm_set1_ps(255.0f)));
+            q = _mm_packus_epi32(q, q);
+            return _mm_packus_epi16(q, q);
+        }
+        inline static auto decode4(__m128i $1) -> __m128 {
+            return _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32($1)), _mm_set1_ps(1.0f / 255.0f));
+        }
+    };
+#endif
+
+#if defined(__AVX2__)
+    // the four fields are shifted into their own lanes with per-lane variable shifts
+    template<typename Format, bool Signed>
+    struct pack_impl_10_10_10_2 : pack_scalar_10_10_10_2<Format, Signed> {
+        using Base = pack_scalar_10_10_10_2<Format, Signed>;
+
+        inline static auto scale() -> __m128 {
+            return _mm_setr_ps(Base::scale(0), Base::scale(1), Base::scale(2), Base::scale(3));
+        }
+
+        inline static constexpr auto pack(vec_t<float, 4> const& $1) -> packed32_t<Format> {
+            if consteval {
+                return Base::pack($1);
+            } else {
+                __m128 t = _mm_max_ps(_mm_min_ps(_mm_loadu_ps($1.__fields), _mm_set1_ps(1.0f)), _mm_set1_ps(Base::lo));
+                __m128i q = _mm_cvtps_epi32(_mm_mul_ps(t, scale()));
+                q = _mm_and_si128(q, _mm_setr_epi32(0x3ff, 0x3ff, 0x3ff, 0x3));
+                q = _mm_sllv_epi32(q, _mm_setr_epi32(0, 10, 20, 30));
+                q = _mm_or_si128(q, _mm_shuffle_epi32(q, _MM_SHUFFLE(1, 0, 3, 2)));
+                q = _mm_or_si128(q, _mm_shuffle_epi32(q, _MM_SHUFFLE(2, 3, 0, 1)));
+                return {static_cast<uint32_t>(_mm_cvtsi128_si32(q))};
+            }
+        }
+        inline static constexpr auto unpack(packed32_t<Format> const& $1) -> vec_t<float, 4> {
+            if consteval {
+                return Base::unpack($1);
+            } else {
+                __m128i v = _mm_set1_epi32(static_cast<int32_t>($1.__bits));
+                __m128i q;
+                if constexpr (Signed) {
+                    q = _mm_srav_epi32(_mm_sllv_epi32(v, _mm_setr_epi32(22, 12, 2, 0)), _mm_setr_epi32(22, 22, 22, 30));
+                } else {
+                    q = _mm_and_si128(_mm_srlv_epi32(v, _mm_setr_epi32(0, 10, 20, 30)), _mm_setr_epi32(0x3ff, 0x3ff, 0x3ff, 0x3));
+                }
+                __m128 r = _mm_div_ps(_mm_set1_ps(1.0f), scale());
+                __m128 t = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(q), r), _mm_set1_ps(Base::lo));
+                vec_t<float, 4> out;
+                _mm_storeu_ps(out.__fields, t);
+                return out;
+            }
+        }
+    };
+
+    template<>
+    struct pack_impl<format::unorm10_10_10_2> : pack_impl_10_10_10_2<format::unorm10_10_10_2, false> {};
+
+    template<>
+    struct pack_impl<format::snorm10_10_10_2> : pack_impl_10_10_10_2<format::snorm10_10_10_2, true> {};
+#endif
+
+    // math::pack<f16vec3>(n); values round to nearest even and clamp to the format's range
+    export template<typename P, size_t Len>
+    inline constexpr auto pack(vec_t<float, Len> const& $1) -> P {
+        return pack_impl<typename P::Format>::pack($1);
+    }
+    export template<typename Format, size_t Len>
+    inline constexpr auto unpack(packed_t<Format, Len> const& $1) -> vec_t<float, Len> {
+        return pack_impl<Format>::unpack($1);
+    }
+    export template<typename Format>
+    inline constexpr auto unpack(packed32_t<Format> const& $1) -> vec_t<float, 4> {
+        return pack_impl<Format>::unpack($1);
+    }
+
+    template<typename P>
+    using unpacked_t = decltype(unpack(std::declval<P const&>()));
+
+    // math::pack<f16vec3>(normals, buffer) and math::unpack<f16vec3>(buffer, normals); P is always named, so
+    // vectors and arrays convert to both spans. Components are converted in registers straight from and into the spans
+    export template<typename P>
+    inline void pack(std::span<unpacked_t<P> const> $1, std::span<std::type_identity_t<P>> $2) {
+        require_size($2.size(), $1.size(), "math::pack: output is shorter than the input");
+        pack_impl<typename P::Format>::pack_all($1, $2);
+    }
+    export template<typename P>
+    inline void unpack(std::span<std::type_identity_t<P> const> $1, std::span<unpacked_t<P>> $2) {
+        require_size($2.size(), $1.size(), "math::unpack: output is shorter than the input");
+        pack_impl<typename P::Format>::unpack_all($1, $2);
+    }
+
+    export enum class scalar_type : uint32_t {
+        i8 = 1,
+        i16,
+        i32,
+        i64,
+        u8,
+        u16,
+        u32,
+        u64,
+        f32,
+        f64,
+    };
+
+    template<typename T>
+    inline constexpr scalar_type scalar_type_of{};
+
+    template<> inline constexpr scalar_type scalar_type_of<int8_t> = scalar_type::i8;
+    template<> inline constexpr scalar_type scalar_type_of<int16_t> = scalar_type::i16;
+    template<> inline constexpr scalar_type scalar_type_of<int32_t> = scalar_type::i32;
+    template<> inline constexpr scalar_type scalar_type_of<int64_t> = scalar_type::i64;
+    template<> inline constexpr scalar_type scalar_type_of<uint8_t> = scalar_type::u8;
+    template<> inline constexpr scalar_type scalar_type_of<uint16_t> = scalar_type::u16;
+    template<> inline constexpr scalar_type scalar_type_of<uint32_t> = scalar_type::u32;
+    template<> inline constexpr scalar_type scalar_type_of<uint64_t> = scalar_type::u64;
+    template<> inline constexpr scalar_type scalar_type_of<float> = scalar_type::f32;
+    template<> inline constexpr scalar_type scalar_type_of<double> = scalar_type::f64;
+
+    template<typename E>
+    struct blob_layout;
+
+    template<typename T, size_t Len>
+    struct blob_layout<vec_t<T, Len>> {
+        static constexpr scalar_type scalar = scalar_type_of<T>;
+        static constexpr uint32_t cols = 1;
+        static constexpr uint32_t rows = Len;
+    };
+
+    template<typename T, size_t Cols, size_t Rows>
+    struct blob_layout<mat_t<T, Cols, Rows>> {
+        static constexpr scalar_type scalar = scalar_type_of<T>;
+        static constexpr uint32_t cols = Cols;
+        static constexpr uint32_t rows = Rows;
+    };
+
+    // file layout: blob_header, then per array a blob_section on a 64-byte boundary followed by the
+    // raw elements at the section's alignment; everything is host-endian, which `endian` records
+    struct blob_header {
+        static constexpr char magic_bytes[8] = {'M', 'A', 'T', 'H', 'B', 'L', 'O', 'B'};
+        static constexpr uint32_t current_version = 1;
+        static constexpr uint32_t host_endian = 0x01020304;
+
+        char magic[8];
+        uint32_t version;
+        uint32_t endian;
+        uint64_t sections;
+        uint64_t reserved[5];
+    };
+
+    // vectors are stored with cols = 1 and rows = Len; offset is the byte offset of the first element
+    export struct blob_section {
+        scalar_type scalar;
+        uint32_t cols;
+        uint32_t rows;
+        uint32_t alignment;
+        uint64_t count;
+        uint64_t offset;
+        uint64_t bytes;
+        uint64_t reserved[3];
+    };
+
+    static_assert(sizeof(blob_header) == 64);
+    static_assert(sizeof(blob_section) == 64);
+
+    inline constexpr auto align_up(uint64_t $1, uint64_t $2) -> uint64_t {
+        return ($1 + $2 - 1) & ~($2 - 1);
+    }
+
+    // arrays of vec_t/mat_t written as they arrive: begin<E>, any number of append calls, end;
+    // counts are patched into the section header on end and the section total on close
+    export struct blob_writer {
+        using Self = blob_writer;
+
+        inline static auto create(char const* $1) -> std::expected<Self, std::error_code> {
+            Self self;
+            self.__file = std::fopen($1, "wb");
+            if (self.__file == nullptr) {
+                return std::unexpected(std::error_code(errno, std::generic_category()));
+            }
+            blob_header header{};
+            std::memcpy(header.magic, blob_header::magic_bytes, sizeof(header.magic));
+            header.version = blob_header::current_version;
+            header.endian = blob_header::host_endian;
+            if (std::error_code ec = self.put(&header, sizeof(header))) {
+                return std::unexpected(ec);
+            }
+            return self;
+        }
+
+        blob_writer(Self&& $1) noexcept
+            : __file(std::exchange($1.__file, nullptr))
+            , __position($1.__position)
+            , __sections($1.__sections)
+            , __start($1.__start)
+            , __open($1.__open)
+            , __active(std::exchange($1.__active, false)) {}
+
+        auto operator=(Self&& $1) noexcept -> Self& {
+            if (this != &$1) {
+                close();
+                __file = std::exchange($1.__file, nullptr);
+                __position = $1.__position;
+                __sections = $1.__sections;
+                __start = $1.__start;
+                __open = $1.__open;
+                __active = std::exchange($1.__active, false);
+            }
+            return *this;
+        }
+
+        ~blob_writer() {
+            close();
+        }
+
+        // $1 is the data alignment, a power of two; 64 suits every SIMD load, 4096 allows page-granular mapping
+        template<typename E>
+        inline auto begin(this Self& self, size_t $1 = 64) -> std::error_code {
+            if (self.__file == nullptr || self.__active || $1 == 0 || ($1 & ($1 - 1)) != 0 || $1 < alignof(E)) {
+                return std::make_error_code(std::errc::invalid_argument);
+            }
+            self.__start = align_up(self.__position, 64);
+            self.__open = blob_section{blob_layout<E>::scalar, blob_layout<E>::cols, blob_layout<E>::rows, static_cast<uint32_t>($1)};
+            self.__open.offset = align_up(self.__start + sizeof(blob_section), $1);
+            self.__active = true;
+            if (std::error_code ec = self.pad(self.__start)) {
+                return ec;
+            }
+            if (std::error_code ec = self.put(&self.__open, sizeof(blob_section))) {
+                return ec;
+            }
+            return self.pad(self.__open.offset);
+        }
+        template<typename E>
+        inline auto append(this Self& self, std::span<E> $1) -> std::error_code {
+            using Element = std::remove_const_t<E>;
+            if (!self.__active || self.__open.scalar != blob_layout<Element>::scalar || self.__open.cols != blob_layout<Element>::cols || self.__open.rows != blob_layout<Element>::rows) {
+                return std::make_error_code(std::errc::invalid_argument);
+            }
+            self.__open.count += $1.size();
+            self.__open.bytes += $1.size_bytes();
+            return self.put($1.data(), $1.size_bytes());
+        }
+        inline auto end(this Self& self) -> std::error_code {
+            if (!self.__active) {
+                return std::make_error_code(std::errc::invalid_argument);
+            }
+            self.__active = false;
+            self.__sections += 1;
+            return self.patch(self.__start, &self.__open, sizeof(blob_section));
+        }
+        template<typename E>
+        inline auto write(this Self& self, std::span<E> $1, size_t $2 = 64) -> std::error_code {
+            if (std::error_code ec = self.template begin<std::remove_const_t<E>>($2)) {
+                return ec;
+            }
+            if (std::error_code ec = self.append($1)) {
+                return ec;
+            }
+            return self.end();
+        }
+
+        // ends an open section, records the section count and flushes; reports the first write error
+        inline auto close(this Self& self) -> std::error_code {
+            if (self.__file == nullptr) {
+                return {};
+            }
+            std::error_code ec;
+            if (self.__active) {
+                ec = self.end();
+            }
+            uint64_t sections = self.__sections;
+            if (std::error_code pe = self.patch(offsetof(blob_header, sections), &sections, sizeof(sections)); !ec) {
+                ec = pe;
+            }
+            if (std::fclose(std::exchange(self.__file, nullptr)) != 0 && !ec) {
+                ec = std::error_code(errno, std::generic_category());
+            }
+            return ec;
+        }
+
+        // closed, like a moved-from writer: begin reports invalid_argument and close does nothing
+        blob_writer() = default;
+
+        inline auto put(void const* $1, size_t $2) -> std::error_code {
+            if ($2 != 0 && std::fwrite($1, 1, $2, __file) != $2) {
+                return std::error_code(errno, std::generic_category());
+            }
+            __position += $2;
+            return {};
+        }
+        inline auto pad(uint64_t $1) -> std::error_code {
+            static constexpr char zeros[64] = {};
+            while (__position < $1) {
+                uint64_t n = $1 - __position < sizeof(zeros) ? $1 - __position : sizeof(zeros);
+                if (std::error_code ec = put(zeros, n)) {
+                    return ec;
+                }
+            }
+            return {};
+        }
+        inline auto patch(uint64_t $1, void const* $2, size_t $3) -> std::error_code {
+            if (!seek($1)) {
+                return std::make_error_code(std::errc::file_too_large);
+            }
+            if (std::fwrite($2, 1, $3, __file) != $3 || std::fseek(__file, 0, SEEK_END) != 0) {
+                return std::error_code(errno, std::generic_category());
+            }
+            return {};
+        }
+        // long is 32 bits on Windows and 32-bit targets, so fseek alone would truncate offsets past 2 GiB
+        inline auto seek(uint64_t $1) -> bool {
+#if defined(_WIN32)
+            return $1 <= uint64_t(std::numeric_limits<__int64>::max()) && ::_fseeki64(__file, static_cast<__int64>($1), SEEK_SET) == 0;
+#elif __has_include(<sys/mman.h>)
+            return $1 <= uint64_t(std::numeric_limits<off_t>::max()) && ::fseeko(__file, static_cast<off_t>($1), SEEK_SET) == 0;
+#else
+            return $1 <= uint64_t(std::numeric_limits<long>::max()) && std::fseek(__file, static_cast<long>($1), SEEK_SET) == 0;
+#endif
+        }
+
+        std::FILE* __file = nullptr;
+        uint64_t __position = 0;
+        uint64_t __sections = 0;
+        uint64_t __start = 0;
+        blob_section __open{};
+        bool __active = false;
+    };
+
+#if __has_include(<sys/mman.h>)
+    // maps the whole file read-only; pages fault in on first touch, so opening costs the same for
+    // any file size and untouched sections never become resident
+    export struct blob_reader {
+        using Self = blob_reader;
+
+        inline static auto open(char const* $1) -> std::expected<Self, std::error_code> {
+            int fd = ::open($1, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return std::unexpected(std::error_code(errno, std::generic_category()));
+            }
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+                int error = errno;
+                ::close(fd);
+                return std::unexpected(std::error_code(error, std::generic_category()));
+            }
+            Self self;
+            self.__size = static_cast<size_t>(st.st_size);
+            if (self.__size < sizeof(blob_header)) {
+                ::close(fd);
+                return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+            }
+            void* data = ::mmap(nullptr, self.__size, PROT_READ, MAP_PRIVATE, fd, 0);
+            int error = errno;
+            ::close(fd);
+            if (data == MAP_FAILED) {
+                return std::unexpected(std::error_code(error, std::generic_category()));
+            }
+            self.__data = static_cast<std::byte const*>(data);
+            if (!self.parse()) {
+                return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+            }
+            return self;
+        }
+
+        blob_reader(Self&& $1) noexcept
+            : __data(std::exchange($1.__data, nullptr))
+            , __size(std::exchange($1.__size, 0))
+            , __sections(std::move($1.__sections)) {}
+
+        auto operator=(Self&& $1) noexcept -> Self& {
+            if (this != &$1) {
+                unmap();
+                __data = std::exchange($1.__data, nullptr);
+                __size = std::exchange($1.__size, 0);
+                __sections = std::move($1.__sections);
+            }
+            return *this;
+        }
+
+        ~blob_reader() {
+            unmap();
+        }
+
+        inline auto sections(this Self const& self) -> std::span<blob_section const> {
+            return self.__sections;
+        }
+
+        // zero-copy view of section $1; fails unless E matches the stored scalar type and shape
+        template<typename E>
+        inline auto get(this Self const& self, size_t $1) -> std::expected<std::span<E const>, std::error_code> {
+            if ($1 >= self.__sections.size()) {
+                return std::unexpected(std::make_error_code(std::errc::result_out_of_range));
+            }
+            blob_section const& s = self.__sections[$1];
+            if (s.scalar != blob_layout<E>::scalar || s.cols != blob_layout<E>::cols || s.rows != blob_layout<E>::rows || s.offset % alignof(E) != 0) {
+                return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+            }
+            // count is checked against the mapping before it is multiplied, so a crafted count cannot wrap
+            if (s.count > (self.__size - s.offset) / sizeof(E) || s.bytes != s.count * sizeof(E)) {
+                return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+            }
+            return std::span<E const>(reinterpret_cast<E const*>(self.__data + s.offset), static_cast<size_t>(s.count));
+        }
+
+        // empty, like a moved-from reader: it has no sections and get reports result_out_of_range
+        blob_reader() = default;
+
+        inline void unmap() {
+            if (__data != nullptr) {
+                ::munmap(const_cast<std::byte*>(__data), __size);
+                __data = nullptr;
+            }
+        }
+        // walks the section chain, rejecting anything that would read past the end of the mapping
+        inline auto parse() -> bool {
+            blob_header header;
+            std::memcpy(&header, __data, sizeof(header));
+            if (std::memcmp(header.magic, blob_header::magic_bytes, sizeof(header.magic)) != 0 || header.version != blob_header::current_version || header.endian != blob_header::host_endian) {
+                return false;
+            }
+            uint64_t position = sizeof(blob_header);
+            for (uint64_t i = 0; i < header.sections; i += 1) {
+                position = align_up(position, 64);
+                if (position > __size || __size - position < sizeof(blob_section)) {
+                    return false;
+                }
+                blob_section s;
+                std::memcpy(&s, __data + position, sizeof(s));
+                if (s.alignment == 0 || (s.alignment & (s.alignment - 1)) != 0 || s.offset % s.alignment != 0 || s.offset < position + sizeof(blob_section) || s.offset > __size || __size - s.offset < s.bytes) {
+                    return false;
+                }
+                __sections.push_back(s);
+                position = s.offset + s.bytes;
+            }
+            return true;
+        }
+
+        std::byte const* __data = nullptr;
+        size_t __size = 0;
+        std::vector<blob_section> __sections;
+    };
+#endif
+
+    template<typename T>
+    struct fast_impl;
+
+    template<>
+    struct fast_impl<float> {
+        using Pack = simd<float, simd_width<float>>;
+        using Lane = simd<float, 1>;
+        using Quad = simd<float, (simd_width<float> >= 4 ? 4 : 1)>;
+
+        template<size_t Len>
+        using padded = vec_t<float, (Len + 3) / 4 * 4>;
+
+        template<typename Kernel>
+        inline static void each(size_t count, Kernel const& kernel) {
+            size_t i = 0;
+            for (; i + Pack::width <= count; i += Pack::width) {
+                kernel(Pack{}, i);
+            }
+            for (; i < count; i += 1) {
+                kernel(Lane{}, i);
+            }
+        }
+
+        // a vec_t is padded to whole 128-bit registers, so up to four lanes are one evaluation
+        template<size_t Len, typename Kernel>
+        inline static void each(Kernel const& kernel) {
+            for (size_t i = 0; i < Len; i += Quad::width) {
+                kernel(Quad{}, i);
+            }
+        }
+        template<size_t Len>
+        inline static auto pad(vec_t<float, Len> const& $1) -> padded<Len> {
+            padded<Len> r{};
+            for (size_t i = 0; i < Len; i += 1) {
+                r[i] = $1[i];
+            }
+            return r;
+        }
+        template<size_t Len>
+        inline static auto unpad(padded<Len> const& $1) -> vec_t<float, Len> {
+            vec_t<float, Len> r{};
+            for (size_t i = 0; i < Len; i += 1) {
+                r[i] = $1[i];
+            }
+            return r;
+        }
+
+        template<size_t Len, typename Fn>
+        inline static auto map(vec_t<float, Len> const& $1, Fn const& fn) -> vec_t<float, Len> {
+            padded<Len> a = pad($1);
+            padded<Len> r{};
+            each<Len>([&]<typename P>(P, size_t i) {
+                fn(P::load(a.__fields + i)).store(r.__fields + i);
+            });
+            return unpad<Len>(r);
+        }
+        template<size_t Len, typename Fn>
+        inline static auto map(vec_t<float, Len> const& $1, vec_t<float, Len> const& $2, Fn const& fn) -> vec_t<float, Len> {
+            padded<Len> a = pad($1);
+            padded<Len> b = pad($2);
+            padded<Len> r{};
+            each<Len>([&]<typename P>(P, size_t i) {
+                fn(P::load(a.__fields + i), P::load(b.__fields + i)).store(r.__fields + i);
+            });
+            return unpad<Len>(r);
+        }
+        template<typename Fn>
+        inline static void map(std::span<float const> $1, std::span<float> $2, Fn const& fn) {
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                fn(P::load($1.data() + i)).store($2.data() + i);
+            });
+        }
+        template<typename Fn>
+        inline static void map(std::span<float const> $1, std::span<float const> $2, std::span<float> $3, Fn const& fn) {
+            each($1.size(), [&]<typename P>(P, size_t i) {
+                fn(P::load($1.data() + i), P::load($2.data() + i)).store($3.data() + i);
+            });
+        }
+
+        template<typename P>
+        inline static auto bits(uint32_t $1) -> P {
+            return P::broadcast(std::bit_cast<float>($1));
+        }
+        template<typename P>
+        inline static auto abs(P $1) -> P {
+            return P::band($1, bits<P>(0x7fffffff));
+        }
+        // Horner form, highest coefficient first
+        template<typename P, typename... C>
+        inline static auto poly(P $1, float $2, C... $3) -> P {
+            P r = P::broadcast($2);
+            ((r = P::madd(r, $1, P::broadcast($3))), ...);
+            return r;
+        }
+
+        // Cody-Waite reduction by pi/2 in four parts, then Cephes minimax polynomials on [-pi/4, pi/4]
+        template<typename P>
+        inline static void sincos(P $1, P& $2, P& $3) {
+            P q = P::round($1 * P::broadcast(0.636619772367581343f));
+            P r = P::madd(q, P::broadcast(-1.5703125f), $1);
+            r = P::madd(q, P::broadcast(-4.8351287841796875e-4f), r);
+            r = P::madd(q, P::broadcast(-3.13855707645416259765625e-7f), r);
+            r = P::madd(q, P::broadcast(-6.077100628276710381e-11f), r);
+
+            P z = r * r;
+            P s = P::madd(r * z, poly(z, -1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f), r);
+            P c = P::madd(z * z, poly(z, 2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f), P::madd(z, P::broadcast(-0.5f), P::broadcast(1.0f)));
+
+            // quadrant n = q mod 4: odd quadrants swap sin and cos, sin is negative in 2 and 3, cos in 1 and 2
+            P n = q - P::floor(q * P::broadcast(0.25f)) * P::broadcast(4.0f);
+            auto odd = P::eq(n - P::floor(n * P::broadcast(0.5f)) * P::broadcast(2.0f), P::broadcast(1.0f));
+            P sign = bits<P>(0x80000000);
+            P zero = P::broadcast(0.0f);
+            $2 = P::bxor(P::select(odd, c, s), P::select(P::gt(n, P::broadcast(1.5f)), sign, zero));
+            $3 = P::bxor(P::select(odd, s, c), P::select(P::lt(abs(n - P::broadcast(1.5f)), P::broadcast(1.0f)), sign, zero));
+        }
+        template<typename P>
+        inline static auto sin(P $1) -> P {
+            P s, c;
+            sincos($1, s, c);
+            return s;
+        }
+        template<typename P>
+        inline static auto cos(P $1) -> P {
+            P s, c;
+            sincos($1, s, c);
+            return c;
+        }
+
+        // 2^n * p(f) with |f| <= 1/2; 2^n is applied in two halves so that each factor stays normal
+        template<typename P>
+        inline static auto exp2(P $1) -> P {
+            P x = P::min(P::broadcast(128.0f), P::max(P::broadcast(-151.0f), $1));
+            P n = P::round(x);
+            P f = x - n;
+            P y = P::madd(f, poly(f, 1.535336188319500e-4f, 1.339887440266574e-3f, 9.618437357674640e-3f, 5.550332471162809e-2f, 2.402264791363012e-1f, 6.931472028550421e-1f), P::broadcast(1.0f));
+
+            P h = P::floor(n * P::broadcast(0.5f));
+            P e1 = P::ftoi((h + P::broadcast(127.0f)) * P::broadcast(8388608.0f));
+            P e2 = P::ftoi((n - h + P::broadcast(127.0f)) * P::broadcast(8388608.0f));
+            return y * e1 * e2;
+        }
+
+        // exponent and mantissa split through the bit pattern, mantissa folded into [sqrt(1/2), sqrt(2))
+        template<typename P>
+        inline static auto log2(P $1) -> P {
+            auto tiny = P::lt($1, bits<P>(0x00800000));
+            P x = P::select(tiny, $1 * P::broadcast(8388608.0f), $1);
+            P e = P::itof(P::band(x, bits<P>(0x7f800000))) * P::broadcast(1.0f / 8388608.0f);
+            e = e - P::select(tiny, P::broadcast(150.0f), P::broadcast(127.0f));
+            P m = P::bor(P::band(x, bits<P>(0x007fffff)), P::broadcast(1.0f));
+
+            auto big = P::gt(m, P::broadcast(1.41421356237f));
+            m = P::select(big, m * P::broadcast(0.5f), m);
+            e = P::select(big, e + P::broadcast(1.0f), e);
+
+            P t = m - P::broadcast(1.0f);
+            P z = t * t;
+            P y = P::madd(z * t, poly(t, 7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f, -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f, 2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f), z * P::broadcast(-0.5f));
+
+            // log2(e) = 1 + 0.44269504..., the unit part is added exactly
+            P L = P::broadcast(0.44269504088896340736f);
+            P r = P::madd(t, L, y * L) + y + t + e;
+
+            P inf = bits<P>(0x7f800000);
+            r = P::select(P::eq($1, inf), inf, r);
+            r = P::select(P::eq($1, P::broadcast(0.0f)), bits<P>(0xff800000), r);
+            r = P::select(P::lt($1, P::broadcast(0.0f)), bits<P>(0x7fc00000), r);
+            return P::select(P::isnan($1), $1, r);
+        }
+
+        template<typename P>
+        inline static auto pow(P $1, P $2) -> P {
+            P r = exp2($2 * log2($1));
+            r = P::select(P::eq($1, P::broadcast(1.0f)), P::broadcast(1.0f), r);
+            return P::select(P::eq($2, P::broadcast(0.0f)), P::broadcast(1.0f), r);
+        }
+
+        // atan of min/max ratio on [0, 1], then mirrored into the octant of (x, y)
+        template<typename P>
+        inline static auto atan2(P $1, P $2) -> P {
+            P ay = abs($1);
+            P ax = abs($2);
+            P lo = P::min(ax, ay);
+            P hi = P::max(ax, ay);
+            P t = lo / hi;
+            t = P::select(P::eq(hi, P::broadcast(0.0f)), P::broadcast(0.0f), t);
+            t = P::select(P::eq(lo, bits<P>(0x7f800000)), P::broadcast(1.0f), t);
+
+            P z = t * t;
+            P r = P::madd(t * z, poly(z, 0.00282363896258175373077393f, -0.0159569028764963150024414f, 0.0425049886107444763183594f, -0.0748900920152664184570312f, 0.106347933411598205566406f, -0.142027363181114196777344f, 0.199926957488059997558594f, -0.333331018686294555664062f), t);
+            r = P::select(P::gt(ay, ax), P::broadcast(1.57079632679f) - r, r);
+
+            P sign = bits<P>(0x80000000);
+            r = P::select(P::lt(P::bor(P::band($2, sign), P::broadcast(1.0f)), P::broadcast(0.0f)), P::broadcast(3.14159265359f) - r, r);
+            r = P::bor(r, P::band($1, sign));
+            return P::select(P::isnan(ax + ay), ax + ay, r);
+        }
+    };
+
+    namespace fast {
+        // max error 2.5 ulp for |x| <= 32768; there is no Payne-Hanek reduction, so larger inputs lose accuracy
+        export template<size_t Len>
+        inline auto sin(vec_t<float, Len> const& $1) -> vec_t<float, Len> {
+            return fast_impl<float>::map($1, []<typename P>(P $1) { return fast_impl<float>::sin($1); });
+        }
+        export inline void sin(std::span<float const> $1, std::span<float> $2) {
+            fast_impl<float>::map($1, $2, []<typename P>(P $1) { return fast_impl<float>::sin($1); });
+        }
+
+        // max error 2.5 ulp for |x| <= 32768
+        export template<size_t Len>
+        inline auto cos(vec_t<float, Len> const& $1) -> vec_t<float, Len> {
+            return fast_impl<float>::map($1, []<typename P>(P $1) { return fast_impl<float>::cos($1); });
+        }
+        export inline void cos(std::span<float const> $1, std::span<float> $2) {
+            fast_impl<float>::map($1, $2, []<typename P>(P $1) { return fast_impl<float>::cos($1); });
+        }
+
+        // one range reduction for both results, same error as sin and cos
+        export template<size_t Len>
+        inline void sincos(vec_t<float, Len> const& $1, vec_t<float, Len>& $2, vec_t<float, Len>& $3) {
+            auto a = fast_impl<float>::pad($1);
+            decltype(a) s{};
+            decltype(a) c{};
+            fast_impl<float>::each<Len>([&]<typename P>(P, size_t i) {
+                P rs, rc;
+                fast_impl<float>::sincos(P::load(a.__fields + i), rs, rc);
+                rs.store(s.__fields + i);
+                rc.store(c.__fields + i);
+            });
+            $2 = fast_impl<float>::unpad<Len>(s);
+            $3 = fast_impl<float>::unpad<Len>(c);
+        }
+        export inline void sincos(std::span<float const> $1, std::span<float> $2, std::span<float> $3) {
+            fast_impl<float>::each($1.size(), [&]<typename P>(P, size_t i) {
+                P rs, rc;
+                fast_impl<float>::sincos(P::load($1.data() + i), rs, rc);
+                rs.store($2.data() + i);
+                rc.store($3.data() + i);
+            });
+        }
+
+        // max error 1.2 ulp, denormal results included
+        export template<size_t Len>
+        inline auto exp2(vec_t<float, Len> const& $1) -> vec_t<float, Len> {
+            return fast_impl<float>::map($1, []<typename P>(P $1) { return fast_impl<float>::exp2($1); });
+        }
+        export inline void exp2(std::span<float const> $1, std::span<float> $2) {
+            fast_impl<float>::map($1, $2, []<typename P>(P $1) { return fast_impl<float>::exp2($1); });
+        }
+
+        // max error 1.5 ulp, denormal inputs included
+        export template<size_t Len>
+        inline auto log2(vec_t<float, Len> const& $1) -> vec_t<float, Len> {
+            return fast_impl<float>::map($1, []<typename P>(P $1) { return fast_impl<float>::log2($1); });
+        }
+        export inline void log2(std::span<float const> $1, std::span<float> $2) {
+            fast_impl<float>::map($1, $2, []<typename P>(P $1) { return fast_impl<float>::log2($1); });
+        }
+
+        // exp2(y * log2(x)): max error 2 + |y * log2(x)| ulp, x < 0 gives NaN
+        export template<size_t Len>
+        inline auto pow(vec_t<float, Len> const& $1, vec_t<float, Len> const& $2) -> vec_t<float, Len> {
+            return fast_impl<float>::map($1, $2, []<typename P>(P $1, P $2) { return fast_impl<float>::pow($1, $2); });
+        }
+        export inline void pow(std::span<float const> $1, std::span<float const> $2, std::span<float> $3) {
+            fast_impl<float>::map($1, $2, $3, []<typename P>(P $1, P $2) { return fast_impl<float>::pow($1, $2); });
+        }
+
+        // max error 3 ulp, signed zeros and infinities as std::atan2
+        export template<size_t Len>
+        inline auto atan2(vec_t<float, Len> const& $1, vec_t<float, Len> const& $2) -> vec_t<float, Len> {
+            return fast_impl<float>::map($1, $2, []<typename P>(P $1, P $2) { return fast_impl<float>::atan2($1, $2); });
+        }
+        export inline void atan2(std::span<float const> $1, std::span<float const> $2, std::span<float> $3) {
+            fast_impl<float>::map($1, $2, $3, []<typename P>(P $1, P $2) { return fast_impl<float>::atan2($1, $2); });
+        }
+    }
+
+    namespace parallel {
+        struct job {
+            void (*call)(void const*, size_t);
+            void const* context;
+            std::atomic<size_t> pending;
+            // set by the first chunk that throws; run rethrows error once pending reaches zero
+            std::atomic<bool> failed = false;
+            std::exception_ptr error;
+        };
+
+        struct task {
+            job* owner;
+            size_t chunk;
+        };
+
+        struct task_queue {
+            std::mutex mutex;
+            std::deque<task> tasks;
+        };
+
+        // one queue per worker; owners take from the front, thieves from the back, and the
+        // submitting thread helps until its job drains, so nested runs cannot deadlock
+        export struct thread_pool {
+            using Self = thread_pool;
+
+            explicit thread_pool(size_t $1 = std::thread::hardware_concurrency()) {
+                size_t workers = $1 > 1 ? $1 - 1 : 1;
+                __queues = std::make_unique<task_queue[]>(workers);
+                __count = workers;
+                for (size_t i = 0; i < workers; i += 1) {
+                    __threads.emplace_back([this, i] { work(i); });
+                }
+            }
+            ~thread_pool() {
+                {
+                    std::lock_guard lock(__sleep);
+                    __stopping = true;
+                }
+                __wake.notify_all();
+                for (std::thread& thread : __threads) {
+                    thread.join();
+                }
+            }
+
+            thread_pool(Self const&) = delete;
+            auto operator=(Self const&) -> Self& = delete;
+
+            // workers plus the calling thread
+            constexpr auto size(this Self const& self) -> size_t {
+                return self.__count + 1;
+            }
+
+            // calls fn(i) for every i in [0, count) and returns once all calls have finished; after a call throws,
+            // chunks not yet started are skipped and the first exception is rethrown once every chunk is done
+            template<typename Fn>
+            inline void run(this Self& self, size_t $1, Fn const& fn) {
+                if ($1 == 0) {
+                    return;
+                }
+                if ($1 == 1) {
+                    fn(size_t(0));
+                    return;
+                }
+
+                job j{[](void const* context, size_t i) { (*static_cast<Fn const*>(context))(i); }, &fn, $1};
+                // contiguous runs of chunks per queue keep neighbouring chunks on one core
+                for (size_t q = 0; q < self.__count; q += 1) {
+                    size_t begin = $1 * q / self.__count;
+                    size_t end = $1 * (q + 1) / self.__count;
+                    std::lock_guard lock(self.__queues[q].mutex);
+                    for (size_t i = begin; i < end; i += 1) {
+                        self.__queues[q].tasks.push_back(task{&j, i});
+                    }
+                }
+                {
+                    std::lock_guard lock(self.__sleep);
+                    self.__queued.fetch_add($1, std::memory_order_relaxed);
+                }
+                self.__wake.notify_all();
+
+                while (j.pending.load(std::memory_order_acquire) != 0) {
+                    if (!self.steal(self.__count)) {
+                        std::this_thread::yield();
+                    }
+                }
+                if (j.error) {
+                    std::rethrow_exception(j.error);
+                }
+            }
+
+            // shared pool sized to the machine, created on first use
+            inline static auto global() -> Self& {
+                static Self pool;
+                return pool;
+            }
+
+            // a throwing chunk must not escape a worker or unwind the caller while tasks still point at its job
+            inline void execute(task const& $1) {
+                job& j = *$1.owner;
+                if (!j.failed.load(std::memory_order_relaxed)) {
+                    try {
+                        j.call(j.context, $1.chunk);
+                    } catch (...) {
+                        if (!j.failed.exchange(true, std::memory_order_relaxed)) {
+                            j.error = std::current_exception();
+                        }
+                    }
+                }
+                j.pending.fetch_sub(1, std::memory_order_acq_rel);
+            }
+            inline auto pop(size_t $1) -> bool {
+                task t;
+                {
+                    std::lock_guard lock(__queues[$1].mutex);
+                    if (__queues[$1].tasks.empty()) {
+                        return false;
+                    }
+                    t = __queues[$1].tasks.front();
+                    __queues[$1].tasks.pop_front();
+                }
+                __queued.fetch_sub(1, std::memory_order_relaxed);
+                execute(t);
+                return true;
+            }
+            // scans the other queues starting after $1 and runs one task taken from the back
+            inline auto steal(size_t $1) -> bool {
+                for (size_t k = 1; k <= __count; k += 1) {
+                    size_t q = ($1 + k) % __count;
+                    task t;
+                    {
+                        std::lock_guard lock(__queues[q].mutex);
+                        if (__queues[q].tasks.empty()) {
+                            continue;
+                        }
+                        t = __queues[q].tasks.back();
+                        __queues[q].tasks.pop_back();
+                    }
+                    __queued.fetch_sub(1, std::memory_order_relaxed);
+                    execute(t);
+                    return true;
+                }
+                return false;
+            }
+            inline void work(size_t $1) {
+                for (;;) {
+                    if (pop($1) || steal($1)) {
+                        continue;
+                    }
+                    std::unique_lock lock(__sleep);
+                    __wake.wait(lock, [this] { return __stopping || __queued.load(std::memory_order_relaxed) != 0; });
+                    if (__stopping) {
+                        return;
+                    }
+                }
+            }
+
+            std::unique_ptr<task_queue[]> __queues;
+            std::vector<std::thread> __threads;
+            size_t __count = 0;
+            std::atomic<size_t> __queued = 0;
+            std::mutex __sleep;
+            std::condition_variable __wake;
+            bool __stopping = false;
+        };
+
+        // elements per chunk: 64 KiB of input, so a chunk and its output stay resident in L2;
+        // it depends only on the element size, which keeps chunk boundaries and reductions deterministic
+        export template<typename T>
+        inline constexpr size_t grain = sizeof(T) * 64 >= 64 * 1024 ? 1 : (64 * 1024) / sizeof(T) / 64 * 64;
+
+        // the span a contiguous range is read through; a const container gives a span of const elements
+        template<typename Range>
+        using span_of = std::span<std::remove_reference_t<std::ranges::range_reference_t<Range>>>;
+
+        // fn(chunk, offset) per chunk, so batch kernels such as transform_points run once per chunk;
+        // $1 is any contiguous range (span, vector, array) and the chunks are spans of its elements
+        export template<std::ranges::contiguous_range Range, typename Fn>
+        inline void for_each_chunk(Range&& $1, Fn const& fn, thread_pool& $2 = thread_pool::global()) {
+            using T = typename span_of<Range>::element_type;
+            span_of<Range> items($1);
+            size_t chunks = (items.size() + grain<T> - 1) / grain<T>;
+            $2.run(chunks, [&](size_t c) {
+                size_t begin = c * grain<T>;
+                size_t count = items.size() - begin < grain<T> ? items.size() - begin : grain<T>;
+                fn(items.subspan(begin, count), begin);
+            });
+        }
+        export template<std::ranges::contiguous_range Range, typename Fn>
+        inline void for_each(Range&& $1, Fn const& fn, thread_pool& $2 = thread_pool::global()) {
+            using T = typename span_of<Range>::element_type;
+            for_each_chunk(span_of<Range>($1), [&](std::span<T> chunk, size_t) {
+                for (T& v : chunk) {
+                    fn(v);
+                }
+            }, $2);
+        }
+        // $2[i] = fn($1[i])
+        export template<std::ranges::contiguous_range In, std::ranges::contiguous_range Out, typename Fn>
+        inline void transform(In&& $1, Out&& $2, Fn const& fn, thread_pool& $3 = thread_pool::global()) {
+            using T = typename span_of<In>::element_type;
+            span_of<Out> out($2);
+            require_size(out.size(), std::ranges::size($1), "math::parallel::transform: output is shorter than the input");
+            for_each_chunk(span_of<In>($1), [&](std::span<T> chunk, size_t offset) {
+                for (size_t i = 0; i < chunk.size(); i += 1) {
+                    out[offset + i] = fn(chunk[i]);
+                }
+            }, $3);
+        }
+        // each chunk folds left to right, then the partials fold into $2 in chunk order:
+        // the result is the same for any pool size, which non-associative float math needs
+        export template<std::ranges::contiguous_range Range, typename R, typename Combine, typename Map>
+        inline auto transform_reduce(Range&& $1, R $2, Combine const& combine, Map const& map, thread_pool& $3 = thread_pool::global()) -> R {
+            using T = typename span_of<Range>::element_type;
+            span_of<Range> items($1);
+            size_t chunks = (items.size() + grain<T> - 1) / grain<T>;
+            std::vector<R> partials;
+            partials.reserve(chunks);
+            for (size_t c = 0; c < chunks; c += 1) {
+                partials.push_back($2);
+            }
+            for_each_chunk(items, [&](std::span<T> chunk, size_t offset) {
+                R acc = map(chunk[0]);
+                for (size_t i = 1; i < chunk.size(); i += 1) {
+                    acc = combine(acc, map(chunk[i]));
+                }
+                partials[offset / grain<T>] = acc;
+            }, $3);
+            for (R const& partial : partials) {
+                $2 = combine($2, partial);
+            }
+            return $2;
+        }
+        export template<std::ranges::contiguous_range Range, typename R, typename Combine>
+        inline auto reduce(Range&& $1, R $2, Combine const& combine, thread_pool& $3 = thread_pool::global()) -> R {
+            using T = typename span_of<Range>::element_type;
+            return transform_reduce($1, $2, combine, [](T const& v) -> R { return v; }, $3);
+        }
+
+        // one SIMD reduction per chunk into partials[offset / grain], in chunk order for the serial pass that combines them
+        template<typename R, typename T, typename Fn>
+        inline auto partials(std::span<T> $1, Fn const& fn, thread_pool& $2) -> std::vector<R> {
+            std::vector<R> out(($1.size() + grain<T> - 1) / grain<T>);
+            for_each_chunk($1, [&](std::span<T> chunk, size_t offset) {
+                out[offset / grain<T>] = fn(chunk);
+            }, $2);
+            return out;
+        }
+
+        export template<vec_range Range>
+        inline auto reduce_min(Range&& $1, thread_pool& $2 = thread_pool::global()) -> range_vec_t<Range> {
+            using Reduce = vec_range_reduce<Range>;
+            std::vector<range_vec_t<Range>> mins = partials<range_vec_t<Range>>(vec_range_span<Range>($1), Reduce::min, $2);
+            return Reduce::min(mins);
+        }
+        export template<vec_range Range>
+        inline auto reduce_max(Range&& $1, thread_pool& $2 = thread_pool::global()) -> range_vec_t<Range> {
+            using Reduce = vec_range_reduce<Range>;
+            std::vector<range_vec_t<Range>> maxs = partials<range_vec_t<Range>>(vec_range_span<Range>($1), Reduce::max, $2);
+            return Reduce::max(maxs);
+        }
+        export template<vec_range Range>
+        inline auto bounds(Range&& $1, thread_pool& $2 = thread_pool::global()) -> typename vec_range_reduce<Range>::Bounds {
+            using Reduce = vec_range_reduce<Range>;
+            using Bounds = typename Reduce::Bounds;
+            std::vector<Bounds> boxes = partials<Bounds>(vec_range_span<Range>($1), Reduce::bounds, $2);
+            Bounds r = Reduce::bounds({});
+            for (Bounds const& box : boxes) {
+                r.__min = math::min(r.__min, box.__min);
+                r.__max = math::max(r.__max, box.__max);
+            }
+            return r;
+        }
+        // chunk sums are summed again with $2, so kahan stays compensated across chunks
+        export template<vec_range Range>
+        inline auto sum(Range&& $1, summation $2 = summation::pairwise, thread_pool& $3 = thread_pool::global()) -> range_vec_t<Range> {
+            std::vector<range_vec_t<Range>> sums = partials<range_vec_t<Range>>(vec_range_span<Range>($1), [&](vec_range_span<Range> chunk) {
+                return math::sum(chunk, $2);
+            }, $3);
+            return math::sum(sums, $2);
+        }
+        export template<vec_range Range> requires std::floating_point<vec_range_scalar<Range>>
+        inline auto centroid(Range&& $1, summation $2 = summation::pairwise, thread_pool& $3 = thread_pool::global()) -> range_vec_t<Range> {
+            vec_range_span<Range> items($1);
+            if (items.empty()) {
+                return range_vec_t<Range>{};
+            }
+            return sum(items, $2, $3) / vec_range_scalar<Range>(items.size());
+        }
+
+        // every chunk culls into its own stretch of $2, then the stretches move down in chunk order
+        template<typename T, typename Test>
+        inline auto cull(std::span<T> $1, Test const& $2, std::span<uint32_t> $3, thread_pool& $4) -> size_t {
+            std::vector<size_t> counts(($1.size() + grain<T> - 1) / grain<T>);
+            for_each_chunk($1, [&](std::span<T> chunk, size_t offset) {
+                counts[offset / grain<T>] = cull_output::indices(offset, offset + chunk.size(), $2, $3.data() + offset);
+            }, $4);
+            size_t count = 0;
+            for (size_t c = 0; c < counts.size(); c += 1) {
+                std::copy_n($3.data() + c * grain<T>, counts[c], $3.data() + count);
+                count += counts[c];
+            }
+            return count;
+        }
+        // chunks hold a multiple of 64 objects, so each one writes whole words
+        template<typename T, typename Test>
+        inline void cull(std::span<T> $1, Test const& $2, std::span<uint64_t> $3, thread_pool& $4) {
+            for_each_chunk($1, [&](std::span<T> chunk, size_t offset) {
+                cull_output::words(offset, offset + chunk.size(), $2, $3.data());
+            }, $4);
+        }
+
+        export template<typename T>
+        inline auto cull_aabbs(frustum_t<T> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<vec_t<std::type_identity_t<T>, 3> const> $3, std::span<uint32_t> $4, thread_pool& $5 = thread_pool::global()) -> size_t {
+            auto planes = cull_impl<T>::load($1);
+            return cull($2, [&](size_t i, size_t n) { return cull_impl<T>::aabbs(planes, $2.data() + i, $3.data() + i, n); }, $4, $5);
+        }
+        export template<typename T>
+        inline void cull_aabbs(frustum_t<T> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<vec_t<std::type_identity_t<T>, 3> const> $3, std::span<uint64_t> $4, thread_pool& $5 = thread_pool::global()) {
+            auto planes = cull_impl<T>::load($1);
+            cull($2, [&](size_t i, size_t n) { return cull_impl<T>::aabbs(planes, $2.data() + i, $3.data() + i, n); }, $4, $5);
+        }
+        export template<typename T>
+        inline auto cull_spheres(frustum_t<T> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<std::type_identity_t<T> const> $3, std::span<uint32_t> $4, thread_pool& $5 = thread_pool::global()) -> size_t {
+            auto planes = cull_impl<T>::load($1);
+            return cull($2, [&](size_t i, size_t n) { return cull_impl<T>::spheres(planes, $2.data() + i, $3.data() + i, n); }, $4, $5);
+        }
+        export template<typename T>
+        inline void cull_spheres(frustum_t<T> const& $1, std::span<vec_t<std::type_identity_t<T>, 3> const> $2, std::span<std::type_identity_t<T> const> $3, std::span<uint64_t> $4, thread_pool& $5 = thread_pool::global()) {
+            auto planes = cull_impl<T>::load($1);
+            cull($2, [&](size_t i, size_t n) { return cull_impl<T>::spheres(planes, $2.data() + i, $3.data() + i, n); }, $4, $5);
+        }
+    }
+
+    // ray queries against f32vec3 triangle meshes: 8-ray packets with slab tests, Möller–Trumbore over
+    // SoA triangle streams, and a binned SAH BVH with four children per node
+    export struct ray {
+        vec_t<float, 3> __origin;
+        vec_t<float, 3> __direction;
+        float __tmin = 0.0f;
+        float __tmax = std::numeric_limits<float>::infinity();
+    };
+
+    // __primitive is the index of the input triangle, or miss
+    export struct ray_hit {
+        static constexpr uint32_t miss = std::numeric_limits<uint32_t>::max();
+
+        float __t = std::numeric_limits<float>::infinity();
+        float __u = 0.0f;
+        float __v = 0.0f;
+        uint32_t __primitive = miss;
+    };
+
+    // eight rays with precomputed reciprocal directions; lanes past the given rays are inactive and never hit
+    export struct alignas(32) ray_packet {
+        static constexpr size_t width = 8;
+
+        float __origin[3][width];
+        float __direction[3][width];
+        float __inverse[3][width];
+        float __tmin[width];
+        float __tmax[width];
+
+        explicit ray_packet(std::span<ray const> $1) {
+            for (size_t i = 0; i < width; i += 1) {
+                bool active = i < $1.size();
+                for (size_t a = 0; a < 3; a += 1) {
+                    __origin[a][i] = active ? $1[i].__origin[a] : 0.0f;
+                    __direction[a][i] = active ? $1[i].__direction[a] : 1.0f;
+                    __inverse[a][i] = 1.0f / __direction[a][i];
+                }
+                __tmin[i] = active ? $1[i].__tmin : std::numeric_limits<float>::infinity();
+                __tmax[i] = active ? $1[i].__tmax : -std::numeric_limits<float>::infinity();
+            }
+        }
+    };
+
+    // the first vertex and the edges to the other two, one stream per component; every stream ends in
+    // a packet's worth of zero triangles so kernels can load whole packs past the last triangle
+    export struct triangle_soa {
+        static constexpr size_t padding = ray_packet::width;
+
+        std::vector<float> __streams[9];
+        size_t __count = 0;
+
+        triangle_soa() = default;
+        // three vertices per triangle
+        explicit triangle_soa(std::span<vec_t<float, 3> const> $1) {
+            assign($1.size() / 3, [&](size_t t, size_t k) { return $1[t * 3 + k]; });
+        }
+        // three vertex indices per triangle
+        triangle_soa(std::span<vec_t<float, 3> const> $1, std::span<uint32_t const> $2) {
+            assign($2.size() / 3, [&](size_t t, size_t k) { return $1[$2[t * 3 + k]]; });
+        }
+
+        inline auto size() const -> size_t {
+            return __count;
+        }
+
+        // $2(t, k) is corner k of triangle t
+        template<typename Fn>
+        inline void assign(size_t $1, Fn const& $2) {
+            __count = $1;
+            for (std::vector<float>& stream : __streams) {
+                stream.assign($1 + padding, 0.0f);
+            }
+            for (size_t t = 0; t < $1; t += 1) {
+                vec_t<float, 3> v0 = $2(t, 0);
+                vec_t<float, 3> e1 = $2(t, 1) - v0;
+                vec_t<float, 3> e2 = $2(t, 2) - v0;
+                for (size_t a = 0; a < 3; a += 1) {
+                    __streams[a][t] = v0[a];
+                    __streams[3 + a][t] = e1[a];
+                    __streams[6 + a][t] = e2[a];
+                }
+            }
+        }
+    };
+
+    // packs never exceed the packet, so a packet is one or more whole packs
+    struct ray_impl {
+        using Pack = simd<float, (simd_width<float> < ray_packet::width ? simd_width<float> : ray_packet::width)>;
+
+        static constexpr size_t width = Pack::width;
+
+        inline static auto dot(Pack const* $1, Pack const* $2) -> Pack {
+            return Pack::madd($1[0], $2[0], Pack::madd($1[1], $2[1], $1[2] * $2[2]));
+        }
+        inline static void cross(Pack const* $1, Pack const* $2, Pack* $3) {
+            $3[0] = $1[1] * $2[2] - $1[2] * $2[1];
+            $3[1] = $1[2] * $2[0] - $1[0] * $2[2];
+            $3[2] = $1[0] * $2[1] - $1[1] * $2[0];
+        }
+
+        // lane-wise ray/triangle pairs: origin $1, direction $2, first vertex $3, edges $4 and $5, with the
+        // barycentrics in $7 and $8. Returns t, or +inf where the ray misses or t is not above $6; every test is an ordered
+        // compare that keeps t, so the NaNs of degenerate triangles and empty lanes count as misses
+        inline static auto moller_trumbore(Pack const* $1, Pack const* $2, Pack const* $3, Pack const* $4, Pack const* $5, Pack $6, Pack& $7, Pack& $8) -> Pack {
+            Pack p[3];
+            cross($2, $5, p);
+            Pack inv = Pack::broadcast(1.0f) / dot($4, p);
+            Pack s[3] = {$1[0] - $3[0], $1[1] - $3[1], $1[2] - $3[2]};
+            Pack q[3];
+            cross(s, $4, q);
+            $7 = dot(s, p) * inv;
+            $8 = dot($2, q) * inv;
+            Pack t = dot($5, q) * inv;
+
+            Pack inf = Pack::broadcast(std::numeric_limits<float>::infinity());
+            // slightly below zero, so both triangles that share an edge report a hit on it
+            Pack edge = Pack::broadcast(-std::numeric_limits<float>::epsilon());
+            t = Pack::select(Pack::gt($7, edge), t, inf);
+            t = Pack::select(Pack::gt($8, edge), t, inf);
+            t = Pack::select(Pack::gt(Pack::broadcast(1.0f) - $7 - $8, edge), t, inf);
+            return Pack::select(Pack::gt(t, $6), t, inf);
+        }
+
+        // lanes of $1 whose [tmin, $4] overlaps the box [$2, $3]. min/max return their second operand
+        // when the first is NaN, so a ray lying in a slab plane keeps its running interval
+        inline static auto slab(ray_packet const& $1, float const* $2, float const* $3, float const* $4) -> uint32_t {
+            uint32_t mask = 0;
+            for (size_t k = 0; k < ray_packet::width; k += width) {
+                Pack near = Pack::load($1.__tmin + k);
+                Pack far = Pack::load($4 + k);
+                for (size_t a = 0; a < 3; a += 1) {
+                    Pack origin = Pack::load($1.__origin[a] + k);
+                    Pack inverse = Pack::load($1.__inverse[a] + k);
+                    Pack t0 = (Pack::broadcast($2[a]) - origin) * inverse;
+                    Pack t1 = (Pack::broadcast($3[a]) - origin) * inverse;
+                    near = Pack::max(Pack::min(t0, t1), near);
+                    far = Pack::min(Pack::max(t0, t1), far);
+                }
+                mask |= (~Pack::movemask(Pack::gt(near, far)) & ((uint32_t(1) << width) - 1)) << k;
+            }
+            return mask;
+        }
+        // entry distance of one ray into the box [$5, $6], or +inf when it misses within [$3, $4]
+        inline static auto slab(float const* $1, float const* $2, float $3, float $4, float const* $5, float const* $6) -> float {
+            for (size_t a = 0; a < 3; a += 1) {
+                float t0 = ($5[a] - $1[a]) * $2[a];
+                float t1 = ($6[a] - $1[a]) * $2[a];
+                $3 = std::max(std::min(t0, t1), $3);
+                $4 = std::min(std::max(t0, t1), $4);
+            }
+            return $3 <= $4 ? $3 : std::numeric_limits<float>::infinity();
+        }
+        // entry distances of one ray into four boxes stored component-major, +inf for the boxes it misses
+        inline static void slab(float const* $1, float const* $2, float $3, float $4, float const (&$5)[3][4], float const (&$6)[3][4], float* $7) {
+            using Quad = simd<float, (simd_width<float> >= 4 ? 4 : 1)>;
+
+            for (size_t k = 0; k < 4; k += Quad::width) {
+                Quad near = Quad::broadcast($3);
+                Quad far = Quad::broadcast($4);
+                for (size_t a = 0; a < 3; a += 1) {
+                    Quad origin = Quad::broadcast($1[a]);
+                    Quad inverse = Quad::broadcast($2[a]);
+                    Quad t0 = (Quad::load($5[a] + k) - origin) * inverse;
+                    Quad t1 = (Quad::load($6[a] + k) - origin) * inverse;
+                    near = Quad::max(Quad::min(t0, t1), near);
+                    far = Quad::min(Quad::max(t0, t1), far);
+                }
+                Quad::select(Quad::gt(near, far), Quad::broadcast(std::numeric_limits<float>::infinity()), near).store($7 + k);
+            }
+        }
+
+        // $1 against triangles [$3, $3 + $4) of $2, a pack of triangles per step; $5 maps a triangle
+        // to the primitive reported in $6, or is null for the triangle index itself
+        inline static void triangles(ray const& $1, triangle_soa const& $2, size_t $3, size_t $4, uint32_t const* $5, ray_hit& $6) {
+            static constexpr float lanes[ray_packet::width] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+
+            Pack o[3];
+            Pack d[3];
+            for (size_t a = 0; a < 3; a += 1) {
+                o[a] = Pack::broadcast($1.__origin[a]);
+                d[a] = Pack::broadcast($1.__direction[a]);
+            }
+            Pack tmin = Pack::broadcast($1.__tmin);
+            Pack inf = Pack::broadcast(std::numeric_limits<float>::infinity());
+            for (size_t i = $3; i < $3 + $4; i += width) {
+                Pack v0[3];
+                Pack e1[3];
+                Pack e2[3];
+                for (size_t a = 0; a < 3; a += 1) {
+                    v0[a] = Pack::load($2.__streams[a].data() + i);
+                    e1[a] = Pack::load($2.__streams[3 + a].data() + i);
+                    e2[a] = Pack::load($2.__streams[6 + a].data() + i);
+                }
+                Pack u;
+                Pack v;
+                Pack t = moller_trumbore(o, d, v0, e1, e2, tmin, u, v);
+                t = Pack::select(Pack::lt(Pack::load(lanes), Pack::broadcast(float($3 + $4 - i))), t, inf);
+                if (Pack::movemask(Pack::lt(t, Pack::broadcast($6.__t))) == 0) {
+                    continue;
+                }
+                float ts[width];
+                float us[width];
+                float vs[width];
+                t.store(ts);
+                u.store(us);
+                v.store(vs);
+                for (size_t k = 0; k < width; k += 1) {
+                    if (ts[k] < $6.__t) {
+                        $6 = ray_hit{ts[k], us[k], vs[k], $5 != nullptr ? $5[i + k] : uint32_t(i + k)};
+                    }
+                }
+            }
+        }
+
+        // every lane of $1 against triangle $3 of $2, keeping the closer hit per lane in $5..$8;
+        // $8 holds primitive indices as float bit patterns so that a select can move them
+        inline static void triangle(ray_packet const& $1, triangle_soa const& $2, size_t $3, uint32_t $4, float* $5, float* $6, float* $7, float* $8) {
+            Pack v0[3];
+            Pack e1[3];
+            Pack e2[3];
+            for (size_t a = 0; a < 3; a += 1) {
+                v0[a] = Pack::broadcast($2.__streams[a][$3]);
+                e1[a] = Pack::broadcast($2.__streams[3 + a][$3]);
+                e2[a] = Pack::broadcast($2.__streams[6 + a][$3]);
+            }
+            Pack primitive = Pack::broadcast(std::bit_cast<float>($4));
+            for (size_t k = 0; k < ray_packet::width; k += width) {
+                Pack o[3];
+                Pack d[3];
+                for (size_t a = 0; a < 3; a += 1) {
+                    o[a] = Pack::load($1.__origin[a] + k);
+                    d[a] = Pack::load($1.__direction[a] + k);
+                }
+                Pack u;
+                Pack v;
+                Pack t = moller_trumbore(o, d, v0, e1, e2, Pack::load($1.__tmin + k), u, v);
+                Pack best = Pack::load($5 + k);
+                auto closer = Pack::lt(t, best);
+                if (Pack::movemask(closer) == 0) {
+                    continue;
+                }
+                Pack::select(closer, t, best).store($5 + k);
+                Pack::select(closer, u, Pack::load($6 + k)).store($6 + k);
+                Pack::select(closer, v, Pack::load($7 + k)).store($7 + k);
+                Pack::select(closer, primitive, Pack::load($8 + k)).store($8 + k);
+            }
+        }
+    };
+
+    // one bit per lane of $1 whose [tmin, tmax] overlaps $2
+    export inline auto intersect(ray_packet const& $1, bounds_t<float, 3> const& $2) -> uint32_t {
+        return ray_impl::slab($1, $2.__min.__fields, $2.__max.__fields, $1.__tmax);
+    }
+    // entry distance into $2, or +inf when $1 misses it within [tmin, tmax]
+    export inline auto intersect(ray const& $1, bounds_t<float, 3> const& $2) -> float {
+        float inverse[3] = {1.0f / $1.__direction[0], 1.0f / $1.__direction[1], 1.0f / $1.__direction[2]};
+        return ray_impl::slab($1.__origin.__fields, inverse, $1.__tmin, $1.__tmax, $2.__min.__fields, $2.__max.__fields);
+    }
+    // closest triangle of $2 hit by $1, with __t = tmax on a miss
+    export inline auto intersect(ray const& $1, triangle_soa const& $2) -> ray_hit {
+        ray_hit hit;
+        hit.__t = $1.__tmax;
+        ray_impl::triangles($1, $2, 0, $2.size(), nullptr, hit);
+        return hit;
+    }
+
+    // four children per node, component-major so that one ray tests all four boxes at once; a node is
+    // two cache lines and its inner children follow it depth-first. Empty slots have a box at +inf and
+    // point at the root, which is nobody's child
+    export struct alignas(64) bvh_node {
+        float __min[3][4];
+        float __max[3][4];
+        // node index of an inner child, first triangle of a leaf
+        uint32_t __offset[4];
+        // triangles of a leaf, 0 for inner children and empty slots
+        uint16_t __count[4];
+    };
+
+    struct bvh_builder {
+        static constexpr size_t bins = 16;
+        static constexpr size_t leaf_size = ray_packet::width;
+        // a leaf is tested a pack of triangles at a time, so one triangle costs a fraction of a box test
+        static constexpr float triangle_cost = 0.25f;
+        // smaller subtrees are built by the thread that reaches them
+        static constexpr size_t parallel_size = 16 * 1024;
+        // deeper nodes split at the median, which caps the depth at 64 for up to 2^32 triangles
+        static constexpr size_t median_depth = 32;
+
+        // the binary SAH tree, collapsed into bvh_node once built; the left child follows its parent
+        struct binary {
+            bounds_t<float, 3> box;
+            // right child of an inner node, first triangle of a leaf
+            uint32_t offset;
+            // 0 for inner nodes
+            uint32_t count;
+        };
+
+        std::span<bounds_t<float, 3> const> __boxes;
+        std::span<vec_t<float, 3> const> __centers;
+        std::span<uint32_t> __order;
+        parallel::thread_pool& __pool;
+
+        inline static auto empty() -> bounds_t<float, 3> {
+            return bounds_t<float, 3>{vec3(std::numeric_limits<float>::infinity()), vec3(-std::numeric_limits<float>::infinity())};
+        }
+        inline static void grow(bounds_t<float, 3>& $1, bounds_t<float, 3> const& $2) {
+            $1.__min = min($1.__min, $2.__min);
+            $1.__max = max($1.__max, $2.__max);
+        }
+        inline static auto area(bounds_t<float, 3> const& $1) -> float {
+            vec_t<float, 3> d = $1.__max - $1.__min;
+            return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+        }
+        inline static auto bin(float $1, float $2, float $3) -> size_t {
+            return std::min(bins - 1, size_t(($1 - $2) * $3));
+        }
+        // copies a subtree built on its own to $3[$2...], moving its child links along
+        inline static void append(std::vector<binary> const& $1, uint32_t $2, std::vector<binary>& $3) {
+            for (binary node : $1) {
+                if (node.count == 0) {
+                    node.offset += $2;
+                }
+                $3.push_back(node);
+            }
+        }
+
+        // appends the subtree over __order[$1, $2) at depth $3 to $4, root first
+        inline void build(size_t $1, size_t $2, size_t $3, std::vector<binary>& $4) const {
+            bounds_t<float, 3> box = empty();
+            bounds_t<float, 3> centers = empty();
+            for (size_t i = $1; i < $2; i += 1) {
+                grow(box, __boxes[__order[i]]);
+                centers.__min = min(centers.__min, __centers[__order[i]]);
+                centers.__max = max(centers.__max, __centers[__order[i]]);
+            }
+            size_t at = $4.size();
+            $4.push_back(binary{box, 0, 0});
+
+            // SAH with unit traversal cost; every cost is an area times a triangle count
+            size_t count = $2 - $1;
+            float best = std::numeric_limits<float>::infinity();
+            size_t axis = 3;
+            size_t split = 0;
+            for (size_t a = 0; a < 3; a += 1) {
+                float extent = centers.__max[a] - centers.__min[a];
+                if (!(extent > 0.0f)) {
+                    continue;
+                }
+                float scale = float(bins) / extent;
+                size_t counts[bins] = {};
+                bounds_t<float, 3> boxes[bins];
+                for (bounds_t<float, 3>& b : boxes) {
+                    b = empty();
+                }
+                for (size_t i = $1; i < $2; i += 1) {
+                    size_t b = bin(__centers[__order[i]][a], centers.__min[a], scale);
+                    counts[b] += 1;
+                    grow(boxes[b], __boxes[__order[i]]);
+                }
+
+                float right_area[bins];
+                size_t right_count[bins];
+                bounds_t<float, 3> sweep = empty();
+                size_t n = 0;
+                for (size_t b = bins - 1; b > 0; b -= 1) {
+                    grow(sweep, boxes[b]);
+                    n += counts[b];
+                    right_area[b] = n != 0 ? area(sweep) : 0.0f;
+                    right_count[b] = n;
+                }
+                sweep = empty();
+                n = 0;
+                for (size_t b = 0; b + 1 < bins; b += 1) {
+                    grow(sweep, boxes[b]);
+                    n += counts[b];
+                    if (n == 0 || right_count[b + 1] == 0) {
+                        continue;
+                    }
+                    float cost = float(n) * area(sweep) + float(right_count[b + 1]) * right_area[b + 1];
+                    if (cost < best) {
+                        best = cost;
+                        axis = a;
+                        split = b;
+                    }
+                }
+            }
+
+            if (count <= leaf_size && (axis == 3 || triangle_cost * float(count) * area(box) <= area(box) + triangle_cost * best)) {
+                $4[at].offset = uint32_t($1);
+                $4[at].count = uint32_t(count);
+                return;
+            }
+
+            size_t mid;
+            if (axis < 3 && $3 < median_depth) {
+                float lo = centers.__min[axis];
+                float scale = float(bins) / (centers.__max[axis] - lo);
+                uint32_t* middle = std::partition(__order.data() + $1, __order.data() + $2, [&](uint32_t i) {
+                    return bin(__centers[i][axis], lo, scale) <= split;
+                });
+                mid = size_t(middle - __order.data());
+            } else {
+                // coincident centers, or too deep: halve along the widest axis
+                vec_t<float, 3> extent = centers.__max - centers.__min;
+                axis = extent[1] > extent[0] ? 1 : 0;
+                axis = extent[2] > extent[axis] ? 2 : axis;
+                mid = ($1 + $2) / 2;
+                std::nth_element(__order.data() + $1, __order.data() + mid, __order.data() + $2, [&](uint32_t i, uint32_t j) {
+                    return __centers[i][axis] < __centers[j][axis];
+                });
+            }
+
+            if (count >= parallel_size) {
+                std::vector<binary> halves[2];
+                __pool.run(2, [&](size_t i) {
+                    build(i == 0 ? $1 : mid, i == 0 ? mid : $2, $3 + 1, halves[i]);
+                });
+                append(halves[0], uint32_t($4.size()), $4);
+                $4[at].offset = uint32_t($4.size());
+                append(halves[1], uint32_t($4.size()), $4);
+            } else {
+                build($1, mid, $3 + 1, $4);
+                $4[at].offset = uint32_t($4.size());
+                build(mid, $2, $3 + 1, $4);
+            }
+        }
+
+        // appends the node for binary node $2 and its subtree to $3 and returns its index: the children
+        // of $2 are opened, largest surface first, until there are four or only leaves remain
+        inline static auto collapse(std::vector<binary> const& $1, uint32_t $2, std::vector<bvh_node>& $3) -> uint32_t {
+            uint32_t children[4] = {$2};
+            size_t count = 1;
+            if ($1[$2].count == 0) {
+                children[0] = $2 + 1;
+                children[1] = $1[$2].offset;
+                count = 2;
+            }
+            while (count < 4) {
+                size_t open = 4;
+                float largest = -1.0f;
+                for (size_t i = 0; i < count; i += 1) {
+                    if ($1[children[i]].count == 0 && area($1[children[i]].box) > largest) {
+                        open = i;
+                        largest = area($1[children[i]].box);
+                    }
+                }
+                if (open == 4) {
+                    break;
+                }
+                uint32_t inner = children[open];
+                children[open] = inner + 1;
+                children[count++] = $1[inner].offset;
+            }
+
+            uint32_t at = uint32_t($3.size());
+            bvh_node node{};
+            for (size_t c = 0; c < 4; c += 1) {
+                for (size_t a = 0; a < 3; a += 1) {
+                    node.__min[a][c] = c < count ? $1[children[c]].box.__min[a] : std::numeric_limits<float>::infinity();
+                    node.__max[a][c] = c < count ? $1[children[c]].box.__max[a] : std::numeric_limits<float>::infinity();
+                }
+                if (c < count && $1[children[c]].count != 0) {
+                    node.__offset[c] = $1[children[c]].offset;
+                    node.__count[c] = uint16_t($1[children[c]].count);
+                }
+            }
+            $3.push_back(node);
+            for (size_t c = 0; c < count; c += 1) {
+                if ($1[children[c]].count == 0) {
+                    uint32_t child = collapse($1, children[c], $3);
+                    $3[at].__offset[c] = child;
+                }
+            }
+            return at;
+        }
+    };
+
+    // leaves hold at most eight triangles, copied into leaf order so a leaf is one or two pack loads.
+    // The tree is identical for any pool size
+    export struct bvh {
+        std::vector<bvh_node> __nodes;
+        // input index of every triangle in __triangles
+        std::vector<uint32_t> __indices;
+        triangle_soa __triangles;
+
+        bvh() = default;
+        // three vertices per triangle
+        explicit bvh(std::span<vec_t<float, 3> const> $1, parallel::thread_pool& $2 = parallel::thread_pool::global()) {
+            build($1, $1.size() / 3, [&](size_t t, size_t k) { return uint32_t(t * 3 + k); }, $2);
+        }
+        // three vertex indices per triangle
+        bvh(std::span<vec_t<float, 3> const> $1, std::span<uint32_t const> $2, parallel::thread_pool& $3 = parallel::thread_pool::global()) {
+            build($1, $2.size() / 3, [&](size_t t, size_t k) { return $2[t * 3 + k]; }, $3);
+        }
+
+        // closest hit of $1, with __t = tmax on a miss
+        inline auto intersect(ray const& $1) const -> ray_hit {
+            ray_hit hit;
+            hit.__t = $1.__tmax;
+            if (__nodes.empty()) {
+                return hit;
+            }
+            float inverse[3] = {1.0f / $1.__direction[0], 1.0f / $1.__direction[1], 1.0f / $1.__direction[2]};
+            trace($1, inverse, entry{$1.__tmin, 0, 0, 1}, hit);
+            return hit;
+        }
+
+        // one traversal for all lanes of $1, children ordered by the first lane that reaches them; pays off
+        // for coherent rays such as camera or picking rays, while incoherent rays do better one at a time
+        inline void intersect(ray_packet const& $1, std::span<ray_hit, ray_packet::width> $2) const {
+            alignas(32) float t[ray_packet::width];
+            alignas(32) float u[ray_packet::width] = {};
+            alignas(32) float v[ray_packet::width] = {};
+            alignas(32) float primitive[ray_packet::width];
+            for (size_t i = 0; i < ray_packet::width; i += 1) {
+                t[i] = $1.__tmax[i];
+                primitive[i] = std::bit_cast<float>(ray_hit::miss);
+            }
+
+            entry stack[3 * 64 + 1];
+            size_t depth = 0;
+            if (!__nodes.empty()) {
+                stack[depth++] = entry{0.0f, 0, 0, (uint32_t(1) << ray_packet::width) - 1};
+            }
+            while (depth != 0) {
+                entry e = stack[--depth];
+                // the lanes go on one by one below a node that only a single lane reached, and through
+                // leaves that take fewer of their triangle packs than a packet test per triangle
+                size_t lanes = size_t(std::popcount(e.lanes));
+                if (lanes == 1 || (e.count != 0 && lanes * ((e.count + ray_impl::width - 1) / ray_impl::width) < e.count)) {
+                    for (uint32_t m = e.lanes; m != 0; m &= m - 1) {
+                        size_t l = size_t(std::countr_zero(m));
+                        ray r{{$1.__origin[0][l], $1.__origin[1][l], $1.__origin[2][l]}, {$1.__direction[0][l], $1.__direction[1][l], $1.__direction[2][l]}, $1.__tmin[l], t[l]};
+                        float inverse[3] = {$1.__inverse[0][l], $1.__inverse[1][l], $1.__inverse[2][l]};
+                        ray_hit hit{t[l], u[l], v[l], std::bit_cast<uint32_t>(primitive[l])};
+                        trace(r, inverse, entry{r.__tmin, e.offset, e.count, 1}, hit);
+                        t[l] = hit.__t;
+                        u[l] = hit.__u;
+                        v[l] = hit.__v;
+                        primitive[l] = std::bit_cast<float>(hit.__primitive);
+                    }
+                    continue;
+                }
+                if (e.count != 0) {
+                    for (size_t i = e.offset; i < e.offset + e.count; i += 1) {
+                        ray_impl::triangle($1, __triangles, i, __indices[i], t, u, v, primitive);
+                    }
+                    continue;
+                }
+                bvh_node const& node = __nodes[e.offset];
+                uint32_t masks[4];
+                uint32_t any = 0;
+                for (size_t c = 0; c < 4; c += 1) {
+                    // a box at +inf still passes the slab test of lanes with tmax = +inf
+                    if (node.__offset[c] == 0 && node.__count[c] == 0) {
+                        masks[c] = 0;
+                        continue;
+                    }
+                    float lo[3] = {node.__min[0][c], node.__min[1][c], node.__min[2][c]};
+                    float hi[3] = {node.__max[0][c], node.__max[1][c], node.__max[2][c]};
+                    masks[c] = ray_impl::slab($1, lo, hi, t);
+                    any |= masks[c];
+                }
+                if (any == 0) {
+                    continue;
+                }
+                // distances along the first lane that hits a child; the children only other lanes hit come last
+                size_t lane = size_t(std::countr_zero(any));
+                float origin[3] = {$1.__origin[0][lane], $1.__origin[1][lane], $1.__origin[2][lane]};
+                float inverse[3] = {$1.__inverse[0][lane], $1.__inverse[1][lane], $1.__inverse[2][lane]};
+                float near[4];
+                ray_impl::slab(origin, inverse, $1.__tmin[lane], t[lane], node.__min, node.__max, near);
+                for (size_t c = 0; c < 4; c += 1) {
+                    if (masks[c] == 0) {
+                        near[c] = std::numeric_limits<float>::infinity();
+                    } else if (!(near[c] < std::numeric_limits<float>::infinity())) {
+                        near[c] = std::numeric_limits<float>::max();
+                    }
+                }
+                push(node, near, masks, stack, depth);
+            }
+            for (size_t i = 0; i < ray_packet::width; i += 1) {
+                $2[i] = ray_hit{t[i], u[i], v[i], std::bit_cast<uint32_t>(primitive[i])};
+            }
+        }
+        // $2[i] = intersect($1[i]), traced in packets of eight consecutive rays
+        inline void intersect(std::span<ray const> $1, std::span<ray_hit> $2) const {
+            for (size_t i = 0; i < $1.size(); i += ray_packet::width) {
+                size_t count = std::min(ray_packet::width, $1.size() - i);
+                ray_hit hits[ray_packet::width];
+                intersect(ray_packet($1.subspan(i, count)), std::span<ray_hit, ray_packet::width>(hits));
+                std::copy(hits, hits + count, $2.begin() + i);
+            }
+        }
+
+        // a node or leaf waiting on the traversal stack; count is 0 for nodes, lanes are the packet rays that reached it
+        struct entry {
+            float near;
+            uint32_t offset;
+            uint32_t count;
+            uint32_t lanes;
+        };
+
+        static constexpr uint32_t ones[4] = {1, 1, 1, 1};
+
+        // closest hit of $1 with inverse direction $2 in the subtree of $3, nearer than $4
+        inline void trace(ray const& $1, float const* $2, entry $3, ray_hit& $4) const {
+            // children still to visit with their entry distance; at most three wait per level
+            entry stack[3 * 64 + 1];
+            size_t depth = 0;
+            stack[depth++] = $3;
+            while (depth != 0) {
+                entry e = stack[--depth];
+                if (e.near > $4.__t) {
+                    continue;
+                }
+                if (e.count != 0) {
+                    ray_impl::triangles($1, __triangles, e.offset, e.count, __indices.data(), $4);
+                    continue;
+                }
+                bvh_node const& node = __nodes[e.offset];
+                float near[4];
+                ray_impl::slab($1.__origin.__fields, $2, $1.__tmin, $4.__t, node.__min, node.__max, near);
+                push(node, near, ones, stack, depth);
+            }
+        }
+
+        // pushes the children of $1 with a finite distance in $2 and their lanes $3, farthest first so the nearest pops next
+        inline static void push(bvh_node const& $1, float const* $2, uint32_t const* $3, entry* $4, size_t& $5) {
+            uint32_t order[4];
+            size_t count = 0;
+            for (uint32_t c = 0; c < 4; c += 1) {
+                if ($2[c] < std::numeric_limits<float>::infinity()) {
+                    size_t i = count++;
+                    for (; i > 0 && $2[order[i - 1]] < $2[c]; i -= 1) {
+                        order[i] = order[i - 1];
+                    }
+                    order[i] = c;
+                }
+            }
+            for (size_t i = 0; i < count; i += 1) {
+                $4[$5++] = entry{$2[order[i]], $1.__offset[order[i]], $1.__count[order[i]], $3[order[i]]};
+            }
+        }
+
+        // $3(t, k) is the vertex index of corner k of triangle t
+        template<typename Fn>
+        inline void build(std::span<vec_t<float, 3> const> $1, size_t $2, Fn const& $3, parallel::thread_pool& $4) {
+            std::vector<bounds_t<float, 3>> boxes($2);
+            std::vector<vec_t<float, 3>> centers($2);
+            parallel::for_each_chunk(std::span<bounds_t<float, 3>>(boxes), [&](std::span<bounds_t<float, 3>> chunk, size_t offset) {
+                for (size_t i = 0; i < chunk.size(); i += 1) {
+                    vec_t<float, 3> a = $1[$3(offset + i, 0)];
+                    vec_t<float, 3> b = $1[$3(offset + i, 1)];
+                    vec_t<float, 3> c = $1[$3(offset + i, 2)];
+                    chunk[i] = bounds_t<float, 3>{min(min(a, b), c), max(max(a, b), c)};
+                    centers[offset + i] = (chunk[i].__min + chunk[i].__max) * 0.5f;
+                }
+            }, $4);
+
+            __indices.resize($2);
+            for (size_t i = 0; i < $2; i += 1) {
+                __indices[i] = uint32_t(i);
+            }
+            __nodes.clear();
+            if ($2 != 0) {
+                std::vector<bvh_builder::binary> tree;
+                tree.reserve($2 / 2);
+                bvh_builder{boxes, centers, __indices, $4}.build(0, $2, 0, tree);
+                __nodes.reserve(tree.size() / 3 + 1);
+                bvh_builder::collapse(tree, 0, __nodes);
+            }
+
+            std::vector<uint32_t> corners($2 * 3);
+            for (size_t t = 0; t < $2; t += 1) {
+                for (size_t k = 0; k < 3; k += 1) {
+                    corners[t * 3 + k] = $3(__indices[t], k);
+                }
+            }
+            __triangles = triangle_soa($1, corners);
+        }
+    };
+
+    // world matrices of a transform tree, stored breadth first: every depth is one contiguous level
+    // and the children of a node sit together in the next level, in the order of their parents.
+    // update() walks the levels top down and recomputes only nodes whose local matrix changed or
+    // whose parent was recomputed, splitting wide levels over the pool
+    export template<std::floating_point T>
+    struct transform_hierarchy {
+        using Mat = mat_t<T, 4, 4>;
+
+        static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+        std::vector<Mat> __local;
+        std::vector<Mat> __world;
+        // all in slot order; a node's slot changes when the tree is resorted, its handle never does
+        std::vector<uint32_t> __parent;
+        std::vector<uint32_t> __depth;
+        std::vector<uint32_t> __handles;
+        std::vector<uint8_t> __dirty;
+        std::vector<uint32_t> __slots;
+        // first slot of every level, plus the end
+        std::vector<uint32_t> __levels;
+        // dirty nodes per level
+        std::vector<uint32_t> __pending;
+        // nodes added since the last sort sit unsorted at the end
+        bool __sorted = true;
+
+        inline auto size() const -> size_t {
+            return __local.size();
+        }
+
+        // a node under the node with handle $2, or a root; returns its handle. Parents come before their children
+        inline auto add(Mat const& $1, uint32_t $2 = none) -> uint32_t {
+            uint32_t handle = uint32_t(__slots.size());
+            uint32_t parent = $2 == none ? none : __slots[$2];
+            uint32_t depth = parent == none ? 0 : __depth[parent] + 1;
+            __slots.push_back(uint32_t(__local.size()));
+            __local.push_back($1);
+            __world.push_back($1);
+            __parent.push_back(parent);
+            __depth.push_back(depth);
+            __handles.push_back(handle);
+            __dirty.push_back(1);
+            if (__pending.size() <= depth) {
+                __pending.resize(depth + 1);
+            }
+            __pending[depth] += 1;
+            __sorted = false;
+            return handle;
+        }
+
+        inline auto local(uint32_t $1) const -> Mat const& {
+            return __local[__slots[$1]];
+        }
+        // as of the last update()
+        inline auto world(uint32_t $1) const -> Mat const& {
+            return __world[__slots[$1]];
+        }
+        inline void set_local(uint32_t $1, Mat const& $2) {
+            uint32_t slot = __slots[$1];
+            __local[slot] = $2;
+            if (__dirty[slot] == 0) {
+                __dirty[slot] = 1;
+                __pending[__depth[slot]] += 1;
+            }
+        }
+
+        // brings every world matrix up to date and returns how many were recomputed
+        inline auto update(parallel::thread_pool& $1 = parallel::thread_pool::global()) -> size_t {
+            if (!__sorted) {
+                sort();
+            }
+            size_t total = 0;
+            size_t changed = 0;
+            size_t first = __levels.size();
+            size_t last = 0;
+            for (size_t d = 0; d + 1 < __levels.size(); d += 1) {
+                // a clean level under a clean level stays clean
+                if (__pending[d] == 0 && changed == 0) {
+                    continue;
+                }
+                first = std::min(first, d);
+                last = d + 1;
+                std::atomic<size_t> count = 0;
+                std::span<Mat> level = std::span<Mat>(__world).subspan(__levels[d], __levels[d + 1] - __levels[d]);
+                parallel::for_each_chunk(level, [&](std::span<Mat> chunk, size_t offset) {
+                    count.fetch_add(propagate(__levels[d] + offset, __levels[d] + offset + chunk.size()), std::memory_order_relaxed);
+                }, $1);
+                changed = count.load(std::memory_order_relaxed);
+                total += changed;
+                __pending[d] = 0;
+            }
+            // flags of the recomputed nodes marked their children; none are needed past this point
+            if (first < last) {
+                std::fill(__dirty.begin() + __levels[first], __dirty.begin() + __levels[last], uint8_t(0));
+            }
+            return total;
+        }
+
+        // recomputes the dirty nodes in slots [$1, $2) and those under a recomputed parent, marking them dirty
+        // for the next level; returns their count
+        inline auto propagate(size_t $1, size_t $2) -> size_t {
+            size_t count = 0;
+            for (size_t i = $1; i < $2; i += 1) {
+                uint32_t parent = __parent[i];
+                if (__dirty[i] == 0 && (parent == none || __dirty[parent] == 0)) {
+                    continue;
+                }
+                __world[i] = parent == none ? __local[i] : mat_impl<T, 4, 4>::mul(__world[parent], __local[i]);
+                __dirty[i] = 1;
+                count += 1;
+            }
+            return count;
+        }
+
+        // level by level: nodes by depth, then each level by the slot of their parents
+        inline void sort() {
+            size_t n = __local.size();
+            std::vector<uint32_t> order(n);
+            for (size_t i = 0; i < n; i += 1) {
+                order[i] = uint32_t(i);
+            }
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return __depth[a] < __depth[b];
+            });
+            std::vector<uint32_t> slot(n);
+            __levels.clear();
+            for (size_t begin = 0; begin < n;) {
+                size_t end = begin;
+                while (end < n && __depth[order[end]] == __depth[order[begin]]) {
+                    end += 1;
+                }
+                if (__depth[order[begin]] != 0) {
+                    std::stable_sort(order.begin() + begin, order.begin() + end, [&](uint32_t a, uint32_t b) {
+                        return slot[__parent[a]] < slot[__parent[b]];
+                    });
+                }
+                for (size_t k = begin; k < end; k += 1) {
+                    slot[order[k]] = uint32_t(k);
+                }
+                __levels.push_back(uint32_t(begin));
+                begin = end;
+            }
+            __levels.push_back(uint32_t(n));
+
+            permute(__local, order);
+            permute(__world, order);
+            permute(__depth, order);
+            permute(__handles, order);
+            permute(__dirty, order);
+            permute(__parent, order);
+            for (size_t k = 0; k < n; k += 1) {
+                __parent[k] = __parent[k] == none ? none : slot[__parent[k]];
+                __slots[__handles[k]] = uint32_t(k);
+            }
+            __sorted = true;
+        }
+        template<typename E>
+        inline static void permute(std::vector<E>& $1, std::vector<uint32_t> const& $2) {
+            std::vector<E> out($1.size());
+            for (size_t k = 0; k < $2.size(); k += 1) {
+                out[k] = $1[$2[k]];
+            }
+            $1 = std::move(out);
+        }
+    };
+
+    // runtime ISA selection for the f32 batch kernels. The module fills the baseline table; CMake builds
+    // src/Mathematics_kernels.cxx once per level with -march=x86-64-v2/v3/v4, each object holding a private
+    // copy of this library and exporting only its table. MATHEMATICS_DISPATCH_LEVELS tells the module the
+    // highest level that was built
+    namespace dispatch {
+        // declared in Mathematics_dispatch.h, outside the module, and named here so the kernel objects' copy finds them too
+        export using ::math::dispatch::level;
+        using ::math::dispatch::kernels;
+        using ::math::dispatch::table;
+
+#if defined(MATHEMATICS_DISPATCH_LEVELS)
+        inline constexpr level built = level(MATHEMATICS_DISPATCH_LEVELS);
+#else
+        inline constexpr level built = level::baseline;
+#endif
+
+        // the kernels of one table, at the ISA the library is compiled for
+        struct kernels_impl {
+            template<size_t Len>
+            inline static auto in(float const* $1, size_t $2) -> std::span<vec_t<float, Len> const> {
+                return {reinterpret_cast<vec_t<float, Len> const*>($1), $2};
+            }
+            template<size_t Len>
+            inline static auto out(float* $1, size_t $2) -> std::span<vec_t<float, Len>> {
+                return {reinterpret_cast<vec_t<float, Len>*>($1), $2};
+            }
+            inline static auto quats(float const* $1, size_t $2) -> std::span<quat_t<float> const> {
+                return {reinterpret_cast<quat_t<float> const*>($1), $2};
+            }
+            inline static auto mat(float const* $1) -> mat_t<float, 4, 4> {
+                mat_t<float, 4, 4> m;
+                std::memcpy(&m, $1, sizeof(m));
+                return m;
+            }
+            inline static auto mode(bool $1) -> store_mode {
+                return $1 ? store_mode::streaming : store_mode::cached;
+            }
+
+            static void normalize3(float const* $1, float* $2, size_t $3) {
+                normalize_impl<float>::apply(in<3>($1, $3), out<3>($2, $3));
+            }
+            static void normalize4(float const* $1, float* $2, size_t $3) {
+                normalize_impl<float>::apply(in<4>($1, $3), out<4>($2, $3));
+            }
+            static void transform_points(float const* $1, float const* $2, float* $3, size_t $4, bool $5) {
+                transform_impl<float>::points(mat($1), in<3>($2, $4), out<3>($3, $4), mode($5));
+            }
+            static void transform_vectors(float const* $1, float const* $2, float* $3, size_t $4, bool $5) {
+                transform_impl<float>::vectors(mat($1), in<3>($2, $4), out<3>($3, $4), mode($5));
+            }
+            static void transform_homogeneous(float const* $1, float const* $2, float* $3, size_t $4, bool $5) {
+                transform_impl<float>::homogeneous(mat($1), in<4>($2, $4), out<4>($3, $4), mode($5));
+            }
+            static void rotate(float const* $1, float const* $2, float* $3, size_t $4) {
+                quat_impl<float>::rotate(quats($1, $4), in<3>($2, $4), out<3>($3, $4));
+            }
+            static void slerp(float const* $1, float const* $2, float $3, float* $4, size_t $5) {
+                quat_impl<float>::slerp(quats($1, $5), quats($2, $5), $3, {reinterpret_cast<quat_t<float>*>($4), $5});
+            }
+            static void sin(float const* $1, float* $2, size_t $3) {
+                fast_impl<float>::map({$1, $3}, {$2, $3}, []<typename P>(P $1) { return fast_impl<float>::sin($1); });
+            }
+            static void cos(float const* $1, float* $2, size_t $3) {
+                fast_impl<float>::map({$1, $3}, {$2, $3}, []<typename P>(P $1) { return fast_impl<float>::cos($1); });
+            }
+            static void exp2(float const* $1, float* $2, size_t $3) {
+                fast_impl<float>::map({$1, $3}, {$2, $3}, []<typename P>(P $1) { return fast_impl<float>::exp2($1); });
+            }
+            static void log2(float const* $1, float* $2, size_t $3) {
+                fast_impl<float>::map({$1, $3}, {$2, $3}, []<typename P>(P $1) { return fast_impl<float>::log2($1); });
+            }
+            static void sum3(float const* $1, size_t $2, bool $3, float* $4) {
+                vec_t<float, 3> r = $3 ? reduce_impl<float, 3>::kahan(in<3>($1, $2)) : reduce_impl<float, 3>::sum(in<3>($1, $2));
+                std::memcpy($4, r.__fields, sizeof(r));
+            }
+            static void bounds3(float const* $1, size_t $2, float* $3) {
+                bounds_t<float, 3> r = reduce_impl<float, 3>::bounds(in<3>($1, $2));
+                std::memcpy($3, r.__min.__fields, sizeof(r.__min));
+                std::memcpy($3 + 3, r.__max.__fields, sizeof(r.__max));
+            }
+
+            inline static constexpr auto table(level $1) -> kernels {
+                return kernels{
+                    $1,
+                    normalize3,
+                    normalize4,
+                    transform_points,
+                    transform_vectors,
+                    transform_homogeneous,
+                    rotate,
+                    slerp,
+                    sin,
+                    cos,
+                    exp2,
+                    log2,
+                    sum3,
+                    bounds3,
+                };
+            }
+        };
+
+#if !defined(MATHEMATICS_DISPATCH_LEVEL)
+        // the kernel objects define their own level's table instead
+        extern "C++" {
+            template<>
+            auto table<level::baseline>() -> kernels const& {
+                static constexpr kernels k = kernels_impl::table(level::baseline);
+                return k;
+            }
+        }
+#endif
+
+        inline auto xgetbv() -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+            uint32_t lo;
+            uint32_t hi;
+            __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            return (uint64_t(hi) << 32) | lo;
+#else
+            return 0;
+#endif
+        }
+
+        // the highest level both the CPU and the OS support; AVX state needs XCR0 bits 1-2, AVX-512 also bits 5-7
+        export inline auto detect() -> level {
+#if defined(__x86_64__) || defined(__i386__)
+            uint32_t a, b, c, d;
+            if (!__get_cpuid(1, &a, &b, &c, &d)) {
+                return level::baseline;
+            }
+            uint32_t c1 = c;
+            uint32_t b7 = __get_cpuid_count(7, 0, &a, &b, &c, &d) ? b : 0;
+            uint32_t c81 = __get_cpuid(0x80000001, &a, &b, &c, &d) ? c : 0;
+            auto bit = [](uint32_t $1, int $2) -> bool { return ($1 >> $2) & 1; };
+            bool v2 = bit(c1, 0) && bit(c1, 9) && bit(c1, 13) && bit(c1, 19) && bit(c1, 20) && bit(c1, 23) && bit(c81, 0);
+            if (!v2) {
+                return level::baseline;
+            }
+            uint64_t xcr0 = bit(c1, 27) ? xgetbv() : 0;
+            bool v3 = bit(c1, 12) && bit(c1, 22) && bit(c1, 28) && bit(c1, 29)
+                   && bit(b7, 3) && bit(b7, 5) && bit(b7, 8) && bit(c81, 5)
+                   && (xcr0 & 0x06) == 0x06;
+            if (!v3) {
+                return level::x86_64_v2;
+            }
+            bool v4 = bit(b7, 16) && bit(b7, 17) && bit(b7, 28) && bit(b7, 30) && bit(b7, 31)
+                   && (xcr0 & 0xe6) == 0xe6;
+            return v4 ? level::x86_64_v4 : level::x86_64_v3;
+#else
+            return level::baseline;
+#endif
+        }
+
+        export inline auto name(level $1) -> char const* {
+            switch ($1) {
+                case level::baseline: return "baseline";
+                case level::x86_64_v2: return "x86-64-v2";
+                case level::x86_64_v3: return "x86-64-v3";
+                case level::x86_64_v4: return "x86-64-v4";
+            }
+            return "baseline";
+        }
+
+        // the table of the highest built level at or below $1
+        inline auto table(level $1) -> kernels const& {
+            if constexpr (built >= level::x86_64_v4) {
+                if ($1 >= level::x86_64_v4) {
+                    return table<level::x86_64_v4>();
+                }
+            }
+            if constexpr (built >= level::x86_64_v3) {
+                if ($1 >= level::x86_64_v3) {
+                    return table<level::x86_64_v3>();
+                }
+            }
+            if constexpr (built >= level::x86_64_v2) {
+                if ($1 >= level::x86_64_v2) {
+                    return table<level::x86_64_v2>();
+                }
+            }
+            return table<level::baseline>();
+        }
+
+        // MATHEMATICS_ISA=baseline|x86-64-v2|x86-64-v3|x86-64-v4 caps the level; unknown values are ignored
+        inline auto startup() -> level {
+            level cpu = detect();
+            char const* env = std::getenv("MATHEMATICS_ISA");
+            if (env == nullptr) {
+                return cpu;
+            }
+            for (level l : {level::baseline, level::x86_64_v2, level::x86_64_v3, level::x86_64_v4}) {
+                if (std::strcmp(env, name(l)) == 0) {
+                    return l < cpu ? l : cpu;
+                }
+            }
+            return cpu;
+        }
+
+        inline auto state() -> std::atomic<kernels const*>& {
+            static std::atomic<kernels const*> current{&table(startup())};
+            return current;
+        }
+        inline auto active() -> kernels const& {
+            return *state().load(std::memory_order_relaxed);
+        }
+
+        // the level the kernels run at, which is also capped by the copies that were built
+        export inline auto current() -> level {
+            return active().isa;
+        }
+        // switches every later call to the highest usable level at or below $1 and returns it
+        export inline auto use(level $1) -> level {
+            level cpu = detect();
+            kernels const& k = table($1 < cpu ? $1 : cpu);
+            state().store(&k, std::memory_order_relaxed);
+            return k.isa;
+        }
+
+        export inline void normalize_all(std::span<vec_t<float, 3> const> $1, std::span<vec_t<float, 3>> $2) {
+            active().normalize3(reinterpret_cast<float const*>($1.data()), reinterpret_cast<float*>($2.data()), $1.size());
+        }
+        export inline void normalize_all(std::span<vec_t<float, 4> const> $1, std::span<vec_t<float, 4>> $2) {
+            active().normalize4(reinterpret_cast<float const*>($1.data()), reinterpret_cast<float*>($2.data()), $1.size());
+        }
+        export inline void transform_points(mat_t<float, 4, 4> const& $1, std::span<vec_t<float, 3> const> $2, std::span<vec_t<float, 3>> $3, store_mode $4 = store_mode::cached) {
+            active().transform_points(reinterpret_cast<float const*>(&$1), reinterpret_cast<float const*>($2.data()), reinterpret_cast<float*>($3.data()), $2.size(), $4 == store_mode::streaming);
+        }
+        export inline void transform_vectors(mat_t<float, 4, 4> const& $1, std::span<vec_t<float, 3> const> $2, std::span<vec_t<float, 3>> $3, store_mode $4 = store_mode::cached) {
+            active().transform_vectors(reinterpret_cast<float const*>(&$1), reinterpret_cast<float const*>($2.data()), reinterpret_cast<float*>($3.data()), $2.size(), $4 == store_mode::streaming);
+        }
+        export inline void transform_homogeneous(mat_t<float, 4, 4> const& $1, std::span<vec_t<float, 4> const> $2, std::span<vec_t<float, 4>> $3, store_mode $4 = store_mode::cached) {
+            active().transform_homogeneous(reinterpret_cast<float const*>(&$1), reinterpret_cast<float const*>($2.data()), reinterpret_cast<float*>($3.data()), $2.size(), $4 == store_mode::streaming);
+        }
+        export inline void rotate(std::span<quat_t<float> const> $1, std::span<vec_t<float, 3> const> $2, std::span<vec_t<float, 3>> $3) {
+            active().rotate(reinterpret_cast<float const*>($1.data()), reinterpret_cast<float const*>($2.data()), reinterpret_cast<float*>($3.data()), $1.size());
+        }
+        export inline void slerp(std::span<quat_t<float> const> $1, std::span<quat_t<float> const> $2, float $3, std::span<quat_t<float>> $4) {
+            active().slerp(reinterpret_cast<float const*>($1.data()), reinterpret_cast<float const*>($2.data()), $3, reinterpret_cast<float*>($4.data()), $1.size());
+        }
+        export inline void sin(std::span<float const> $1, std::span<float> $2) {
+            active().sin($1.data(), $2.data(), $1.size());
+        }
+        export inline void cos(std::span<float const> $1, std::span<float> $2) {
+            active().cos($1.data(), $2.data(), $1.size());
+        }
+        export inline void exp2(std::span<float const> $1, std::span<float> $2) {
+            active().exp2($1.data(), $2.data(), $1.size());
+        }
+        export inline void log2(std::span<float const> $1, std::span<float> $2) {
+            active().log2($1.data(), $2.data(), $1.size());
+        }
+        export inline auto sum(std::span<vec_t<float, 3> const> $1, summation $2 = summation::pairwise) -> vec_t<float, 3> {
+            vec_t<float, 3> r;
+            active().sum3(reinterpret_cast<float const*>($1.data()), $1.size(), $2 == summation::kahan, r.__fields);
+            return r;
+        }
+        export inline auto bounds(std::span<vec_t<float, 3> const> $1) -> bounds_t<float, 3> {
+            float r[6];
+            active().bounds3(reinterpret_cast<float const*>($1.data()), $1.size(), r);
+            return bounds_t<float, 3>{vec_t<float, 3>{r[0], r[1], r[2]}, vec_t<float, 3>{r[3], r[4], r[5]}};
+        }
+    }
+
+    export using i8vec2 = math::vec_t<int8_t, 2>;
+    export using i8vec3 = math::vec_t<int8_t, 3>;
+    export using i8vec4 = math::vec_t<int8_t, 4>;
+    export using i16vec2 = math::vec_t<int16_t, 2>;
+    export using i16vec3 = math::vec_t<int16_t, 3>;
+    export using i16vec4 = math::vec_t<int16_t, 4>;
+    export using i32vec2 = math::vec_t<int32_t, 2>;
+    export using i32vec3 = math::vec_t<int32_t, 3>;
+    export using i32vec4 = math::vec_t<int32_t, 4>;
+    export using i64vec2 = math::vec_t<int64_t, 2>;
+    export using i64vec3 = math::vec_t<int64_t, 3>;
+    export using i64vec4 = math::vec_t<int64_t, 4>;
+
+    export using u8vec2 = math::vec_t<uint8_t, 2>;
+    export using u8vec3 = math::vec_t<uint8_t, 3>;
+    export using u8vec4 = math::vec_t<uint8_t, 4>;
+    export using u16vec2 = math::vec_t<uint16_t, 2>;
+    export using u16vec3 = math::vec_t<uint16_t, 3>;
+    export using u16vec4 = math::vec_t<uint16_t, 4>;
+    export using u32vec2 = math::vec_t<uint32_t, 2>;
+    export using u32vec3 = math::vec_t<uint32_t, 3>;
+    export using u32vec4 = math::vec_t<uint32_t, 4>;
+    export using u64vec2 = math::vec_t<uint64_t, 2>;
+    export using u64vec3 = math::vec_t<uint64_t, 3>;
+    export using u64vec4 = math::vec_t<uint64_t, 4>;
+
+    export using f32vec2 = math::vec_t<float_t, 2>;
+    export using f32vec3 = math::vec_t<float_t, 3>;
+    export using f32vec4 = math::vec_t<float_t, 4>;
     export using f64vec2 = math::vec_t<double_t, 2>;
     export using f64vec3 = math::vec_t<double_t, 3>;
     export using f64vec4 = math::vec_t<double_t, 4>;
 
+    export using f16vec2 = math::packed_t<math::format::f16, 2>;
+    export using f16vec3 = math::packed_t<math::format::f16, 3>;
+    export using f16vec4 = math::packed_t<math::format::f16, 4>;
+
+    export using snorm16vec2 = math::packed_t<math::format::snorm16, 2>;
+    export using snorm16vec3 = math::packed_t<math::format::snorm16, 3>;
+    export using snorm16vec4 = math::packed_t<math::format::snorm16, 4>;
+
+    export using unorm8vec2 = math::packed_t<math::format::unorm8, 2>;
+    export using unorm8vec3 = math::packed_t<math::format::unorm8, 3>;
+    export using unorm8vec4 = math::packed_t<math::format::unorm8, 4>;
+
+    export using unorm1010102 = math::packed32_t<math::format::unorm10_10_10_2>;
+    export using snorm1010102 = math::packed32_t<math::format::snorm10_10_10_2>;
+
     export using f32mat2x2 = math::mat_t<float_t, 2, 2>;
     export using f32mat3x3 = math::mat_t<float_t, 3, 3>;
     export using f32mat4x4 = math::mat_t<float_t, 4, 4>;
@@ -968,10 +8015,26 @@ namespace math {
     export using f64mat2x2 = math::mat_t<double_t, 2, 2>;
     export using f64mat3x3 = math::mat_t<double_t, 3, 3>;
     export using f64mat4x4 = math::mat_t<double_t, 4, 4>;
+
+    export using f32quat = math::quat_t<float_t>;
+    export using f64quat = math::quat_t<double_t>;
+
+    export using f32affine = math::affine_t<float_t>;
+    export using f64affine = math::affine_t<double_t>;
+
+    export using f32frustum = math::frustum_t<float_t>;
+    export using f64frustum = math::frustum_t<double_t>;
 }
 
-#undef DEFINE_COMPONENT
-#undef DEFINE_SWIZZLE_2
-#undef DEFINE_SWIZZLE_3
-#undef DEFINE_SWIZZLE_4
-#undef DEFINE_PROPERTIES
\ No newline at end of file
+// integer vectors as keys of std::unordered_map and friends
+template<std::integral T, size_t Len>
+struct std::hash<math::vec_t<T, Len>> : math::vec_hash {};
+
+#undef DEFINE_ACCESSOR
+#undef DEFINE_PROPERTY
+#undef DEFINE_SWIZZLE
+#undef DEFINE_SWIZZLE_ALIAS
+#undef DEFINE_PROPERTIES_1
+#undef DEFINE_PROPERTIES_2
+#undef DEFINE_PROPERTIES_3
+#undef DEFINE_PROPERTIES_4
\ No newline at end of file
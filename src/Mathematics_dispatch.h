@@ -0,0 +1,45 @@
+//
+// Created by Maksym Pasichnyk on 01.06.2024.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// The table math::dispatch switches between. The module and every per-level kernel object
+// (src/Mathematics_kernels.cxx) include this outside any module, so they all name the same types.
+namespace math::dispatch {
+    // x86-64 psABI microarchitecture levels
+    enum class level : uint8_t {
+        baseline = 1,   // the main module, at whatever flags it was compiled with
+        x86_64_v2 = 2,  // SSE4.2, POPCNT
+        x86_64_v3 = 3,  // AVX2, FMA, F16C, BMI2
+        x86_64_v4 = 4,  // AVX-512 F/BW/CD/DQ/VL
+    };
+
+    // raw floats, since vec_t is a different type in every kernel object; $5 of the transforms selects streaming stores
+    struct kernels {
+        level isa;
+        void (*normalize3)(float const*, float*, size_t);
+        void (*normalize4)(float const*, float*, size_t);
+        void (*transform_points)(float const*, float const*, float*, size_t, bool);
+        void (*transform_vectors)(float const*, float const*, float*, size_t, bool);
+        void (*transform_homogeneous)(float const*, float const*, float*, size_t, bool);
+        void (*rotate)(float const*, float const*, float*, size_t);
+        void (*slerp)(float const*, float const*, float, float*, size_t);
+        void (*sin)(float const*, float*, size_t);
+        void (*cos)(float const*, float*, size_t);
+        void (*exp2)(float const*, float*, size_t);
+        void (*log2)(float const*, float*, size_t);
+        void (*sum3)(float const*, size_t, bool, float*);
+        void (*bounds3)(float const*, size_t, float*);
+    };
+
+    // defined by the module for baseline and by one kernel object per built level
+    template<level L>
+    auto table() -> kernels const&;
+    template<> auto table<level::baseline>() -> kernels const&;
+    template<> auto table<level::x86_64_v2>() -> kernels const&;
+    template<> auto table<level::x86_64_v3>() -> kernels const&;
+    template<> auto table<level::x86_64_v4>() -> kernels const&;
+}
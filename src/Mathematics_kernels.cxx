@@ -0,0 +1,23 @@
+//
+// Created by Maksym Pasichnyk on 01.06.2024.
+//
+// The math::dispatch table of one x86-64 level. CMake compiles this file once per level with
+// -march=x86-64-v<level> and MATHEMATICS_DISPATCH_LEVEL=<level>, around the copy of the library that
+// cmake/KernelCopy.cmake writes. The copy sits in an unnamed namespace, so every function and template
+// instantiation built for that ISA has internal linkage: none of them can stand in for the baseline
+// definition of an inline function at link time. Only math::dispatch::table<level> is exported.
+#include "Mathematics_headers.inc"
+
+namespace math_kernels {
+    namespace {
+#include "Mathematics_library.inc"
+    }
+}
+
+namespace math::dispatch {
+    template<>
+    auto table<level(MATHEMATICS_DISPATCH_LEVEL)>() -> kernels const& {
+        static constexpr kernels k = math_kernels::math::dispatch::kernels_impl::table(level(MATHEMATICS_DISPATCH_LEVEL));
+        return k;
+    }
+}